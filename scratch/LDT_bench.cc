@@ -0,0 +1,377 @@
+/*
+ * Lunar DT benchmark suite
+ *
+ * Generates synthetic NODECONFIGHEADER scenarios of the requested sizes and
+ * times the processing stages on each, plus one link simulation and one CI
+ * LTE run. Results are written as one JSON document, with run metadata and
+ * a "results" array, and, given a previous results file as --baseline,
+ * compared against it. --baseline only reads files written by LDT_bench
+ * itself: it expects each result object on its own line, as written here,
+ * and is not a general JSON parser.
+ *
+ *   ./ns3 run "LDT_bench --sizes=10,1000,100000"
+ *   ./ns3 run "LDT_bench --sizes=10,1000,100000 --baseline=scratch/output/bench/baseline.json"
+ *
+ * With --profile the per-phase breakdown of every stage is also written to
+ * <workDir>/profile.json. The trace_* stages time one binary trace call
+ * with its category off and on.
+ */
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "../scratch_helpers/profiler.cc"
+#include "../scratch_helpers/binaryTrace.cc"
+#include "../scratch_helpers/cachingPropagationLoss.cc"
+#include "../scratch_helpers/terrain.cc"
+#include "../scratch_helpers/terrainPropagationLoss.cc"
+#include "../scratch_helpers/lunarTransmissionSim.cc"
+#include "../scratch_helpers/phyAbstraction.cc"
+#include "../scratch_helpers/netAnimWriter.cc"
+#include "../scratch_helpers/lunarNodeMapGenerator.cc"
+#include "../scratch_helpers/kdTree.cc"
+#include "../scratch_helpers/lunar_dt_CI.cc"
+#include "../scratch_helpers/routingGraph.cc"
+#include "../scratch_helpers/optimalPathFinder.cc"
+#include "../scratch_helpers/scenarioParser.cc"
+#include "../scratch_helpers/scenarioCache.cc"
+#include "../scratch_helpers/linkResultCache.cc"
+#include "../scratch_helpers/scenarioGenerator.cc"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct BenchResult {
+    string name;
+    uint64_t size{};     // scenario nodes (0 = fixed workload)
+    uint64_t ops{1};     // operations timed, for the per-op figure
+    double ms{};         // best of the repeats
+    double medianMs{};
+    uint32_t repeats{1};
+    double baselineMs{-1.0};
+};
+
+static double elapsedMs(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// Best and median wall time of fn() over repeats runs
+template <typename Fn>
+static BenchResult timeIt(const string &name, uint64_t size, uint64_t ops, uint32_t repeats, Fn fn) {
+    vector<double> times;
+    for (uint32_t r = 0; r < max(repeats, 1u); ++r) {
+        auto t0 = chrono::steady_clock::now();
+        fn();
+        times.push_back(elapsedMs(t0));
+    }
+    sort(times.begin(), times.end());
+    BenchResult result;
+    result.name = name;
+    result.size = size;
+    result.ops = ops;
+    result.ms = times.front();
+    result.medianMs = times[times.size() / 2];
+    result.repeats = static_cast<uint32_t>(times.size());
+    cout << "[BENCH] " << name << " (" << size << " nodes): " << result.ms << " ms" << endl;
+    return result;
+}
+
+static long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// ---------------------------------------------------------------------
+// Baseline: a results file written by an earlier run. writeJson() puts
+// every result object on a line of its own with "key": value spacing;
+// the fields are read back from those lines, so files reformatted by
+// other tools are not understood.
+// ---------------------------------------------------------------------
+static string jsonField(const string &line, const string &key) {
+    string tag = "\"" + key + "\": ";
+    size_t at = line.find(tag);
+    if (at == string::npos) return "";
+    at += tag.size();
+    if (line[at] == '"') {
+        size_t end = line.find('"', at + 1);
+        return line.substr(at + 1, end - at - 1);
+    }
+    size_t end = line.find_first_of(",}", at);
+    return line.substr(at, end - at);
+}
+
+static void applyBaseline(const string &path, vector<BenchResult> &results) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        cerr << "[WARNING] Baseline " << path << " not found; no comparison.\n";
+        return;
+    }
+    string line;
+    size_t matched = 0;
+    while (getline(in, line)) {
+        string name = jsonField(line, "name");
+        string size = jsonField(line, "size");
+        string ms = jsonField(line, "ms");
+        if (name.empty() || size.empty() || ms.empty()) continue;
+        for (BenchResult &r : results) {
+            if (r.name == name && to_string(r.size) == size) {
+                r.baselineMs = stod(ms);
+                ++matched;
+            }
+        }
+    }
+    cout << "[INFO] Baseline " << path << ": " << matched << " matching results.\n";
+}
+
+static bool writeJson(const string &path, const vector<BenchResult> &results, const string &args) {
+    fs::path p(path);
+    if (p.has_parent_path()) fs::create_directories(p.parent_path());
+    ofstream out(path);
+    if (!out.is_open()) return false;
+
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    auto now = chrono::system_clock::to_time_t(chrono::system_clock::now());
+    out << "{\n  \"host\": \"" << host << "\",\n"
+        << "  \"cores\": " << thread::hardware_concurrency() << ",\n"
+        << "  \"timestamp\": " << now << ",\n"
+        << "  \"args\": \"" << args << "\",\n"
+        << "  \"peak_rss_kb\": " << peakRssKb() << ",\n"
+        << "  \"results\": [\n";
+    out << setprecision(6);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"ops\": " << r.ops
+            << ", \"ms\": " << r.ms << ", \"median_ms\": " << r.medianMs << ", \"repeats\": " << r.repeats;
+        if (r.baselineMs >= 0.0) out << ", \"baseline_ms\": " << r.baselineMs;
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+// ---------------------------------------------------------------------
+// Per-size stages
+// ---------------------------------------------------------------------
+static void benchScenario(uint32_t size, const SyntheticScenarioParams &base, uint32_t repeats,
+                          uint32_t queries, const string &workDir, vector<BenchResult> &results) {
+    SyntheticScenarioParams params = base;
+    params.nodes = size;
+    string path = workDir + "/synthetic_" + to_string(size) + ".txt";
+
+    results.push_back(timeIt("generate", size, size, 1, [&]() {
+        if (!WriteSyntheticScenario(path, params)) cerr << "[ERROR] Could not write " << path << '\n';
+    }));
+
+    Scenario scenario;
+    results.push_back(timeIt("parse", size, size, repeats, [&]() { LoadScenario(path, scenario); }));
+
+    fs::remove(path + ".ldtc");
+    results.push_back(timeIt("cache_build", size, size, 1, [&]() {
+        Scenario s;
+        LoadScenarioCached(path, s);
+    }));
+    results.push_back(timeIt("cache_load", size, size, repeats, [&]() {
+        CompiledScenario compiled;
+        if (compiled.open(path + ".ldtc") && compiled.matchesSource(path, path + ".ldtc")) {
+            Scenario s;
+            compiled.toScenario(path, s);
+        }
+    }));
+
+    RoutingGraph graph;
+    results.push_back(timeIt("graph_build", size, size, repeats, [&]() { graph = BuildScenarioGraph(scenario); }));
+
+    // The same random node pairs for every stage and run
+    mt19937_64 rng(params.seed);
+    vector<pair<uint32_t, uint32_t>> pairs(queries);
+    for (auto &q : pairs)
+        q = {static_cast<uint32_t>(rng() % graph.nodeCount()), static_cast<uint32_t>(rng() % graph.nodeCount())};
+
+    unordered_map<string, NodePosition> positions;
+    unordered_map<string, vector<string>> adjacency;
+    for (const NodeConfig &c : scenario.nodes) {
+        positions[c.name] = {c.x, c.y, c.z};
+        adjacency[c.name] = c.links;
+    }
+    // findOptimalPath() rebuilds the graph per call; a few calls suffice on large scenarios
+    size_t legacyQueries = size > 100000 ? min<size_t>(pairs.size(), 3) : pairs.size();
+    results.push_back(timeIt("find_optimal_path", size, legacyQueries, 1, [&]() {
+        for (size_t k = 0; k < legacyQueries; ++k)
+            findOptimalPath(positions, adjacency, string(graph.names[pairs[k].first]),
+                            string(graph.names[pairs[k].second]));
+    }));
+    results.push_back(timeIt("route_dijkstra", size, queries, repeats, [&]() {
+        SearchWorkspace ws;
+        PathResult route;
+        for (const auto &q : pairs) FindRoute(graph, graph.weights, q.first, q.second, SearchMode::Dijkstra, ws, route);
+    }));
+
+    // UE -> nearest eNB association as done by AssociateUes()
+    vector<double> ex, ey, ez;
+    vector<const NodeConfig *> ues;
+    for (const NodeConfig &c : scenario.nodes) {
+        if (c.type.find("gNB") != string::npos) {
+            ex.push_back(c.x);
+            ey.push_back(c.y);
+            ez.push_back(c.z);
+        } else if (c.type.find("User Equipment") != string::npos) {
+            ues.push_back(&c);
+        }
+    }
+    if (!ex.empty()) {
+        results.push_back(timeIt("nearest_enb", size, ues.size(), repeats, [&]() {
+            KdTree tree;
+            tree.build(ex, ey, ez);
+            vector<KdNeighbor> nearest;
+            for (const NodeConfig *ue : ues) tree.nearest(ue->x, ue->y, ue->z, 1, nearest);
+        }));
+    }
+
+    results.push_back(timeIt("node_map_xml", size, size, 1, [&]() {
+        generateNodeMapXML(scenario.nodes, workDir + "/synthetic_" + to_string(size) + ".xml");
+    }));
+    cout << "[INFO] Peak RSS after " << size << " nodes: " << peakRssKb() / 1024 << " MB\n";
+}
+
+int main(int argc, char *argv[]) {
+    string sizes = "10,1000,10000,100000";
+    SyntheticScenarioParams params;
+    uint32_t repeats = 3;
+    uint32_t queries = 20;
+    bool simulations = true;
+    uint32_t ciEnb = 16;
+    uint32_t ciUe = 200;
+    string workDir = "./scratch/output/bench";
+    string output;
+    string baseline;
+    double tolerance = 0.10;
+    bool profile = false;
+
+    CommandLine cmd;
+    cmd.AddValue("sizes", "Comma-separated scenario sizes (nodes), 10 .. 1000000", sizes);
+    cmd.AddValue("density", "Nodes per km²", params.density);
+    cmd.AddValue("degree", "Linked nodes per node", params.degree);
+    cmd.AddValue("enbFraction", "Share of base stations", params.enbFraction);
+    cmd.AddValue("seed", "Generator and query seed", params.seed);
+    cmd.AddValue("repeats", "Runs per micro benchmark (best is reported)", repeats);
+    cmd.AddValue("queries", "Route queries per size", queries);
+    cmd.AddValue("simulations", "Also time simulateTransmission() and runLunarDtCI()", simulations);
+    cmd.AddValue("ciEnb", "eNBs in the CI benchmark run", ciEnb);
+    cmd.AddValue("ciUe", "UEs in the CI benchmark run", ciUe);
+    cmd.AddValue("workDir", "Directory for generated scenarios and maps", workDir);
+    cmd.AddValue("output", "Results file (default <workDir>/results.json)", output);
+    cmd.AddValue("baseline", "Earlier results file to compare against", baseline);
+    cmd.AddValue("tolerance", "Relative slowdown reported as a regression", tolerance);
+    cmd.AddValue("profile", "Write the phase profile to <workDir>/profile.json", profile);
+    cmd.Parse(argc, argv);
+    SetProfilingEnabled(profile || ProfilingFromEnvironment());
+    if (TraceFromEnvironment())
+        cout << "[INFO] Binary trace enabled (LdtTrace); the trace_* stages are skipped.\n";
+    if (output.empty()) output = workDir + "/results.json";
+    fs::create_directories(workDir);
+
+    vector<BenchResult> results;
+    stringstream list(sizes);
+    string item;
+    while (getline(list, item, ',')) {
+        if (item.empty()) continue;
+        uint32_t size = static_cast<uint32_t>(stoul(item));
+        if (size < 2) continue;
+        cout << "\n=== Scenario with " << size << " nodes ===\n";
+        benchScenario(size, params, repeats, queries, workDir, results);
+    }
+
+    // Cost of one trace call with its category off and on; the ring is
+    // sized so the writer keeps up and nothing is dropped
+    if (!TraceActive()) {
+        cout << "\n=== Tracing ===\n";
+        const uint64_t records = 1000000;
+        results.push_back(timeIt("trace_disabled", 0, records, repeats, [&]() {
+            for (uint64_t i = 0; i < records; ++i) TraceEchoTx(1, static_cast<int64_t>(i), 512);
+        }));
+        string tracePath = workDir + "/bench_trace.ldtt";
+        if (StartTrace(tracePath, kTraceEcho, 1 << 20)) {
+            results.push_back(timeIt("trace_enabled", 0, records, 1, [&]() {
+                for (uint64_t i = 0; i < records; ++i) TraceEchoTx(1, static_cast<int64_t>(i), 512);
+            }));
+            TraceSessionStats stats = StopTrace();
+            if (stats.dropped > 0) cout << "[WARNING] " << stats.dropped << " trace records dropped.\n";
+            fs::remove(tracePath);
+        }
+    }
+
+    if (simulations) {
+        cout << "\n=== Simulations ===\n";
+        results.push_back(timeIt("simulate_transmission", 0, 1, 1, []() {
+            simulateTransmission(1000.0, 2400.0, 30.0, "10Mbps");
+        }));
+        PhyTables tables;
+        EnsurePhyTables(kPhyTablesPath, tables);
+        results.push_back(timeIt("transmission_table", 0, 1000, 1, [&]() {
+            for (int i = 0; i < 1000; ++i) SimulateTransmissionTable(tables, 1000.0, 2400.0, 30.0, "10Mbps");
+        }));
+
+        string conf = workDir + "/bench_ci.conf";
+        ofstream(conf) << "numEnb = " << ciEnb << "\nnumUe = " << ciUe << "\nanimFile = none\n";
+        string confArg = "--conf=" + conf;
+        results.push_back(timeIt("lunar_dt_ci", ciEnb + ciUe, 1, 1, [&]() {
+            const char *ciArgv[] = {"lunar_dt_CI", confArg.c_str()};
+            runLunarDtCI(2, const_cast<char **>(ciArgv));
+        }));
+    }
+
+    if (!baseline.empty()) applyBaseline(baseline, results);
+
+    cout << "\n=== Benchmark Results ===\n"
+         << left << setw(22) << "stage" << right << setw(9) << "nodes" << setw(12) << "ms"
+         << setw(12) << "us/op" << setw(12) << "baseline" << setw(9) << "change" << '\n';
+    size_t regressions = 0;
+    for (const BenchResult &r : results) {
+        cout << left << setw(22) << r.name << right << setw(9) << r.size << fixed << setprecision(3)
+             << setw(12) << r.ms << setw(12) << 1000.0 * r.ms / max<uint64_t>(r.ops, 1);
+        if (r.baselineMs > 0.0) {
+            double change = r.ms / r.baselineMs - 1.0;
+            cout << setw(12) << r.baselineMs << setw(8) << setprecision(1) << showpos << 100.0 * change << "%"
+                 << noshowpos;
+            if (change > tolerance) {
+                cout << "  REGRESSION";
+                ++regressions;
+            }
+        }
+        cout << defaultfloat << '\n';
+    }
+
+    string args;
+    for (int i = 1; i < argc; ++i) args += (i > 1 ? " " : "") + string(argv[i]);
+    replace(args.begin(), args.end(), '"', '\'');
+    if (!writeJson(output, results, args)) {
+        cerr << "[ERROR] Could not write " << output << '\n';
+        return 1;
+    }
+    cout << "\n[INFO] Results written to " << output << " (peak RSS " << peakRssKb() / 1024 << " MB)\n";
+    if (ProfilingEnabled()) {
+        string profilePath = workDir + "/profile.json";
+        if (WriteProfileReport(profilePath)) cout << "[INFO] Phase profile written to " << profilePath << '\n';
+        else cerr << "[ERROR] Could not write " << profilePath << '\n';
+    }
+    if (TraceActive()) {
+        TraceSessionStats stats = StopTrace();
+        cout << "[INFO] Trace written to " << stats.path << " (" << stats.written << " records)\n";
+    }
+    if (regressions > 0) {
+        cout << "[WARNING] " << regressions << " stage(s) slower than the baseline by more than "
+             << 100.0 * tolerance << "%.\n";
+        return 2;
+    }
+    return 0;
+}
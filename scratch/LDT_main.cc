@@ -6,10 +6,35 @@
 #include <iomanip>
 #include <filesystem>
 #include <vector>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include "../scratch_helpers/profiler.cc"
+#include "../scratch_helpers/binaryTrace.cc"
+#include "../scratch_helpers/cachingPropagationLoss.cc"
+#include "../scratch_helpers/terrain.cc"
+#include "../scratch_helpers/terrainPropagationLoss.cc"
 #include "../scratch_helpers/lunarTransmissionSim.cc"
+#include "../scratch_helpers/phyAbstraction.cc"
+#include "../scratch_helpers/netAnimWriter.cc"
 #include "../scratch_helpers/lunarNodeMapGenerator.cc"
+#include "../scratch_helpers/kdTree.cc"
 #include "../scratch_helpers/lunar_dt_CI.cc"
+#include "../scratch_helpers/contactPlan.cc"
+#include "../scratch_helpers/contactPlanSim.cc"
+#include "../scratch_helpers/routingGraph.cc"
 #include "../scratch_helpers/optimalPathFinder.cc"
+#include "../scratch_helpers/contractionHierarchy.cc"
+#include "../scratch_helpers/dynamicRouting.cc"
+#include "../scratch_helpers/linkCostTable.cc"
+#include "../scratch_helpers/workerPool.cc"
+#include "../scratch_helpers/linkBudget.cc"
+#include "../scratch_helpers/scenarioParser.cc"
+#include "../scratch_helpers/scenarioCache.cc"
+#include "../scratch_helpers/linkResultCache.cc"
+#include "../scratch_helpers/parameterSweep.cc"
+#include "../scratch_helpers/replication.cc"
 #include "../scratch_helpers/LDT_shared.h"
 
 using namespace std;
@@ -19,16 +44,33 @@ namespace fs = std::filesystem;
 void displayMenu();
 void startSimulation();
 void startLunarCISimulation();
+void startParameterSweep();
+void startContactPlanSimulation();
 void startOptimalPathFinder();
 void startMappingSoftware();
+void startLinkBudgetMatrix();
+void startBatchRouteQueries();
 void browseConfigurationFile();
-extern void simulateTransmission(double distance, double freqMHz, double txPowerdBm, std::string rate);
+void toggleProfiling();
+void toggleTracing();
+extern LinkResult simulateTransmission(double distance, double freqMHz, double txPowerdBm, std::string rate);
+extern uint32_t traceLinkStart(const LinkJob& link);
+extern std::vector<LinkResult> simulateScenario(const std::vector<NodeConfig>& configs, const std::vector<LinkJob>& links);
 extern void generateNodeMapXML(const std::vector<NodeConfig>& nodes, const std::string& outputPath);
-extern int runLunarDtCI(int argc, char* argv[]);
+extern int runLunarDtCI(int argc, char* argv[], CiResult* result);
+extern int runContactPlanSimulation(int argc, char* argv[]);
+
+static const char *kProfileReport = "./scratch/output/ldt_profile.json";
 
 int main() {
     char userInput = '\0';
 
+    if (ProfilingFromEnvironment())
+        cout << "[INFO] Phase profiling enabled (LdtProfile); report: " << kProfileReport << "\n";
+    if (TraceFromEnvironment())
+        cout << "[INFO] Binary trace enabled (LdtTrace=" << TraceCategoryNames(g_traceMask.load()) << "); file: "
+             << TraceFileSetting() << "\n";
+
     while (true) {
         displayMenu();
         cout << "Enter choice: ";
@@ -46,6 +88,16 @@ int main() {
 				startLunarCISimulation();
 				break;
 
+            case 'w':
+                cout << "\n[INFO] Starting CI Parameter Sweep...\n";
+                startParameterSweep();
+                break;
+
+            case 'k':
+                cout << "\n[INFO] Starting Contact Plan Simulation...\n";
+                startContactPlanSimulation();
+                break;
+
             case 'p':
                 cout << "\n[INFO] Starting Optimal Path Finder...\n";
                 startOptimalPathFinder();
@@ -56,12 +108,32 @@ int main() {
                 startMappingSoftware();
                 break;
 
+            case 'r':
+                cout << "\n[INFO] Starting Batch Route Queries...\n";
+                startBatchRouteQueries();
+                break;
+
+            case 'l':
+                cout << "\n[INFO] Starting Link Budget Analysis...\n";
+                startLinkBudgetMatrix();
+                break;
+
             case 'b':
                 cout << "\n[INFO] Opening Configuration File Browser...\n";
                 browseConfigurationFile();
                 break;
 
+            case 't':
+                toggleProfiling();
+                break;
+
+            case 'x':
+                toggleTracing();
+                break;
+
             case 'q':
+                if (ProfilingEnabled()) toggleProfiling();
+                if (TraceActive()) toggleTracing();
                 cout << "\n[INFO] Exiting program.\n";
                 return 0;
 
@@ -82,139 +154,254 @@ void displayMenu() {
     cout << "\n=== Main Menu ===\n";
     cout << " [S] Start Simulation\n";
 	cout << " [C] Run Lunar CI LTE Simulation\n";
+    cout << " [W] CI Parameter Sweep\n";
+    cout << " [K] Contact Plan Simulation (moving nodes)\n";
     cout << " [P] Find Optimal Path\n";
+    cout << " [R] Batch Route Queries\n";
 	cout << " [D] Display Node Map\n";
+    cout << " [L] Link Budget / Feasibility Matrix\n";
     cout << " [B] Browse Configuration File\n";
+    cout << " [T] Toggle Phase Profiling (" << (ProfilingEnabled() ? "on" : "off") << ")\n";
+    cout << " [X] Toggle Binary Trace ("
+         << (TraceActive() ? TraceCategoryNames(g_traceMask.load()) : string("off")) << ")\n";
     cout << " [Q] Quit\n";
 }
 
-void startSimulation() {
-    string configDir = "./scratch/config";
-    vector<fs::path> configFiles;
+// Turning profiling off writes the phases collected since it was turned on
+void toggleProfiling() {
+    if (!ProfilingEnabled()) {
+        ResetProfile();
+        SetProfilingEnabled(true);
+        cout << "\n[INFO] Phase profiling on. Toggle again to write " << kProfileReport << "\n";
+        return;
+    }
+    SetProfilingEnabled(false);
+    if (WriteProfileReport(kProfileReport))
+        cout << "\n[INFO] Phase profile written to " << kProfileReport << "\n";
+    else
+        cerr << "\n[ERROR] Could not write " << kProfileReport << "\n";
+    ResetProfile();
+}
 
-    cout << "\n=== Simulation Configuration Selector ===\n";
+// Turning the trace off closes the file; LDT_trace turns it into text/CSV
+void toggleTracing() {
+    if (!TraceActive()) {
+        string list;
+        cout << "Trace categories [link,echo,ci,contact or all]: ";
+        cin >> list;
+        uint32_t mask;
+        if (!ParseTraceCategories(list, mask) || mask == 0) {
+            cerr << "[ERROR] Unknown trace category.\n";
+            return;
+        }
+        if (StartTrace(TraceFileSetting(), mask))
+            cout << "\n[INFO] Binary trace on (" << TraceCategoryNames(mask) << "). Toggle again to close "
+                 << TraceFileSetting() << "\n";
+        return;
+    }
+    TraceSessionStats stats = StopTrace();
+    cout << "\n[INFO] Trace written to " << stats.path << ": " << stats.written << " records";
+    if (stats.dropped > 0) cout << ", " << stats.dropped << " dropped (ring full)";
+    cout << "\n[INFO] Decode with: ./ns3 run \"LDT_trace --input=" << stats.path << "\"\n";
+}
+
+// Load a scenario file through its compiled cache (<file>.ldtc), which is
+// written on first use and rebuilt whenever the text changes
+static bool loadScenario(const string &filename, Scenario &scenario, RoutingGraph *graph = nullptr) {
+    bool rebuilt = false;
+    auto t0 = chrono::steady_clock::now();
+    if (!LoadScenarioCached(filename, scenario, graph, &rebuilt)) return false;
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "[INFO] " << (rebuilt ? "Parsed and compiled " : "Loaded compiled ") << filename
+         << " (" << scenario.nodes.size() << " nodes, " << ms << " ms)\n";
+    return true;
+}
 
+// Radio link-cost tables kept per config file, so choosing a scenario again
+// only re-evaluates links whose endpoints or radio parameters changed
+static unordered_map<string, LinkCostTable> linkCostCache;
+
+// Ask whether routes should minimise distance or radio link cost. In the
+// latter case graph.weights is replaced with per-link latency estimates and,
+// if radiosOut is given, it receives the per-node radio parameters.
+static bool chooseEdgeWeights(const Scenario &scenario, RoutingGraph &graph, bool &radioCost,
+                              vector<RadioProfile> *radiosOut = nullptr) {
+    char mode = 0;
+    cout << "\nEdge weights: [D] distance  [R] radio link cost: ";
+    if (!(cin >> mode)) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+    mode = static_cast<char>(tolower(mode));
+    if (mode != 'd' && mode != 'r') {
+        cerr << "[ERROR] Invalid mode.\n";
+        return false;
+    }
+    radioCost = mode == 'r';
+    if (!radioCost) return true;
+
+    vector<RadioProfile> radios(graph.nodeCount());
+    for (uint32_t i = 0; i < graph.nodeCount(); ++i) {
+        radios[i].position = graph.positions[i];
+        const NodeConfig *c = scenario.find(std::string(graph.names[i]));
+        if (!c) continue;
+        radios[i].freqMHz = c->freqMHz;
+        radios[i].txPowerDbm = c->txPowerBm;
+        radios[i].txRateBps = ParseDataRateBps(c->txRate);
+        radios[i].rxRateBps = ParseDataRateBps(c->rxRate);
+    }
+
+    LinkCostTable &table = linkCostCache[scenario.source];
+    size_t evaluated = table.update(graph, radios);
+    cout << "[INFO] Radio link costs: " << evaluated << " of " << graph.edgeCount()
+         << " links evaluated (" << graph.edgeCount() - evaluated << " reused from cache).\n";
+    graph.weights = table.costs();
+    if (radiosOut) *radiosOut = std::move(radios);
+    return true;
+}
+
+static string trimmedName(const string &s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == string::npos) return "";
+    return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+// Node name typed at a prompt: the rest of the line, trimmed, so names
+// with spaces ("Rover A") can be entered
+static string readNodeName(const string &prompt) {
+    string line;
+    cout << prompt;
+    if (!getline(cin >> ws, line)) {
+        cin.clear();
+        return "";
+    }
+    return trimmedName(line);
+}
+
+// One line of a route query file: "start,goal", with both names trimmed,
+// or two names separated by blanks. Double quotes keep a name with spaces
+// (or commas) together: "Rover A" Base. False unless there are exactly two
+// non-empty names.
+static bool parseQueryLine(const string &line, string &start, string &goal) {
+    bool quoted = false, commas = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        else if (c == ',' && !quoted) commas = true;
+    }
+    if (quoted) return false;
+
+    vector<string> names(1);
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            continue;
+        }
+        bool separator = !quoted && (commas ? c == ',' : isspace(static_cast<unsigned char>(c)) != 0);
+        if (!separator) names.back() += c;
+        else if (commas || !names.back().empty()) names.emplace_back();
+    }
+    if (!commas && names.back().empty()) names.pop_back();
+    if (names.size() != 2) return false;
+    start = commas ? trimmedName(names[0]) : names[0];
+    goal = commas ? trimmedName(names[1]) : names[1];
+    return !start.empty() && !goal.empty();
+}
+
+// CSV field, quoted when it holds a comma or a quote
+static string csvField(const string &s) {
+    if (s.find_first_of(",\"") == string::npos) return s;
+    string quoted = "\"";
+    for (char c : s) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+// List the files with the given extension in configDir and let the user pick one.
+// Returns an empty string if nothing was selected.
+static string chooseConfigFile(const string &configDir, const string &extension, const string &prompt) {
     if (!fs::exists(configDir) || !fs::is_directory(configDir)) {
         cerr << "[ERROR] Directory '" << configDir << "' not found.\n";
-        return;
+        return "";
     }
 
+    vector<fs::path> configFiles;
     int index = 1;
     for (const auto &entry : fs::directory_iterator(configDir)) {
-        if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+        if (entry.is_regular_file() && entry.path().extension() == extension) {
             cout << "  [" << index++ << "] " << entry.path().filename().string() << '\n';
             configFiles.push_back(entry.path());
         }
     }
-
     if (configFiles.empty()) {
         cerr << "[ERROR] No configuration files found.\n";
-        return;
+        return "";
     }
 
     int choice;
-    cout << "\nSelect a file number to simulate: ";
+    cout << "\n" << prompt;
     if (!(cin >> choice) || choice < 1 || choice > (int)configFiles.size()) {
         cin.clear();
         cin.ignore(numeric_limits<streamsize>::max(), '\n');
         cerr << "[ERROR] Invalid choice.\n";
-        return;
+        return "";
     }
     cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    return configFiles[choice - 1].string();
+}
 
-    string filename = configFiles[choice - 1].string();
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "[ERROR] Could not open " << filename << endl;
-        return;
+// Ask for the precision target of a replicated run. Runs use every core
+// and RNG run numbers 1, 2, ...; the first five always run.
+static bool chooseReplicationPolicy(ReplicationPolicy &policy) {
+    double percent;
+    cout << "Target relative CI half-width in % (95% confidence) [e.g. 5]: ";
+    if (!(cin >> percent) || percent <= 0.0) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid precision.\n";
+        return false;
+    }
+    int maxRuns;
+    cout << "Maximum replications: ";
+    if (!(cin >> maxRuns) || maxRuns < 2) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid replication limit.\n";
+        return false;
     }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    policy.relPrecision = percent / 100.0;
+    policy.maxRuns = static_cast<uint32_t>(maxRuns);
+    policy.minRuns = min<uint32_t>(policy.minRuns, policy.maxRuns);
+    policy.workers = DefaultWorkerCount();
+    return true;
+}
+
+void startSimulation() {
+    ScopedPhase phase("simulation");
+    cout << "\n=== Simulation Configuration Selector ===\n";
+    string filename = chooseConfigFile("./scratch/config", ".txt", "Select a file number to simulate: ");
+    if (filename.empty()) return;
 
     cout << "\n[INFO] Reading configuration: " << filename << endl;
 
     // -----------------------------
     // Step 1: Parse node definitions
     // -----------------------------
-    struct NodeConfig {
-        string name;
-        string type;
-        double x, y, z;
-        double freqMHz;
-        double txPowerBm;
-        string txRate;
-        string rxRate;
-        vector<string> links;
-    };
-
-    vector<NodeConfig> nodes;
-    NodeConfig current;
-    string line;
-
-    auto trim = [](string &s) {
-        s.erase(0, s.find_first_not_of(" \t\r\n\""));
-        s.erase(s.find_last_not_of(" \t\r\n\"") + 1);
-    };
-
-    while (getline(file, line)) {
-        if (line.find("NODECONFIGHEADER") != string::npos) {
-            if (!current.name.empty()) nodes.push_back(current);
-            current = NodeConfig();
-            continue;
-        }
-
-        if (line.find("Name:") != string::npos)
-            current.name = line.substr(line.find(':') + 1);
-        else if (line.find("Type:") != string::npos)
-            current.type = line.substr(line.find(':') + 1);
-        else if (line.find("Location:") != string::npos) {
-            string locStr = line.substr(line.find(':') + 1);
-            replace(locStr.begin(), locStr.end(), ',', ' ');
-            stringstream ss(locStr);
-            ss >> current.x >> current.y >> current.z;
-        } else if (line.find("Transmission Frequency:") != string::npos)
-            current.freqMHz = stod(line.substr(line.find(':') + 1));
-        else if (line.find("Transmission Power:") != string::npos)
-            current.txPowerBm = stod(line.substr(line.find(':') + 1));
-        else if (line.find("Transmission Data Rate:") != string::npos)
-            current.txRate = line.substr(line.find(':') + 1);
-        else if (line.find("Receiver Data Rate:") != string::npos)
-            current.rxRate = line.substr(line.find(':') + 1);
-        else if (line.find("Linked Nodes:") != string::npos) {
-            string links = line.substr(line.find(':') + 1);
-            trim(links);
-            replace(links.begin(), links.end(), ',', ' ');
-            stringstream ss(links);
-            string name;
-            while (ss >> name) {
-                trim(name);
-                if (!name.empty())
-                    current.links.push_back(name);
-            }
-        }
-    }
-    if (!current.name.empty()) nodes.push_back(current);
-    file.close();
-
-    // Clean whitespace/quotes
-    for (auto &n : nodes) {
-        trim(n.name);
-        trim(n.type);
-        trim(n.txRate);
-        trim(n.rxRate);
-    }
+    Scenario scenario;
+    if (!loadScenario(filename, scenario)) return;
+    vector<NodeConfig> &nodes = scenario.nodes;
 
     cout << "\n[INFO] Parsed " << nodes.size() << " nodes successfully.\n";
 
     // -----------------------------
-    // Step 2: Simulate each link
+    // Step 2: Collect links in config order
     // -----------------------------
-    auto findNode = [&](const string &name) -> NodeConfig* {
-        for (auto &n : nodes) if (n.name == name) return &n;
-        return nullptr;
-    };
-
+    vector<LinkJob> links;
     for (auto &tx : nodes) {
         for (auto &targetName : tx.links) {
-            NodeConfig *rx = findNode(targetName);
+            const NodeConfig *rx = scenario.find(targetName);
             if (!rx) {
                 cerr << "[WARNING] Target node '" << targetName << "' not found.\n";
                 continue;
@@ -223,24 +410,198 @@ void startSimulation() {
             double dx = tx.x - rx->x;
             double dy = tx.y - rx->y;
             double dz = tx.z - rx->z;
-            double distance = sqrt(dx*dx + dy*dy + dz*dz);
 
-            string effectiveRate = (tx.txRate < rx->rxRate) ? tx.txRate : rx->rxRate;
+            LinkJob link;
+            link.txName = tx.name;
+            link.rxName = rx->name;
+            link.distance = sqrt(dx*dx + dy*dy + dz*dz);
+            link.freqMHz = tx.freqMHz;
+            link.txPowerdBm = tx.txPowerBm;
+            link.rate = (tx.txRate < rx->rxRate) ? tx.txRate : rx->rxRate;
+            links.push_back(link);
+        }
+    }
+
+    if (links.empty()) {
+        cout << "\n[INFO] No links to simulate.\n";
+        return;
+    }
 
-            cout << "\n[SIM] " << tx.name << " → " << rx->name
-                 << " | Distance: " << distance << " m"
-                 << " | Freq: " << tx.freqMHz << " MHz"
-                 << " | Power: " << tx.txPowerBm << " dBm"
-                 << " | Rate: " << effectiveRate << endl;
+    // -----------------------------
+    // Step 3: Simulate the links
+    // -----------------------------
+    char mode;
+    cout << "\nSimulation mode: [P] one run per link  [A] all links in one scenario"
+         << "  [R] replicated runs per link\n"
+         << "                 [T] table PHY (fast)  [V] validate table PHY against full PHY: ";
+    if (!(cin >> mode)) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid mode.\n";
+        return;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    mode = static_cast<char>(tolower(mode));
+
+    vector<LinkResult> results(links.size());
+    size_t failed = 0;
+
+    // With the link category traced the per-link lines become trace records
+    bool linesTraced = TraceEnabled(kTraceLink);
+    if (linesTraced)
+        cout << "\n[INFO] Per-link start/result lines go to the trace " << TraceFileSetting() << "\n";
+    auto printLinkHeader = [linesTraced](const LinkJob &link) {
+        traceLinkStart(link);
+        if (linesTraced) return;
+        cout << "\n[SIM] " << link.txName << " → " << link.rxName
+             << " | Distance: " << link.distance << " m"
+             << " | Freq: " << link.freqMHz << " MHz"
+             << " | Power: " << link.txPowerdBm << " dBm"
+             << " | Rate: " << link.rate << endl;
+    };
+    auto printLinkResult = [linesTraced](const LinkJob &link, const LinkResult &result, bool cached = false) {
+        if (cached)
+            TraceLinkResult(TraceCurrentLink(), true, result.packetsSent, result.packetsReceived, result.meanRttMs);
+        if (linesTraced) return;
+        cout << "[RESULT] " << link.txName << " → " << link.rxName
+             << " | Echoes: " << result.packetsReceived << "/" << result.packetsSent
+             << " | Mean RTT: " << result.meanRttMs << " ms" << (cached ? " (cached)" : "") << endl;
+    };
 
-            simulateTransmission(distance, tx.freqMHz, tx.txPowerBm, effectiveRate);
+    if (mode == 'a') {
+        for (const auto &link : links) printLinkHeader(link);
+        cout << "\n[INFO] Building single scenario with " << nodes.size()
+             << " nodes and " << links.size() << " links...\n";
+        results = simulateScenario(nodes, links);
+        cout << '\n';
+        for (size_t i = 0; i < links.size(); ++i) printLinkResult(links[i], results[i]);
+        cout << "\n[INFO] All transmissions complete.\n";
+        return;
+    }
+    if (mode == 'r') {
+        // Independent RNG runs per link until delivery ratio and RTT are
+        // known to the requested precision; packet errors and backoff are
+        // the random parts of the link model
+        ReplicationPolicy policy;
+        if (!chooseReplicationPolicy(policy)) return;
+        policy.absPrecision = 0.01;   // delivery ratios near zero, RTTs of lost links
+        for (const auto &link : links) {
+            printLinkHeader(link);
+            ScopedPhase linkPhase(ProfilingEnabled() ? "link " + link.txName + " -> " + link.rxName : string());
+            ReplicationSummary summary = RunReplications(
+                {"delivery ratio", "mean RTT (ms)"}, policy, [&](uint64_t run) {
+                    RngSeedManager::SetRun(run);
+                    LinkResult r = simulateTransmission(link.distance, link.freqMHz, link.txPowerdBm, link.rate);
+                    double ratio = r.packetsSent > 0 ? double(r.packetsReceived) / r.packetsSent : 0.0;
+                    return vector<double>{ratio, r.meanRttMs};
+                });
+            PrintReplicationSummary(summary, policy.confidence);
+        }
+        cout << "\n[INFO] All transmissions complete.\n";
+        return;
+    }
+    if (mode == 't' || mode == 'v') {
+        // Table-driven PHY: SNR -> PER lookups instead of an ns-3 run per link
+        PhyTables tables;
+        EnsurePhyTables(kPhyTablesPath, tables);
+        vector<PhyValidationRow> rows;
+        double tableMs = 0.0;
+        for (const auto &link : links) {
+            if (mode == 't') printLinkHeader(link);
+            else traceLinkStart(link);
+            auto t0 = chrono::steady_clock::now();
+            LinkResult result = SimulateTransmissionTable(tables, link.distance, link.freqMHz,
+                                                          link.txPowerdBm, link.rate);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            tableMs += ms;
+            if (mode == 't') {
+                printLinkResult(link, result);
+                continue;
+            }
+            PhyValidationRow row{link, LinkResult(), result, 0.0, ms};
+            t0 = chrono::steady_clock::now();
+            row.full = simulateTransmission(link.distance, link.freqMHz, link.txPowerdBm, link.rate);
+            row.fullMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            rows.push_back(row);
+        }
+        if (mode == 't') {
+            cout << "\n[TIMING] " << links.size() << " links with the table PHY in " << tableMs << " ms\n";
+            return;
         }
+        fs::create_directories("./scratch/output");
+        WritePhyValidationReport(rows, cout, "./scratch/output/" + fs::path(filename).stem().string() +
+                                                 "_phy_validation.csv");
+        return;
+    }
+    if (mode != 'p') {
+        cerr << "[ERROR] Invalid mode.\n";
+        return;
+    }
+
+    unsigned maxWorkers = DefaultWorkerCount();
+    cout << "Worker processes [1 = sequential, 0 = all " << maxWorkers << " cores]: ";
+    int requestedWorkers;
+    if (!(cin >> requestedWorkers) || requestedWorkers < 0) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid worker count.\n";
+        return;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    if (requestedWorkers > 0) maxWorkers = static_cast<unsigned>(requestedWorkers);
+
+    // Links whose exact inputs were simulated before come from the result
+    // cache; only the others are handed to the workers
+    unique_ptr<LinkResultCache> cache;
+    if (LinkResultCachingEnabled()) cache = make_unique<LinkResultCache>();
+    vector<size_t> pending;
+    vector<bool> cached(links.size(), false);
+    for (size_t i = 0; i < links.size(); ++i) {
+        if (cache && cache->Lookup(links[i], results[i])) cached[i] = true;
+        else pending.push_back(i);
     }
+    if (maxWorkers > pending.size()) maxWorkers = static_cast<unsigned>(max<size_t>(pending.size(), 1));
+
+    // Cached links are reported in config order between the simulated ones
+    size_t nextCached = 0;
+    auto reportCachedUpTo = [&](size_t end) {
+        for (; nextCached < end; ++nextCached) {
+            if (!cached[nextCached]) continue;
+            printLinkHeader(links[nextCached]);
+            printLinkResult(links[nextCached], results[nextCached], true);
+        }
+    };
+
+    auto runLink = [&](size_t k) -> string {
+        const LinkJob &link = links[pending[k]];
+        printLinkHeader(link);
+        ScopedPhase linkPhase(ProfilingEnabled() ? "link " + link.txName + " -> " + link.rxName : string());
+        LinkResult result = simulateTransmission(link.distance, link.freqMHz, link.txPowerdBm, link.rate);
+        return PackWorkerResult(result);
+    };
 
-    cout << "\n[INFO] All transmissions complete.\n";
+    RunWorkerPool(pending.size(), maxWorkers, runLink,
+                  [&](size_t k, const WorkerJobOutput &out) {
+        size_t i = pending[k];
+        reportCachedUpTo(i);
+        cout << out.log;
+        if (!out.ok || !UnpackWorkerResult(out.payload, results[i])) {
+            cerr << "[ERROR] Link " << links[i].txName << " → " << links[i].rxName << " failed.\n";
+            ++failed;
+            return;
+        }
+        printLinkResult(links[i], results[i]);
+        if (cache) cache->Store(links[i], results[i]);
+    });
+    reportCachedUpTo(links.size());
+
+    cout << "\n[INFO] All transmissions complete ("
+         << links.size() - failed << "/" << links.size() << " links succeeded).\n";
+    if (cache) PrintLinkCacheReport(*cache, cout);
 }
 
 void startLunarCISimulation() {
+    ScopedPhase phase("lunar_ci");
     string configDir = "./scratch/config/LTE_config";
     vector<fs::path> configFiles;
 
@@ -273,12 +634,277 @@ void startLunarCISimulation() {
     string filename = configFiles[choice - 1].string();
     cout << "\n[INFO] Running CI simulation with: " << filename << endl;
 
+    char mode = 's';
+    cout << "Run mode: [S] single run  [R] replicate until the KPIs converge: ";
+    if (!(cin >> mode)) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid mode.\n";
+        return;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
     std::string confArg = "--conf=" + filename;
-    const char *argv[] = {"lunar_dt_CI", confArg.c_str()};
-    runLunarDtCI(2, const_cast<char**>(argv));
+    if (tolower(mode) != 'r') {
+        const char *argv[] = {"lunar_dt_CI", confArg.c_str()};
+        runLunarDtCI(2, const_cast<char**>(argv), nullptr);
+        return;
+    }
+
+    ReplicationPolicy policy;
+    if (!chooseReplicationPolicy(policy)) return;
+    policy.absPrecision = 0.05;   // dB / dBm: tight enough for KPIs near 0 dB
+    ReplicationSummary summary = RunReplications(
+        {"mean RSRP (dBm)", "mean SINR (dB)", "p5 SINR (dB)"}, policy, [&](uint64_t run) {
+            RngSeedManager::SetRun(run);
+            const char *argv[] = {"lunar_dt_CI", confArg.c_str(), "--animFile=none"};
+            CiResult r;
+            if (runLunarDtCI(3, const_cast<char**>(argv), &r) != 0 || r.ueReports == 0) return vector<double>();
+            return vector<double>{r.meanRsrpDbm, r.meanSinrDb, r.p5SinrDb};
+        });
+    PrintReplicationSummary(summary, policy.confidence);
+}
+
+// Run every point of a .sweep design through runLunarDtCI() in isolated
+// worker processes. Rows are appended to the results table as points
+// finish, and points already in the table are skipped, so an interrupted
+// sweep resumes where it stopped.
+void startParameterSweep() {
+    ScopedPhase phase("parameter_sweep");
+    cout << "\n=== CI Parameter Sweep ===\n";
+    string specPath = chooseConfigFile("./scratch/config/LTE_config", ".sweep", "Select a sweep file number: ");
+    if (specPath.empty()) return;
+
+    SweepSpec spec;
+    if (!LoadSweepSpec(specPath, spec)) return;
+    static const vector<string> sweepable = {"L", "fGHz", "n", "gEnb", "gUe", "enbSpacing",
+                                             "attachK", "numEnb", "numUe"};
+    for (SweepParameter &p : spec.parameters) {
+        if (find(sweepable.begin(), sweepable.end(), p.name) == sweepable.end()) {
+            cerr << "[ERROR] '" << p.name << "' cannot be swept. Parameters: L, fGHz, n, gEnb, gUe, "
+                 << "enbSpacing, attachK, numEnb, numUe.\n";
+            return;
+        }
+        p.integer = p.name == "attachK" || p.name == "numEnb" || p.name == "numUe";
+    }
+    if (spec.conf.empty()) spec.conf = "./scratch/config/LTE_config/lunar_dt.conf";
+    if (!fs::exists(spec.conf)) {
+        cerr << "[ERROR] Base configuration not found: " << spec.conf << '\n';
+        return;
+    }
+    if (spec.output.empty())
+        spec.output = "./scratch/output/" + fs::path(specPath).stem().string() + "_sweep.csv";
+
+    string identity;
+    if (!SweepTableIdentity(spec, identity)) return;
+    string header = identity + "\nkey";
+    for (const SweepParameter &p : spec.parameters) header += "," + p.name;
+    header += ",num_enb,num_ue,ue_reports,mean_rsrp_dbm,mean_sinr_db,p5_sinr_db,min_sinr_db,wall_ms";
+
+    unordered_set<string> done;
+    if (!LoadCompletedSweepPoints(spec.output, header, done)) return;
+
+    // Points still to run; rounding can make design points coincide
+    vector<vector<double>> points = GenerateSweepPoints(spec);
+    vector<size_t> pending;
+    unordered_set<string> scheduled;
+    for (size_t i = 0; i < points.size(); ++i) {
+        string key = SweepPointKey(spec, points[i]);
+        if (!done.count(key) && scheduled.insert(key).second) pending.push_back(i);
+    }
+    cout << "[INFO] " << points.size() << " design points, " << points.size() - pending.size()
+         << " already in " << spec.output << ", " << pending.size() << " to run.\n";
+    if (pending.empty()) return;
+
+    fs::path outPath(spec.output);
+    if (outPath.has_parent_path()) fs::create_directories(outPath.parent_path());
+    if (!DropPartialSweepRow(spec.output)) {
+        cerr << "[ERROR] Could not trim the partial last row of " << spec.output << '\n';
+        return;
+    }
+    bool fresh = !fs::exists(outPath) || fs::file_size(outPath) == 0;
+    ofstream table(spec.output, ios::app);
+    if (!table.is_open()) {
+        cerr << "[ERROR] Could not write " << spec.output << '\n';
+        return;
+    }
+    if (fresh) table << header << '\n';
+
+    unsigned maxWorkers = spec.workers > 0 ? spec.workers : DefaultWorkerCount();
+    if (maxWorkers > pending.size()) maxWorkers = static_cast<unsigned>(pending.size());
+    cout << "[INFO] Running with " << maxWorkers << " worker process(es)...\n";
+
+    auto runPoint = [&](size_t k) -> string {
+        const vector<double> &point = points[pending[k]];
+        vector<string> args = {"lunar_dt_CI", "--conf=" + spec.conf, "--animFile=none"};
+        for (size_t j = 0; j < spec.parameters.size(); ++j)
+            args.push_back("--" + spec.parameters[j].name + "=" + FormatSweepValue(point[j]));
+        vector<char*> argv;
+        for (string &a : args) argv.push_back(a.data());
+        argv.push_back(nullptr);
+
+        CiResult result;
+        if (runLunarDtCI(static_cast<int>(args.size()), argv.data(), &result) != 0) return "";
+        return PackWorkerResult(result);
+    };
+
+    size_t failed = 0;
+    size_t reportEvery = max<size_t>(1, pending.size() / 20);
+    auto t0 = chrono::steady_clock::now();
+    RunWorkerPool(pending.size(), maxWorkers, runPoint,
+                  [&](size_t k, const WorkerJobOutput &out) {
+        const vector<double> &point = points[pending[k]];
+        CiResult r;
+        if (!out.ok || !UnpackWorkerResult(out.payload, r)) {
+            cerr << "[ERROR] Sweep point " << SweepPointKey(spec, point) << " failed:\n" << out.log;
+            ++failed;
+        } else {
+            table << SweepPointKey(spec, point);
+            for (double v : point) table << ',' << FormatSweepValue(v);
+            table << ',' << r.numEnb << ',' << r.numUe << ',' << r.ueReports << ','
+                  << FormatSweepValue(r.meanRsrpDbm) << ',' << FormatSweepValue(r.meanSinrDb) << ','
+                  << FormatSweepValue(r.p5SinrDb) << ',' << FormatSweepValue(r.minSinrDb) << ','
+                  << FormatSweepValue(r.wallMs) << '\n';
+            table.flush();
+        }
+        if ((k + 1) % reportEvery == 0 || k + 1 == pending.size()) {
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            const streamsize precision = cout.precision();
+            cout << "[INFO] " << k + 1 << "/" << pending.size() << " points (" << failed << " failed), "
+                 << fixed << setprecision(1) << (k + 1) / max(elapsed, 1e-9) << " points/s" << defaultfloat
+                 << setprecision(precision) << endl;
+        }
+    });
+
+    cout << "\n[INFO] Sweep complete: " << pending.size() - failed << "/" << pending.size()
+         << " points written to " << spec.output << ".\n";
+    if (failed > 0) cout << "[INFO] Run the sweep again to retry the failed points.\n";
+}
+
+// Interactive update-then-query loop: link and node changes are applied to
+// a DynamicRouter, which repairs its shortest-path trees in place, and the
+// route from start to goal is re-read after every change.
+static void runRouteUpdates(const RoutingGraph &graph, vector<RadioProfile> *radios,
+                            uint32_t start, uint32_t goal) {
+    DynamicRouter router(graph);
+    LinkCostTable radioModel;
+    if (radios) {
+        router.setWeightFunction([&](uint32_t from, uint32_t to) {
+            return radioModel.evaluate((*radios)[from], (*radios)[to]).latencyS;
+        });
+    }
+
+    auto readNode = [&](const string &prompt) {
+        string name = readNodeName(prompt);
+        uint32_t id = router.idOf(name);
+        if (id == kInvalidNode) cerr << "[ERROR] Unknown node '" << name << "'.\n";
+        return id;
+    };
+    auto printRoute = [&]() {
+        vector<uint32_t> nodes;
+        auto t0 = chrono::steady_clock::now();
+        bool found = router.route(start, goal, nodes);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        if (!found) {
+            cout << "[RESULT] " << router.nameOf(start) << " -> " << router.nameOf(goal) << ": unreachable\n";
+            return;
+        }
+        cout << "[RESULT] ";
+        for (size_t i = 0; i < nodes.size(); ++i)
+            cout << router.nameOf(nodes[i]) << (i + 1 < nodes.size() ? " -> " : "");
+        double cost = router.distance(start, goal);
+        if (radios) cout << "\n  Estimated latency: " << cost * 1000.0 << " ms";
+        else cout << "\n  Total distance: " << cost << " m";
+        cout << " (" << ms << " ms)\n";
+    };
+    auto report = [&](const RepairStats &st, double ms) {
+        cout << "[INFO] Repaired in " << ms << " ms (" << st.invalidated << " nodes re-routed, "
+             << st.settled << " settled).\n";
+    };
+
+    printRoute();
+    while (true) {
+        char op;
+        cout << "\nChange: [F] fail link  [A] add/restore link  [M] move node  [R] re-route  [Q] done: ";
+        if (!(cin >> op)) { cin.clear(); return; }
+        op = static_cast<char>(tolower(op));
+        if (op == 'q') return;
+
+        RepairStats st;
+        auto t0 = chrono::steady_clock::now();
+        if (op == 'f' || op == 'a') {
+            uint32_t a = readNode("First node: ");
+            uint32_t b = readNode("Second node: ");
+            if (a == kInvalidNode || b == kInvalidNode) continue;
+            t0 = chrono::steady_clock::now();
+            // Radio links fail and come back in both directions
+            for (auto [u, v] : {pair<uint32_t, uint32_t>{a, b}, pair<uint32_t, uint32_t>{b, a}}) {
+                RepairStats s = op == 'f' ? router.removeLink(u, v) : router.addLink(u, v);
+                st.invalidated += s.invalidated;
+                st.settled += s.settled;
+            }
+        } else if (op == 'm') {
+            uint32_t v = readNode("Node: ");
+            if (v == kInvalidNode) continue;
+            NodePosition p{};
+            cout << "New location (x y z): ";
+            if (!(cin >> p.x >> p.y >> p.z)) {
+                cin.clear();
+                cerr << "[ERROR] Invalid location.\n";
+                continue;
+            }
+            t0 = chrono::steady_clock::now();
+            if (radios) (*radios)[v].position = p;
+            st = router.moveNode(v, p);
+        } else if (op != 'r') {
+            cout << "[ERROR] Invalid choice.\n";
+            continue;
+        }
+        if (op != 'r')
+            report(st, chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+        printRoute();
+    }
+}
+
+// Simulate a mission of moving nodes (rovers, orbiters) whose links follow
+// the precomputed contact windows of a .traj trajectory file
+void startContactPlanSimulation() {
+    ScopedPhase phase("contact_plan");
+    cout << "\n=== Contact Plan Simulation ===\n";
+    string filename = chooseConfigFile("./scratch/config", ".traj", "Select a trajectory file number: ");
+    if (filename.empty()) return;
+
+    double hours = 24.0, rangeKm = 50.0;
+    string sink;
+    cout << "Mission duration (hours): ";
+    if (!(cin >> hours) || hours <= 0.0) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid duration.\n";
+        return;
+    }
+    cout << "Maximum link range (km): ";
+    if (!(cin >> rangeKm) || rangeKm <= 0.0) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid range.\n";
+        return;
+    }
+    cout << "Sink node name (- = first node): ";
+    cin >> sink;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+    vector<string> args = {"contactPlanSim", "--trajectories=" + filename,
+                           "--duration=" + to_string(hours * 3600.0),
+                           "--maxRange=" + to_string(rangeKm * 1000.0)};
+    if (sink != "-") args.push_back("--sink=" + sink);
+    vector<char*> argv;
+    for (string &a : args) argv.push_back(a.data());
+    runContactPlanSimulation(static_cast<int>(argv.size()), argv.data());
 }
 
 void startOptimalPathFinder() {
+    ScopedPhase phase("optimal_path");
     string configDir = "./scratch/config";
     vector<fs::path> configFiles;
 
@@ -310,72 +936,177 @@ void startOptimalPathFinder() {
     }
 
     string filename = configFiles[choice - 1].string();
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "[ERROR] Could not open " << filename << endl;
-        return;
-    }
-
-    unordered_map<string, NodePosition> nodes;
-    unordered_map<string, vector<string>> adjacency;
-
-    string line, currentNode;
-    while (getline(file, line)) {
-        if (line.find("Name:") != string::npos) {
-            currentNode = line.substr(line.find(':') + 1);
-            currentNode.erase(remove(currentNode.begin(), currentNode.end(), '\"'), currentNode.end());
-            currentNode.erase(remove_if(currentNode.begin(), currentNode.end(), ::isspace), currentNode.end());
-        } else if (line.find("Location:") != string::npos && !currentNode.empty()) {
-            string locStr = line.substr(line.find(':') + 1);
-            replace(locStr.begin(), locStr.end(), ',', ' ');
-            stringstream ss(locStr);
-            double x, y, z; ss >> x >> y >> z;
-            nodes[currentNode] = {x, y, z};
-        } else if (line.find("Linked Nodes:") != string::npos && !currentNode.empty()) {
-            string links = line.substr(line.find(':') + 1);
-            replace(links.begin(), links.end(), ',', ' ');
-            stringstream ss(links);
-            string node;
-            while (ss >> node) {
-                node.erase(remove(node.begin(), node.end(), '\"'), node.end());
-                adjacency[currentNode].push_back(node);
-            }
-        }
-    }
-    file.close();
+    Scenario scenario;
+    RoutingGraph graph;
+    if (!loadScenario(filename, scenario, &graph)) return;
 
     cout << "\nAvailable Nodes:\n";
-    for (auto &n : nodes) cout << "  - " << n.first << endl;
+    for (uint32_t v = 0; v < graph.nodeCount(); ++v) cout << "  - " << graph.names[v] << endl;
+
+    bool radioCost = false;
+    vector<RadioProfile> radios;
+    if (!chooseEdgeWeights(scenario, graph, radioCost, &radios)) return;
 
-    string start, goal;
-    cout << "\nEnter starting node name: ";
-    cin >> start;
-    cout << "Enter destination node name: ";
-    cin >> goal;
+    string start = readNodeName("\nEnter starting node name: ");
+    string goal = readNodeName("Enter destination node name: ");
+    uint32_t startId = graph.idOf(start), goalId = graph.idOf(goal);
+    if (startId == kInvalidNode || goalId == kInvalidNode) {
+        cerr << "[ERROR] Unknown node '" << (startId == kInvalidNode ? start : goal) << "'.\n";
+        return;
+    }
 
-    auto path = findOptimalPath(nodes, adjacency, start, goal);
-    if (path.empty()) {
+    char searchChoice = 'd';
+    cout << "Search: [D] Dijkstra  [A] A*  [B] bidirectional: ";
+    cin >> searchChoice;
+    searchChoice = static_cast<char>(tolower(searchChoice));
+    SearchMode mode = searchChoice == 'a' ? SearchMode::AStar
+                    : searchChoice == 'b' ? SearchMode::Bidirectional
+                    : SearchMode::Dijkstra;
+    // Straight-line distance bounds path length; for latency weights it
+    // bounds propagation time at the speed of light
+    double heuristicScale = radioCost ? LatencyLowerBoundPerMetre() : 1.0;
+
+    SearchWorkspace ws;
+    PathResult path;
+    auto t0 = chrono::steady_clock::now();
+    bool found = FindRoute(graph, graph.weights, startId, goalId, mode, ws, path, heuristicScale);
+    double searchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    if (!found) {
         cout << "\n[ERROR] No valid path found between " << start << " and " << goal << ".\n";
         return;
     }
 
     cout << "\n[RESULT] Optimal Path:\n  ";
-    for (size_t i = 0; i < path.size(); ++i) {
-        cout << path[i];
-        if (i < path.size() - 1) cout << " -> ";
+    for (size_t i = 0; i < path.nodes.size(); ++i) {
+        cout << graph.names[path.nodes[i]];
+        if (i < path.nodes.size() - 1) cout << " -> ";
     }
 
     double totalDist = 0.0;
-    for (size_t i = 1; i < path.size(); ++i)
-        totalDist += sqrt(pow(nodes[path[i-1]].x - nodes[path[i]].x, 2) +
-                          pow(nodes[path[i-1]].y - nodes[path[i]].y, 2) +
-                          pow(nodes[path[i-1]].z - nodes[path[i]].z, 2));
+    for (size_t i = 1; i < path.nodes.size(); ++i)
+        totalDist += EuclideanDistance(graph.positions[path.nodes[i-1]], graph.positions[path.nodes[i]]);
 
     cout << "\nTotal distance: " << totalDist << " m\n";
+    if (radioCost)
+        cout << "Estimated latency: " << path.cost * 1000.0 << " ms\n";
+    cout << "Nodes expanded: " << path.expanded << " of " << graph.nodeCount()
+         << " (" << searchMs << " ms)\n";
+
+    char again = 'n';
+    cout << "\nApply link failures / node moves and re-route? (y/n): ";
+    cin >> again;
+    if (tolower(again) == 'y')
+        runRouteUpdates(graph, radioCost ? &radios : nullptr, startId, goalId);
+}
+
+
+void startBatchRouteQueries() {
+    ScopedPhase phase("batch_routes");
+    cout << "\n=== Batch Route Queries ===\n";
+    string filename = chooseConfigFile("./scratch/config", ".txt", "Select a file number: ");
+    if (filename.empty()) return;
+
+    Scenario scenario;
+    RoutingGraph graph;
+    if (!loadScenario(filename, scenario, &graph)) return;
+    bool radioCost = false;
+    if (!chooseEdgeWeights(scenario, graph, radioCost)) return;
+
+    // The routing index lives next to the config and is reused while the topology is unchanged
+    string indexPath = filename + (radioCost ? ".radio.ch" : ".ch");
+    bool rebuilt = false;
+    auto t0 = chrono::steady_clock::now();
+    ContractionHierarchy ch = LoadOrBuildContractionHierarchy(graph, indexPath, &rebuilt);
+    double prepMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "[INFO] Routing index " << (rebuilt ? "built" : "loaded") << " in " << prepMs << " ms ("
+         << graph.nodeCount() << " nodes, " << ch.fwdEdges.size() + ch.bwdEdges.size() << " upward edges)\n";
+
+    string queryPath;
+    cout << "\nQuery file (one \"start,goal\" pair per line): ";
+    cin >> queryPath;
+    ifstream queryFile(queryPath);
+    if (!queryFile.is_open()) {
+        cerr << "[ERROR] Could not open " << queryPath << endl;
+        return;
+    }
+
+    unsigned threads = DefaultWorkerCount();
+    cout << "Threads [0 = all " << threads << "]: ";
+    int requestedThreads;
+    if (!(cin >> requestedThreads) || requestedThreads < 0) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cerr << "[ERROR] Invalid thread count.\n";
+        return;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    if (requestedThreads > 0) threads = static_cast<unsigned>(requestedThreads);
+
+    vector<RouteQuery> queries;
+    vector<pair<string, string>> queryNames;
+    string line, start, goal;
+    size_t lineNo = 0, skipped = 0;
+    while (getline(queryFile, line)) {
+        ++lineNo;
+        line = trimmedName(line);
+        if (line.empty() || line[0] == '#') continue;
+        if (!parseQueryLine(line, start, goal)) {
+            cerr << "[WARNING] " << queryPath << ":" << lineNo << ": expected \"start,goal\", skipped.\n";
+            ++skipped;
+            continue;
+        }
+        uint32_t s = graph.idOf(start), t = graph.idOf(goal);
+        if (s == kInvalidNode || t == kInvalidNode) {
+            cerr << "[WARNING] " << queryPath << ":" << lineNo << ": unknown node '"
+                 << (s == kInvalidNode ? start : goal) << "', skipped.\n";
+            ++skipped;
+            continue;
+        }
+        queries.push_back({s, t});
+        queryNames.emplace_back(start, goal);
+    }
+    if (skipped > 0) cout << "[INFO] " << skipped << " query line(s) skipped.\n";
+
+    vector<RouteAnswer> answers;
+    t0 = chrono::steady_clock::now();
+    QueryContractionHierarchyBatch(ch, queries, answers, threads);
+    double queryMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    fs::create_directories("./scratch/output");
+    string outPath = "./scratch/output/" + fs::path(filename).stem().string() + "_routes.csv";
+    ofstream out(outPath);
+    if (!out.is_open()) {
+        cerr << "[ERROR] Could not write " << outPath << endl;
+        return;
+    }
+    size_t found = 0;
+    double maxUs = 0.0;
+    out << (radioCost ? "start,goal,latency_us,latency_s,path\n" : "start,goal,latency_us,distance_m,path\n");
+    for (size_t i = 0; i < answers.size(); ++i) {
+        maxUs = max(maxUs, answers[i].latencyUs);
+        out << csvField(queryNames[i].first) << ',' << csvField(queryNames[i].second) << ','
+            << answers[i].latencyUs << ',';
+        if (answers[i].path.empty()) { out << ",\n"; continue; }
+        ++found;
+        out << answers[i].cost << ',';
+        // Names may hold spaces, so the hops are separated by ';'
+        string hops;
+        for (size_t k = 0; k < answers[i].path.size(); ++k) {
+            if (k) hops += ';';
+            hops += graph.names[answers[i].path[k]];
+        }
+        out << csvField(hops) << '\n';
+    }
+
+    cout << "\n[RESULT] " << queries.size() << " queries (" << found << " routable) in " << queryMs << " ms";
+    if (!queries.empty())
+        cout << " — " << queryMs * 1000.0 / queries.size() << " us/query, slowest " << maxUs << " us";
+    cout << "\n[INFO] Routes written to " << outPath << endl;
 }
 
 
 void startMappingSoftware() {
+    ScopedPhase phase("node_map");
     string configDir = "./scratch/config";
     vector<fs::path> configFiles;
 
@@ -402,38 +1133,92 @@ void startMappingSoftware() {
     cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
     string filename = configFiles[choice - 1].string();
-    ifstream file(filename);
-    if (!file.is_open()) { cerr << "[ERROR] Could not open " << filename << endl; return; }
-
     cout << "\n[INFO] Reading configuration: " << filename << endl;
 
-    vector<NodeConfig> nodes;
-    NodeConfig current;
-    string line;
+    Scenario scenario;
+    if (!loadScenario(filename, scenario)) return;
+    const vector<NodeConfig> &nodes = scenario.nodes;
 
-    auto trim = [](string &s){ s.erase(0, s.find_first_not_of(" \t\r\n\""));
-                               s.erase(s.find_last_not_of(" \t\r\n\"") + 1); };
+    cout << "[INFO] Parsed " << nodes.size() << " nodes. Generating map...\n";
+    generateNodeMapXML(nodes, "./scratch/output/lunar_node_map.xml");
+}
 
-    while (getline(file, line)) {
-        if (line.find("NODECONFIGHEADER") != string::npos) {
-            if (!current.name.empty()) nodes.push_back(current);
-            current = NodeConfig();
-            continue;
-        }
-        if (line.find("Name:") != string::npos) current.name = line.substr(line.find(':')+1);
-        else if (line.find("Type:") != string::npos) current.type = line.substr(line.find(':')+1);
-        else if (line.find("Location:") != string::npos) {
-            string loc = line.substr(line.find(':')+1);
-            replace(loc.begin(), loc.end(), ',', ' ');
-            stringstream ss(loc); ss >> current.x >> current.y >> current.z;
+
+void startLinkBudgetMatrix() {
+    ScopedPhase phase("link_budget_matrix");
+    cout << "\n=== Link Budget / Feasibility Matrix ===\n";
+    string filename = chooseConfigFile("./scratch/config", ".txt", "Select a file number to analyse: ");
+    if (filename.empty()) return;
+
+    cout << "\n[INFO] Reading configuration: " << filename << endl;
+    Scenario scenario;
+    if (!loadScenario(filename, scenario)) return;
+    const vector<NodeConfig> &nodes = scenario.nodes;
+    cout << "[INFO] Parsed " << nodes.size() << " nodes.\n";
+
+    LinkBudgetParams params;
+    char model;
+    cout << "\nPath-loss model: [F] Friis  [C] Close-In: ";
+    if (!(cin >> model)) { cin.clear(); cerr << "[ERROR] Invalid model.\n"; return; }
+    model = static_cast<char>(tolower(model));
+    if (model == 'c') {
+        params.model = PathLossModel::CloseIn;
+        cout << "CI path-loss exponent n: ";
+        if (!(cin >> params.exponent)) { cin.clear(); cerr << "[ERROR] Invalid exponent.\n"; return; }
+    } else if (model != 'f') {
+        cerr << "[ERROR] Invalid model.\n";
+        return;
+    }
+    cout << "Minimum SNR for a usable link (dB): ";
+    if (!(cin >> params.minSnrDb)) { cin.clear(); cerr << "[ERROR] Invalid SNR.\n"; return; }
+    string terrainFile;
+    cout << "Terrain descriptor (.dem, - = free space): ";
+    cin >> terrainFile;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    shared_ptr<const TerrainMap> terrain;
+    if (terrainFile != "-") {
+        terrain = LoadSharedTerrain(terrainFile);
+        if (!terrain) return;
+        params.terrain = terrain.get();
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    LinkBudgetResult budget = ComputeLinkBudgets(MakeLinkBudgetNodes(nodes), params);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    size_t configured = 0, configuredFeasible = 0;
+    unordered_map<string, size_t> indexOf;
+    for (size_t i = 0; i < nodes.size(); ++i) indexOf[nodes[i].name] = i;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const auto &target : nodes[i].links) {
+            auto it = indexOf.find(target);
+            if (it == indexOf.end()) continue;
+            ++configured;
+            if (budget.feasible.feasible(i, it->second)) ++configuredFeasible;
         }
     }
-    if (!current.name.empty()) nodes.push_back(current);
-    file.close();
-    for (auto &n : nodes){ trim(n.name); trim(n.type); }
 
-    cout << "[INFO] Parsed " << nodes.size() << " nodes. Generating map...\n";
-    generateNodeMapXML(nodes, "./scratch/output/lunar_node_map.xml");
+    cout << "\n[RESULT] Evaluated " << nodes.size() * (nodes.size() ? nodes.size() - 1 : 0)
+         << " node pairs in " << ms << " ms\n"
+         << "  Feasible links      : " << budget.feasibleCount << '\n'
+         << "  Configured links    : " << configured << " (" << configuredFeasible << " close)\n";
+
+    fs::create_directories("./scratch/output");
+    string outPath = "./scratch/output/" + fs::path(filename).stem().string() + "_link_budget.csv";
+    ofstream out(outPath);
+    if (!out.is_open()) {
+        cerr << "[ERROR] Could not write " << outPath << endl;
+        return;
+    }
+    out << "tx,rx,distance_m,path_loss_db,rx_power_dbm,snr_db,terrain_loss_db\n";
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (uint64_t k = budget.offsets[i]; k < budget.offsets[i + 1]; ++k) {
+            const LinkBudgetEntry &e = budget.entries[k];
+            out << nodes[i].name << ',' << nodes[e.rx].name << ',' << e.distance << ','
+                << e.pathLossDb << ',' << e.rxPowerDbm << ',' << e.snrDb << ',' << e.terrainLossDb << '\n';
+        }
+    }
+    cout << "[INFO] Derived adjacency written to " << outPath << endl;
 }
 
 
@@ -0,0 +1,58 @@
+/*
+ * Lunar DT distributed runner
+ *
+ * Splits the CI scenario across MPI ranks (Earth / LunarGW + backhaul /
+ * surface cells) and reports the speedup over the sequential run.
+ * Requires ns-3 configured with --enable-mpi.
+ *
+ *   ./ns3 run "LDT_mpi --numEnb=64 --numUe=4000 --sequential"     # baseline
+ *   mpirun -np 4 ./build/scratch/ns3.45-LDT_mpi-default --numEnb=64 --numUe=4000
+ */
+#include <string>
+#include "ns3/core-module.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#endif
+#include "../scratch_helpers/profiler.cc"
+#include "../scratch_helpers/binaryTrace.cc"
+#include "../scratch_helpers/cachingPropagationLoss.cc"
+#include "../scratch_helpers/terrain.cc"
+#include "../scratch_helpers/terrainPropagationLoss.cc"
+#include "../scratch_helpers/routingGraph.cc"
+#include "../scratch_helpers/kdTree.cc"
+#include "../scratch_helpers/scenarioParser.cc"
+#include "../scratch_helpers/scenarioCache.cc"
+#include "../scratch_helpers/lunar_dt_CI.cc"
+#include "../scratch_helpers/lunarDistributed.cc"
+
+using namespace ns3;
+
+int main(int argc, char* argv[]) {
+    // Decided before MPI starts; CommandLine parses the flag again later
+    bool sequential = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sequential" || arg == "--sequential=1" || arg == "--sequential=true")
+            sequential = true;
+    }
+
+#ifdef NS3_MPI
+    if (!sequential) {
+        // Null messages let each rank sync only with its neighbours, so the
+        // Earth rank is not held to the (much shorter) backhaul lookahead
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::NullMessageSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+    }
+#else
+    if (!sequential)
+        std::cout << "[WARNING] ns-3 was built without MPI; running sequentially.\n";
+#endif
+
+    int rc = runLunarDistributed(argc, argv);
+
+#ifdef NS3_MPI
+    if (MpiInterface::IsEnabled())
+        MpiInterface::Disable();
+#endif
+    return rc;
+}
@@ -0,0 +1,60 @@
+/*
+ * Lunar DT job server
+ *
+ * Keeps scenarios, routing indexes and the ns-3 runtime warm and runs
+ * submitted jobs in forked worker processes (see scratch_helpers/simServer.h
+ * for the job format). Jobs arrive on a Unix socket or in a spool directory.
+ *
+ *   ./ns3 run "LDT_server --spool=scratch/output/spool --preload=scratch/config/lunar_base.txt"
+ *   echo "1 route scenario=scratch/config/lunar_base.txt from=GW0 to=UE12" | \
+ *       ./build/scratch/ns3.45-LDT_server-default --client
+ */
+#include <sstream>
+#include <string>
+#include "../scratch_helpers/profiler.cc"
+#include "../scratch_helpers/binaryTrace.cc"
+#include "../scratch_helpers/cachingPropagationLoss.cc"
+#include "../scratch_helpers/terrain.cc"
+#include "../scratch_helpers/terrainPropagationLoss.cc"
+#include "../scratch_helpers/lunarTransmissionSim.cc"
+#include "../scratch_helpers/kdTree.cc"
+#include "../scratch_helpers/lunar_dt_CI.cc"
+#include "../scratch_helpers/routingGraph.cc"
+#include "../scratch_helpers/contractionHierarchy.cc"
+#include "../scratch_helpers/workerPool.cc"
+#include "../scratch_helpers/scenarioParser.cc"
+#include "../scratch_helpers/scenarioCache.cc"
+#include "../scratch_helpers/linkResultCache.cc"
+#include "../scratch_helpers/simServer.cc"
+
+using namespace ns3;
+
+int main(int argc, char* argv[]) {
+    ServerOptions options;
+    bool client = false;
+    std::string preload;
+
+    CommandLine cmd;
+    cmd.AddValue("socket", "Unix socket to listen on (or connect to with --client)", options.socketPath);
+    cmd.AddValue("spool", "Directory polled for *.job files (empty = socket only)", options.spoolDir);
+    cmd.AddValue("log", "File receiving the console output of the workers", options.logPath);
+    cmd.AddValue("workers", "Concurrent worker processes (0 = all cores)", options.workers);
+    cmd.AddValue("warmup", "Run one throw-away link simulation at start-up", options.warmup);
+    cmd.AddValue("timeout", "Seconds a job may run before its worker is killed (0 = no limit)",
+                 options.jobTimeoutS);
+    cmd.AddValue("preload", "Comma-separated scenarios to load and index at start-up", preload);
+    cmd.AddValue("client", "Send job lines from stdin to a running server and print the replies", client);
+    cmd.Parse(argc, argv);
+
+    if (client) return RunSimClient(options.socketPath);
+
+    std::stringstream list(preload);
+    std::string item;
+    while (std::getline(list, item, ','))
+        if (!item.empty()) options.preload.push_back(item);
+    if (TraceFromEnvironment())
+        std::cout << "[INFO] Binary trace enabled (LdtTrace); workers write " << TraceFileSetting() << ".<pid>\n";
+    int status = RunSimServer(options);
+    StopTrace();
+    return status;
+}
@@ -0,0 +1,155 @@
+/*
+ * Lunar DT trace decoder
+ *
+ * Turns the binary traces written by LdtTrace sessions (see
+ * scratch_helpers/binaryTrace.h) into text or CSV. The traces of forked
+ * workers (<input>.<pid>) are merged in by default; records are printed in
+ * wall-clock order, times relative to the earliest session start.
+ *
+ *   ./ns3 run "LDT_trace --input=scratch/output/ldt_trace.ldtt"
+ *   ./ns3 run "LDT_trace --input=scratch/output/ldt_trace.ldtt --format=csv --categories=echo --output=echo.csv"
+ */
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "../scratch_helpers/binaryTrace.cc"
+
+using namespace ns3;
+using namespace std;
+
+static string csvQuote(const string& s) {
+    if (s.find_first_of(",\"\n") == string::npos) return s;
+    string quoted = "\"";
+    for (char c : s) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+int main(int argc, char* argv[]) {
+    string input = TraceFileSetting();
+    string format = "text";
+    string output;
+    string categories = "all";
+    bool workers = true;
+
+    CommandLine cmd;
+    cmd.AddValue("input", "Trace file written by an LdtTrace session", input);
+    cmd.AddValue("workers", "Also merge the worker traces <input>.<pid>", workers);
+    cmd.AddValue("format", "text or csv", format);
+    cmd.AddValue("output", "Output file (default: standard output)", output);
+    cmd.AddValue("categories", "Categories to print: link,echo,ci,contact or all", categories);
+    cmd.Parse(argc, argv);
+
+    uint32_t mask;
+    if (!ParseTraceCategories(categories, mask)) {
+        cerr << "[ERROR] Unknown trace category in '" << categories << "'.\n";
+        return 1;
+    }
+    if (format != "text" && format != "csv") {
+        cerr << "[ERROR] Unknown format '" << format << "' (text or csv).\n";
+        return 1;
+    }
+
+    vector<string> paths{input};
+    if (workers) {
+        vector<string> more = WorkerTraceFiles(input);
+        paths.insert(paths.end(), more.begin(), more.end());
+    }
+
+    vector<TraceFileContents> files;
+    for (const string& path : paths) {
+        TraceFileContents contents;
+        string error;
+        if (!ReadTraceFile(path, contents, error)) {
+            cerr << "[ERROR] " << error << "\n";
+            if (files.empty() && path == input) return 1;
+            continue;
+        }
+        cerr << "[INFO] " << path << ": " << contents.records.size() << " records (pid " << contents.pid
+             << ", " << TraceCategoryNames(contents.categories) << ")";
+        if (contents.dropped > 0) cerr << ", " << contents.dropped << " dropped";
+        if (!contents.complete) cerr << ", no name table (writer did not finish)";
+        cerr << "\n";
+        files.push_back(move(contents));
+    }
+
+    // Merge by wall-clock time; records of one file keep their order
+    struct Ref {
+        const TraceFileContents* file;
+        const TraceRecord* record;
+    };
+    vector<Ref> refs;
+    int64_t origin = files.empty() ? 0 : files.front().startNs;
+    for (const TraceFileContents& file : files) {
+        origin = min(origin, file.startNs);
+        for (const TraceRecord& r : file.records)
+            if (mask & (1u << r.category)) refs.push_back({&file, &r});
+    }
+    stable_sort(refs.begin(), refs.end(),
+                [](const Ref& x, const Ref& y) { return x.record->wallNs < y.record->wallNs; });
+
+    ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file) {
+            cerr << "[ERROR] Could not write " << output << "\n";
+            return 1;
+        }
+    }
+    ostream& out = output.empty() ? cout : file;
+
+    if (format == "csv")
+        out << "wall_ms,sim_s,pid,category,event,id,aux,a,b,c\n";
+    out << fixed;
+    for (const Ref& ref : refs) {
+        const TraceRecord& r = *ref.record;
+        const TraceEventInfo* info = TraceEventSchema(r.event);
+        double wallMs = (static_cast<int64_t>(r.wallNs) - origin) / 1e6;
+        string event = info ? info->name : "event" + to_string(r.event);
+        string id = info && info->idIsName ? ref.file->Name(r.id) : to_string(r.id);
+        string aux = info && info->auxIsName ? ref.file->Name(r.aux) : to_string(r.aux);
+
+        if (format == "csv") {
+            // Fields the event does not use stay empty
+            out << setprecision(6) << wallMs << ',';
+            if (r.simNs >= 0) out << setprecision(9) << r.simNs / 1e9;
+            out << ',' << ref.file->pid << ',' << TraceCategoryName(r.category) << ',' << event << ','
+                << csvQuote(id) << ',';
+            if (!info || info->aux) out << csvQuote(aux);
+            out << defaultfloat << setprecision(10);
+            const char* labels[] = {info ? info->a : "a", info ? info->b : "b", info ? info->c : "c"};
+            double values[] = {r.a, r.b, r.c};
+            for (int k = 0; k < 3; ++k) {
+                out << ',';
+                if (labels[k]) out << values[k];
+            }
+            out << fixed << '\n';
+            continue;
+        }
+
+        out << setprecision(3) << setw(12) << wallMs << " ms  ";
+        if (r.simNs >= 0) out << "sim " << setprecision(6) << setw(12) << r.simNs / 1e9 << " s  ";
+        else out << string(20, ' ');
+        out << left << setw(8) << TraceCategoryName(r.category) << setw(13) << event << right;
+        if (!info) {
+            out << "id=" << r.id << " aux=" << r.aux << " a=" << r.a << " b=" << r.b << " c=" << r.c << '\n';
+            continue;
+        }
+        out << info->id << '=' << id;
+        if (info->aux) out << ' ' << info->aux << '=' << aux;
+        out << defaultfloat << setprecision(6);
+        if (info->a) out << ' ' << info->a << '=' << r.a;
+        if (info->b) out << ' ' << info->b << '=' << r.b;
+        if (info->c) out << ' ' << info->c << '=' << r.c;
+        out << fixed << '\n';
+    }
+    cerr << "[INFO] " << refs.size() << " records from " << files.size() << " file(s)"
+         << (output.empty() ? "" : " written to " + output) << "\n";
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include "routingGraph.h"
 
 using namespace ns3;
 
@@ -18,6 +19,48 @@ struct NodeConfig {
     std::vector<std::string> links;
 };
 
+// A parsed scenario file, shared by every menu action (see scenarioParser.h)
+struct Scenario {
+    std::string source;
+    std::vector<NodeConfig> nodes;                   // in file order
+    std::unordered_map<std::string, uint32_t> index; // name -> nodes[] (last definition)
+
+    const NodeConfig* find(const std::string& name) const
+    {
+        auto it = index.find(name);
+        return it == index.end() ? nullptr : &nodes[it->second];
+    }
+};
+
+// One tx -> rx link scheduled by startSimulation()
+struct LinkJob {
+    std::string txName;
+    std::string rxName;
+    double distance{};
+    double freqMHz{};
+    double txPowerdBm{};
+    std::string rate;
+};
+
+// Outcome of one simulated link (plain data so it can cross process boundaries)
+struct LinkResult {
+    uint32_t packetsSent{};
+    uint32_t packetsReceived{};
+    double meanRttMs{};
+};
+
+// KPIs of one runLunarDtCI() run, from the UEs' last RSRP/SINR reports
+struct CiResult {
+    uint32_t numEnb{};
+    uint32_t numUe{};
+    uint32_t ueReports{};   // UEs that reported at least once
+    double meanRsrpDbm{};
+    double meanSinrDb{};
+    double p5SinrDb{};      // cell-edge (5th percentile) SINR
+    double minSinrDb{};
+    double wallMs{};        // setup, run and teardown
+};
+
 // Helper: install ConstantPositionMobilityModel on a node and set its position
 inline void SetNodePosition(Ptr<Node> node, const Vector& pos)
 {
@@ -27,7 +70,6 @@ inline void SetNodePosition(Ptr<Node> node, const Vector& pos)
     node->GetObject<MobilityModel>()->SetPosition(pos);
 }
 
-struct NodePosition;
 std::vector<std::string> findOptimalPath(
     const std::unordered_map<std::string, NodePosition>& nodes,
     const std::unordered_map<std::string, std::vector<std::string>>& adjacency,
@@ -0,0 +1,499 @@
+#include "binaryTrace.h"
+#include "ns3/core-module.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+
+std::atomic<uint32_t> g_traceMask{0};
+
+static ns3::GlobalValue g_traceCategories("LdtTrace",
+                                          "Binary trace categories: link,echo,ci,contact or all "
+                                          "(empty = off, see binaryTrace.h)",
+                                          ns3::StringValue(""),
+                                          ns3::MakeStringChecker());
+static ns3::GlobalValue g_traceFile("LdtTraceFile",
+                                    "File written by the binary trace",
+                                    ns3::StringValue("./scratch/output/ldt_trace.ldtt"),
+                                    ns3::MakeStringChecker());
+
+static const char* const kCategoryNames[] = {"link", "echo", "ci", "contact"};
+
+static const TraceEventInfo kTraceSchema[] = {
+    {TraceEvent::LinkStart, kTraceLink, "link_start", "link", true, "rate", true,
+     "distance_m", "freq_mhz", "tx_power_dbm"},
+    {TraceEvent::LinkResult, kTraceLink, "link_result", "link", true, "cached", false,
+     "sent", "received", "mean_rtt_ms"},
+    {TraceEvent::EchoTx, kTraceEcho, "echo_tx", "link", true, "bytes", false, nullptr, nullptr, nullptr},
+    {TraceEvent::EchoRx, kTraceEcho, "echo_rx", "link", true, "bytes", false, "rtt_ms", nullptr, nullptr},
+    {TraceEvent::UeReport, kTraceCi, "ue_report", "ue", false, "cell", false,
+     "rsrp_dbm", "sinr_db", nullptr},
+    {TraceEvent::ContactUp, kTraceContact, "contact_up", "contact", true, nullptr, false,
+     "delay_ms", nullptr, nullptr},
+    {TraceEvent::ContactDown, kTraceContact, "contact_down", "contact", true, nullptr, false,
+     nullptr, nullptr, nullptr},
+};
+
+const TraceEventInfo* TraceEventSchema(uint8_t event)
+{
+    for (const TraceEventInfo& info : kTraceSchema)
+        if (static_cast<uint8_t>(info.event) == event) return &info;
+    return nullptr;
+}
+
+// Interned names, shared by every session of the process (and inherited by
+// forked workers, whose files therefore carry the parent's names too)
+static std::mutex g_traceNameLock;
+static std::vector<std::string> g_traceNames;
+static std::unordered_map<std::string, uint32_t> g_traceNameIds;
+
+static thread_local uint32_t t_traceLink = 0;
+
+static const char kHeaderMagic[8] = {'L', 'D', 'T', 'T', 'R', 'C', '0', '1'};
+static const char kFooterMagic[8] = {'L', 'D', 'T', 'T', 'R', 'E', 'N', 'D'};
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t categories;
+    int64_t startNs;
+    uint32_t pid;
+    uint32_t reserved;
+};
+struct TraceFileFooter {
+    uint64_t namesOffset;
+    uint64_t nameCount;
+    uint64_t dropped;
+    char magic[8];
+};
+static_assert(sizeof(TraceFileHeader) == 32 && sizeof(TraceFileFooter) == 32);
+
+static uint64_t traceWallNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+static bool traceWriteAll(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Bounded multi-producer ring (per-slot sequence numbers, as in Vyukov's
+// MPMC queue) with the writer thread as its only consumer. A producer
+// claims a slot with one CAS on head_, fills it and publishes it by
+// bumping the slot's sequence; the writer drains published slots in order
+// and hands them back a lap later.
+class TraceSession {
+public:
+    ~TraceSession() { Close(); }
+
+    bool Open(const std::string& path, uint32_t categories, size_t capacity);
+    TraceSessionStats Close();
+    void AfterFork();
+
+    bool IsOpen() const { return fd_ >= 0; }
+
+    void Push(const TraceRecord& record)
+    {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return;
+                }
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);   // full: the writer is behind
+                return;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        TraceRecord record;
+    };
+    static constexpr size_t kBatch = 4096;
+
+    void writerLoop();
+    size_t drain();
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_{};
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) uint64_t tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> running_{false};
+    std::unique_ptr<std::thread> writer_;
+    std::vector<TraceRecord> batch_;
+    int fd_{-1};
+    bool ioError_{false};
+    uint64_t written_{};
+    std::string path_;
+    uint32_t categories_{};
+};
+
+bool TraceSession::Open(const std::string& path, uint32_t categories, size_t capacity)
+{
+    capacity = std::bit_ceil(std::max<size_t>(capacity, 1024));
+    if (!slots_ || mask_ + 1 != capacity) slots_ = std::make_unique<Slot[]>(capacity);
+    mask_ = capacity - 1;
+    for (size_t i = 0; i < capacity; ++i)
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_relaxed);
+    tail_ = 0;
+    dropped_.store(0, std::memory_order_relaxed);
+    ioError_ = false;
+    written_ = 0;
+    batch_.reserve(kBatch);
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+
+    TraceFileHeader header{};
+    std::memcpy(header.magic, kHeaderMagic, sizeof(header.magic));
+    header.recordSize = sizeof(TraceRecord);
+    header.categories = categories;
+    header.startNs = static_cast<int64_t>(traceWallNs());
+    header.pid = static_cast<uint32_t>(getpid());
+    if (!traceWriteAll(fd_, &header, sizeof(header))) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    path_ = path;
+    categories_ = categories;
+    running_.store(true, std::memory_order_release);
+    writer_ = std::make_unique<std::thread>(&TraceSession::writerLoop, this);
+    return true;
+}
+
+size_t TraceSession::drain()
+{
+    batch_.clear();
+    while (batch_.size() < kBatch) {
+        Slot& slot = slots_[tail_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) break;
+        batch_.push_back(slot.record);
+        slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        ++tail_;
+    }
+    if (batch_.empty()) return 0;
+    if (!ioError_ && traceWriteAll(fd_, batch_.data(), batch_.size() * sizeof(TraceRecord)))
+        written_ += batch_.size();
+    else {
+        ioError_ = true;
+        dropped_.fetch_add(batch_.size(), std::memory_order_relaxed);
+    }
+    return batch_.size();
+}
+
+void TraceSession::writerLoop()
+{
+    while (running_.load(std::memory_order_acquire))
+        if (drain() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    while (drain() > 0) {
+    }
+}
+
+TraceSessionStats TraceSession::Close()
+{
+    TraceSessionStats stats;
+    if (fd_ < 0) return stats;
+    running_.store(false, std::memory_order_release);
+    if (writer_) {
+        writer_->join();
+        writer_.reset();
+    }
+
+    TraceFileFooter footer{};
+    off_t namesOffset = lseek(fd_, 0, SEEK_CUR);
+    bool ok = !ioError_ && namesOffset >= 0;
+    {
+        std::lock_guard<std::mutex> lock(g_traceNameLock);
+        for (size_t i = 0; ok && i < g_traceNames.size(); ++i) {
+            uint32_t length = static_cast<uint32_t>(g_traceNames[i].size());
+            ok = traceWriteAll(fd_, &length, sizeof(length)) &&
+                 traceWriteAll(fd_, g_traceNames[i].data(), length);
+        }
+        footer.nameCount = g_traceNames.size();
+    }
+    footer.namesOffset = static_cast<uint64_t>(namesOffset);
+    footer.dropped = dropped_.load(std::memory_order_relaxed);
+    std::memcpy(footer.magic, kFooterMagic, sizeof(footer.magic));
+    if (ok) traceWriteAll(fd_, &footer, sizeof(footer));
+    close(fd_);
+    fd_ = -1;
+
+    stats.path = path_;
+    stats.written = written_;
+    stats.dropped = footer.dropped;
+    return stats;
+}
+
+void TraceSession::AfterFork()
+{
+    if (fd_ < 0) return;
+    // The writer thread exists only in the parent: forget it without
+    // joining, and leave the parent's file to the parent
+    (void)writer_.release();
+    close(fd_);
+    fd_ = -1;
+    if (!Open(path_ + "." + std::to_string(getpid()), categories_, mask_ + 1))
+        g_traceMask.store(0, std::memory_order_relaxed);
+}
+
+static std::unique_ptr<TraceSession> g_traceSession;
+
+std::vector<std::string> WorkerTraceFiles(const std::string& path)
+{
+    std::vector<std::string> files;
+    std::filesystem::path base(path);
+    std::filesystem::path dir = base.parent_path().empty() ? std::filesystem::path(".") : base.parent_path();
+    std::string prefix = base.filename().string() + ".";
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+        if (!std::all_of(name.begin() + prefix.size(), name.end(),
+                         [](unsigned char c) { return std::isdigit(c); }))
+            continue;
+        files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool StartTrace(const std::string& path, uint32_t categories, size_t capacity)
+{
+    StopTrace();
+    std::error_code ec;
+    for (const std::string& stale : WorkerTraceFiles(path))
+        std::filesystem::remove(stale, ec);
+    if (!g_traceSession) g_traceSession = std::make_unique<TraceSession>();
+    if (!g_traceSession->Open(path, categories, capacity)) {
+        std::cerr << "[ERROR] Could not open trace file " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    g_traceMask.store(categories, std::memory_order_release);
+    return true;
+}
+
+void SetTraceCategories(uint32_t categories)
+{
+    if (TraceActive()) g_traceMask.store(categories, std::memory_order_release);
+}
+
+TraceSessionStats StopTrace()
+{
+    g_traceMask.store(0, std::memory_order_release);
+    if (!g_traceSession) return TraceSessionStats();
+    return g_traceSession->Close();
+}
+
+bool TraceActive()
+{
+    return g_traceSession && g_traceSession->IsOpen();
+}
+
+void TraceForkChild()
+{
+    if (TraceActive()) g_traceSession->AfterFork();
+}
+
+bool ParseTraceCategories(const std::string& list, uint32_t& mask)
+{
+    mask = 0;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (item.empty()) continue;
+        if (item == "all") {
+            mask |= kTraceAll;
+            continue;
+        }
+        auto name = std::find(std::begin(kCategoryNames), std::end(kCategoryNames), item);
+        if (name == std::end(kCategoryNames)) return false;
+        mask |= 1u << (name - std::begin(kCategoryNames));
+    }
+    return true;
+}
+
+std::string TraceCategoryNames(uint32_t mask)
+{
+    std::string names;
+    for (size_t i = 0; i < std::size(kCategoryNames); ++i) {
+        if (!(mask & (1u << i))) continue;
+        if (!names.empty()) names += ',';
+        names += kCategoryNames[i];
+    }
+    return names.empty() ? "none" : names;
+}
+
+std::string TraceCategoryName(uint8_t bit)
+{
+    if (bit < std::size(kCategoryNames)) return kCategoryNames[bit];
+    return "cat" + std::to_string(bit);
+}
+
+std::string TraceFileSetting()
+{
+    ns3::StringValue value;
+    g_traceFile.GetValue(value);
+    return value.Get();
+}
+
+bool TraceFromEnvironment()
+{
+    ns3::StringValue list;
+    g_traceCategories.GetValue(list);
+    if (list.Get().empty()) return false;
+    uint32_t mask;
+    if (!ParseTraceCategories(list.Get(), mask)) {
+        std::cerr << "[WARNING] LdtTrace: unknown category in '" << list.Get() << "', tracing off.\n";
+        return false;
+    }
+    return mask != 0 && StartTrace(TraceFileSetting(), mask);
+}
+
+uint32_t TraceIntern(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(g_traceNameLock);
+    auto [it, added] = g_traceNameIds.emplace(std::string(name), uint32_t(g_traceNames.size() + 1));
+    if (added) g_traceNames.emplace_back(name);
+    return it->second;
+}
+
+void TraceSetLink(uint32_t id)
+{
+    t_traceLink = id;
+}
+
+uint32_t TraceCurrentLink()
+{
+    return t_traceLink;
+}
+
+void TraceWrite(TraceCategory category, TraceEvent event, uint32_t id, int64_t simNs,
+                uint64_t aux, double a, double b, double c)
+{
+    if (!g_traceSession) return;
+    TraceRecord record;
+    record.wallNs = traceWallNs();
+    record.simNs = simNs;
+    record.category = static_cast<uint8_t>(std::countr_zero(static_cast<uint32_t>(category)));
+    record.event = static_cast<uint8_t>(event);
+    record.reserved = 0;
+    record.id = id;
+    record.aux = aux;
+    record.a = a;
+    record.b = b;
+    record.c = c;
+    g_traceSession->Push(record);
+}
+
+std::string TraceFileContents::Name(uint64_t id) const
+{
+    if (id == 0) return "-";
+    if (id <= names.size()) return names[id - 1];
+    return "#" + std::to_string(id);
+}
+
+bool ReadTraceFile(const std::string& path, TraceFileContents& out, std::string& error)
+{
+    out = TraceFileContents();
+    out.path = path;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    TraceFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kHeaderMagic, sizeof(header.magic)) != 0) {
+        error = path + " is not a trace file";
+        return false;
+    }
+    if (header.recordSize != sizeof(TraceRecord)) {
+        error = path + " has " + std::to_string(header.recordSize) + "-byte records, expected " +
+                std::to_string(sizeof(TraceRecord));
+        return false;
+    }
+    out.categories = header.categories;
+    out.startNs = header.startNs;
+    out.pid = header.pid;
+
+    in.seekg(0, std::ios::end);
+    uint64_t size = static_cast<uint64_t>(in.tellg());
+    uint64_t recordsEnd = size;
+    TraceFileFooter footer{};
+    if (size >= sizeof(header) + sizeof(footer)) {
+        in.seekg(static_cast<std::streamoff>(size - sizeof(footer)));
+        if (in.read(reinterpret_cast<char*>(&footer), sizeof(footer)) &&
+            std::memcmp(footer.magic, kFooterMagic, sizeof(footer.magic)) == 0 &&
+            footer.namesOffset >= sizeof(header) && footer.namesOffset <= size - sizeof(footer)) {
+            out.complete = true;
+            out.dropped = footer.dropped;
+            recordsEnd = footer.namesOffset;
+        }
+    }
+
+    uint64_t count = (recordsEnd - sizeof(header)) / sizeof(TraceRecord);
+    out.records.resize(count);
+    in.clear();
+    in.seekg(sizeof(header));
+    if (!in.read(reinterpret_cast<char*>(out.records.data()),
+                 static_cast<std::streamsize>(count * sizeof(TraceRecord)))) {
+        error = "short read in " + path;
+        return false;
+    }
+    if (!out.complete) return true;
+
+    in.seekg(static_cast<std::streamoff>(footer.namesOffset));
+    out.names.reserve(footer.nameCount);
+    for (uint64_t i = 0; i < footer.nameCount; ++i) {
+        uint32_t length;
+        if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > size) break;
+        std::string name(length, '\0');
+        if (!in.read(name.data(), length)) break;
+        out.names.push_back(std::move(name));
+    }
+    return true;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Structured binary trace. Events are fixed-size typed records pushed into
+// a preallocated lock-free ring; a background thread drains it to a file,
+// so emitting a record never formats text or blocks on I/O. When the ring
+// is full records are dropped (and counted), never waited for.
+//
+// Every category is a bit of a runtime mask; a disabled category costs one
+// relaxed atomic load and a branch at the call site (the typed Trace*()
+// helpers below do the test inline). Start a session at start-up with
+//
+//   NS_GLOBAL_VALUE="LdtTrace=link,echo"      (or "all")
+//
+// (file: LdtTraceFile) or from the LDT_main menu. Forked workers write
+// their own <file>.<pid>; LDT_trace decodes and merges them to text or CSV.
+//
+// File layout (little-endian): 32-byte header ("LDTTRC01", record size,
+// category mask, start time, pid), the records, then the name table
+// (uint32 length + bytes per interned name, id 1 first) and a 32-byte
+// footer (name table offset, name count, dropped records, "LDTTREND").
+// A file cut short by a crash has no footer; its whole records still decode.
+
+enum TraceCategory : uint32_t {
+    kTraceLink = 1u << 0,     // one start/result record per simulated link
+    kTraceEcho = 1u << 1,     // every echo request/reply of a link run
+    kTraceCi = 1u << 2,       // UE RSRP/SINR reports of the CI LTE run
+    kTraceContact = 1u << 3,  // contact windows opening and closing
+    kTraceAll = kTraceLink | kTraceEcho | kTraceCi | kTraceContact,
+};
+
+enum class TraceEvent : uint8_t {
+    LinkStart = 1,
+    LinkResult,
+    EchoTx,
+    EchoRx,
+    UeReport,
+    ContactUp,
+    ContactDown,
+};
+
+// Unused fields are zero. Names (links, rates, contacts) travel as ids of
+// the file's name table, see TraceIntern().
+struct TraceRecord {
+    uint64_t wallNs;     // CLOCK_REALTIME, comparable across processes
+    int64_t simNs;       // simulator time, -1 outside a run
+    uint8_t category;    // bit index of the TraceCategory
+    uint8_t event;       // TraceEvent
+    uint16_t reserved;
+    uint32_t id;
+    uint64_t aux;
+    double a, b, c;
+};
+static_assert(sizeof(TraceRecord) == 56, "trace record layout is part of the file format");
+
+// How each event's fields are labelled by the decoder; a null label means
+// the field is unused, idIsName/auxIsName mark name table ids
+struct TraceEventInfo {
+    TraceEvent event;
+    TraceCategory category;
+    const char* name;
+    const char* id;
+    bool idIsName;
+    const char* aux;
+    bool auxIsName;
+    const char* a;
+    const char* b;
+    const char* c;
+};
+const TraceEventInfo* TraceEventSchema(uint8_t event);
+
+extern std::atomic<uint32_t> g_traceMask;
+inline bool TraceEnabled(uint32_t categories)
+{
+    return (g_traceMask.load(std::memory_order_relaxed) & categories) != 0;
+}
+
+// Start writing to path (ring of capacity records, rounded up to a power
+// of two) with the given categories; stops a running session first
+bool StartTrace(const std::string& path, uint32_t categories, size_t capacity = 1 << 16);
+// Narrow or widen the categories of the running session
+void SetTraceCategories(uint32_t categories);
+
+struct TraceSessionStats {
+    std::string path;
+    uint64_t written{};
+    uint64_t dropped{};
+};
+// Drain the ring, append the name table and close the file. Call it once
+// the threads emitting records are done.
+TraceSessionStats StopTrace();
+bool TraceActive();
+
+// Apply the LdtTrace/LdtTraceFile global values; returns whether a session
+// was started
+bool TraceFromEnvironment();
+std::string TraceFileSetting();
+// "link,echo" or "all" -> mask; false on an unknown name
+bool ParseTraceCategories(const std::string& list, uint32_t& mask);
+std::string TraceCategoryNames(uint32_t mask);
+// Name of the category stored in TraceRecord::category
+std::string TraceCategoryName(uint8_t bit);
+
+// In a freshly forked worker: the parent's writer thread is gone, so the
+// session continues in <path>.<pid> with the same categories
+void TraceForkChild();
+// Worker traces <path>.<pid> next to path, in name order (StartTrace
+// removes those left by an earlier session)
+std::vector<std::string> WorkerTraceFiles(const std::string& path);
+
+// Id of a name in the file's name table (0 is reserved for "none").
+// Takes a lock; intern once per link, not per event.
+uint32_t TraceIntern(std::string_view name);
+
+// Link that records emitted by the link simulations refer to
+void TraceSetLink(uint32_t id);
+uint32_t TraceCurrentLink();
+
+// Out-of-line push; callers test TraceEnabled() first
+void TraceWrite(TraceCategory category, TraceEvent event, uint32_t id, int64_t simNs,
+                uint64_t aux = 0, double a = 0.0, double b = 0.0, double c = 0.0);
+
+// --- Typed records -------------------------------------------------------
+
+inline void TraceLinkStart(uint32_t link, uint32_t rate, double distanceM, double freqMHz,
+                           double txPowerdBm)
+{
+    if (TraceEnabled(kTraceLink))
+        TraceWrite(kTraceLink, TraceEvent::LinkStart, link, -1, rate, distanceM, freqMHz, txPowerdBm);
+}
+
+inline void TraceLinkResult(uint32_t link, bool cached, uint32_t sent, uint32_t received,
+                            double meanRttMs)
+{
+    if (TraceEnabled(kTraceLink))
+        TraceWrite(kTraceLink, TraceEvent::LinkResult, link, -1, cached, sent, received, meanRttMs);
+}
+
+inline void TraceEchoTx(uint32_t link, int64_t simNs, uint32_t bytes)
+{
+    if (TraceEnabled(kTraceEcho))
+        TraceWrite(kTraceEcho, TraceEvent::EchoTx, link, simNs, bytes);
+}
+
+inline void TraceEchoRx(uint32_t link, int64_t simNs, uint32_t bytes, double rttMs)
+{
+    if (TraceEnabled(kTraceEcho))
+        TraceWrite(kTraceEcho, TraceEvent::EchoRx, link, simNs, bytes, rttMs);
+}
+
+inline void TraceUeReport(uint32_t ue, int64_t simNs, uint16_t cellId, double rsrpDbm, double sinrDb)
+{
+    if (TraceEnabled(kTraceCi))
+        TraceWrite(kTraceCi, TraceEvent::UeReport, ue, simNs, cellId, rsrpDbm, sinrDb);
+}
+
+inline void TraceContact(uint32_t contact, int64_t simNs, bool up, double delayMs)
+{
+    if (TraceEnabled(kTraceContact))
+        TraceWrite(kTraceContact, up ? TraceEvent::ContactUp : TraceEvent::ContactDown, contact, simNs,
+                   0, up ? delayMs : 0.0);
+}
+
+// --- Decoding ------------------------------------------------------------
+
+struct TraceFileContents {
+    std::string path;
+    uint32_t categories{};
+    int64_t startNs{};
+    uint32_t pid{};
+    bool complete{};             // footer present
+    uint64_t dropped{};
+    std::vector<TraceRecord> records;
+    std::vector<std::string> names; // names[id - 1]
+
+    std::string Name(uint64_t id) const;
+};
+
+bool ReadTraceFile(const std::string& path, TraceFileContents& out, std::string& error);
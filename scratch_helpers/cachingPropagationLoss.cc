@@ -0,0 +1,133 @@
+#include "cachingPropagationLoss.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(CachingPropagationLossModel);
+
+TypeId CachingPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::CachingPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<CachingPropagationLossModel>()
+            .AddAttribute("Inner",
+                          "The wrapped propagation loss model.",
+                          PointerValue(),
+                          MakePointerAccessor(&CachingPropagationLossModel::m_inner),
+                          MakePointerChecker<PropagationLossModel>())
+            .AddAttribute("InnerType",
+                          "Type of the wrapped model when Inner is not set; its attributes "
+                          "come from the usual Config::SetDefault values.",
+                          TypeIdValue(LogDistancePropagationLossModel::GetTypeId()),
+                          MakeTypeIdAccessor(&CachingPropagationLossModel::m_innerType),
+                          MakeTypeIdChecker());
+    return tid;
+}
+
+CachingPropagationLossModel::CachingPropagationLossModel()
+{
+}
+
+void CachingPropagationLossModel::SetInner(Ptr<PropagationLossModel> inner)
+{
+    m_inner = inner;
+    cache_.clear();
+}
+
+Ptr<PropagationLossModel> CachingPropagationLossModel::GetInner() const
+{
+    return m_inner;
+}
+
+void CachingPropagationLossModel::DoDispose()
+{
+    for (Endpoint& e : endpoints_) {
+        e.model->TraceDisconnectWithoutContext(
+            "CourseChange", MakeCallback(&CachingPropagationLossModel::CourseChanged, this));
+    }
+    endpoints_.clear();
+    endpointIds_.clear();
+    cache_.clear();
+    m_inner = nullptr;
+    PropagationLossModel::DoDispose();
+}
+
+// Dense id per mobility model; the first sighting subscribes to its course
+// changes. Holding the Ptr keeps the address from being reused.
+uint32_t CachingPropagationLossModel::endpointOf(Ptr<MobilityModel> m) const
+{
+    auto it = endpointIds_.find(PeekPointer(m));
+    if (it != endpointIds_.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(endpoints_.size());
+    endpoints_.push_back({m, 0});
+    endpointIds_.emplace(PeekPointer(m), id);
+    m->TraceConnectWithoutContext(
+        "CourseChange",
+        MakeCallback(&CachingPropagationLossModel::CourseChanged,
+                     const_cast<CachingPropagationLossModel*>(this)));
+    return id;
+}
+
+// Bumping the version invalidates every cached pair involving m at once
+void CachingPropagationLossModel::CourseChanged(Ptr<const MobilityModel> m)
+{
+    auto it = endpointIds_.find(PeekPointer(m));
+    if (it != endpointIds_.end()) endpoints_[it->second].version++;
+}
+
+double CachingPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                                  Ptr<MobilityModel> a,
+                                                  Ptr<MobilityModel> b) const
+{
+    if (!m_inner) {
+        ObjectFactory factory;
+        factory.SetTypeId(m_innerType);
+        const_cast<CachingPropagationLossModel*>(this)->m_inner = factory.Create<PropagationLossModel>();
+    }
+
+    uint32_t ia = endpointOf(a);
+    uint32_t ib = endpointOf(b);
+    uint32_t va = endpoints_[ia].version;
+    uint32_t vb = endpoints_[ib].version;
+    uint64_t key = (static_cast<uint64_t>(ia) << 32) | ib;
+
+    auto it = cache_.find(key);
+    if (it != cache_.end() && it->second.txVersion == va && it->second.rxVersion == vb &&
+        it->second.txPowerDbm == txPowerDbm) {
+        ++hits_;
+        return it->second.rxPowerDbm;
+    }
+
+    ++misses_;
+    double rx = m_inner->CalcRxPower(txPowerDbm, a, b);
+    cache_[key] = {txPowerDbm, rx, va, vb};
+    return rx;
+}
+
+int64_t CachingPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return m_inner ? m_inner->AssignStreams(stream) : 0;
+}
+
+} // namespace ns3
+
+ns3::Ptr<ns3::PropagationLossModel> MakeCachingLossModel(ns3::Ptr<ns3::PropagationLossModel> model)
+{
+    ns3::Ptr<ns3::CachingPropagationLossModel> cache = ns3::CreateObject<ns3::CachingPropagationLossModel>();
+    cache->SetInner(model);
+    return cache;
+}
+
+static ns3::GlobalValue g_cachePathLoss("LdtCachePathLoss",
+                                        "Memoize path loss per node pair in the lunar link simulations",
+                                        ns3::BooleanValue(false),
+                                        ns3::MakeBooleanChecker());
+
+bool PathLossCachingEnabled()
+{
+    ns3::BooleanValue value;
+    g_cachePathLoss.GetValue(value);
+    return value.Get();
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+// Propagation loss model that memoizes another (deterministic) loss model
+// per (tx mobility, rx mobility) pair. An entry stays valid until either
+// endpoint fires its CourseChange trace or the tx power differs, so static
+// nodes pay for the inner model once per pair instead of once per packet.
+// Do not wrap models with random fading; their draws would be frozen.
+class CachingPropagationLossModel : public PropagationLossModel {
+public:
+    static TypeId GetTypeId();
+
+    CachingPropagationLossModel();
+
+    // Wrapped model; if unset, one of type InnerType is created on first use
+    void SetInner(Ptr<PropagationLossModel> inner);
+    Ptr<PropagationLossModel> GetInner() const;
+
+    uint64_t GetHits() const { return hits_; }
+    uint64_t GetMisses() const { return misses_; }
+
+protected:
+    void DoDispose() override;
+
+private:
+    struct Endpoint {
+        Ptr<MobilityModel> model;
+        uint32_t version;
+    };
+    struct Entry {
+        double txPowerDbm;
+        double rxPowerDbm;
+        uint32_t txVersion;
+        uint32_t rxVersion;
+    };
+
+    double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    uint32_t endpointOf(Ptr<MobilityModel> m) const;
+    void CourseChanged(Ptr<const MobilityModel> m);
+
+    Ptr<PropagationLossModel> m_inner;
+    TypeId m_innerType;
+
+    mutable std::unordered_map<const MobilityModel*, uint32_t> endpointIds_;
+    mutable std::vector<Endpoint> endpoints_;
+    mutable std::unordered_map<uint64_t, Entry> cache_;
+    mutable uint64_t hits_{};
+    mutable uint64_t misses_{};
+};
+
+} // namespace ns3
+
+// Wrap model in a CachingPropagationLossModel
+ns3::Ptr<ns3::PropagationLossModel> MakeCachingLossModel(ns3::Ptr<ns3::PropagationLossModel> model);
+
+// Global switch for the ns-3 link simulations (lunarTransmissionSim.cc),
+// settable with NS_GLOBAL_VALUE="LdtCachePathLoss=true"
+bool PathLossCachingEnabled();
@@ -0,0 +1,411 @@
+#include "contactPlan.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// ---------------------------------------------------------------------
+// Trajectories
+// ---------------------------------------------------------------------
+static NodePosition lerp(const NodePosition& a, const NodePosition& b, double f)
+{
+    return {a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f, a.z + (b.z - a.z) * f};
+}
+
+NodePosition PositionAt(const Trajectory& trajectory, double t)
+{
+    const std::vector<TrajectoryPoint>& pts = trajectory.points;
+    if (pts.empty()) return {0.0, 0.0, 0.0};
+    if (t <= pts.front().t) return pts.front().p;
+    if (t >= pts.back().t) return pts.back().p;
+    auto it = std::upper_bound(pts.begin(), pts.end(), t,
+                               [](double v, const TrajectoryPoint& p) { return v < p.t; });
+    const TrajectoryPoint& b = *it;
+    const TrajectoryPoint& a = *(it - 1);
+    return lerp(a.p, b.p, (t - a.t) / (b.t - a.t));
+}
+
+void SampleCircularOrbit(const CircularOrbit& orbit, double t0, double t1, double stepS, Trajectory& out)
+{
+    const double deg = M_PI / 180.0;
+    const double r = kMoonRadiusM + orbit.altitudeM;
+    const double ci = std::cos(orbit.inclinationDeg * deg), si = std::sin(orbit.inclinationDeg * deg);
+    const double co = std::cos(orbit.raanDeg * deg), so = std::sin(orbit.raanDeg * deg);
+    auto at = [&](double t) {
+        double u = orbit.phaseDeg * deg + 2.0 * M_PI * t / orbit.periodS;
+        double xp = r * std::cos(u), yp = r * std::sin(u);
+        // Rotate the orbital plane (inclination about x, then node about the
+        // local vertical) and move the origin from the Moon's centre to the
+        // scenario frame
+        double x = xp * co - yp * ci * so;
+        double y = xp * so + yp * ci * co;
+        double z = yp * si;
+        return NodePosition{x, y, z - kMoonRadiusM};
+    };
+    out.points.clear();
+    size_t steps = static_cast<size_t>(std::ceil((t1 - t0) / std::max(stepS, 1e-3)));
+    out.points.reserve(steps + 1);
+    for (size_t i = 0; i <= steps; ++i) {
+        double t = std::min(t0 + i * stepS, t1);
+        out.points.push_back({t, at(t)});
+    }
+}
+
+static bool parseKeyValue(const std::string& token, std::string& key, double& value)
+{
+    size_t eq = token.find('=');
+    if (eq == std::string::npos) return false;
+    key = token.substr(0, eq);
+    try {
+        value = std::stod(token.substr(eq + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+bool LoadTrajectories(const std::string& path, double t0, double t1, double orbitStepS,
+                      std::vector<Trajectory>& trajectories)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "[ERROR] Could not open " << path << '\n';
+        return false;
+    }
+    trajectories.clear();
+    bool ok = true;
+    Trajectory* open = nullptr;   // TRAJECTORY block taking point lines
+    std::string line;
+    size_t lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        std::string word;
+        if (!(fields >> word)) continue;
+        auto fail = [&](const std::string& message) {
+            std::cerr << path << ":" << lineNo << ": " << message << '\n';
+            ok = false;
+        };
+
+        if (word == "TRAJECTORY" || word == "STATIC" || word == "ORBIT") {
+            open = nullptr;
+            Trajectory trajectory;
+            if (!(fields >> trajectory.name)) {
+                fail("missing node name");
+                continue;
+            }
+            if (word == "STATIC") {
+                NodePosition p;
+                if (!(fields >> p.x >> p.y >> p.z)) {
+                    fail("expected STATIC <name> <x> <y> <z>");
+                    continue;
+                }
+                trajectory.points.push_back({t0, p});
+            } else if (word == "ORBIT") {
+                CircularOrbit orbit;
+                std::string token, key;
+                double value;
+                while (fields >> token) {
+                    if (!parseKeyValue(token, key, value)) fail("bad orbit parameter '" + token + "'");
+                    else if (key == "altitude") orbit.altitudeM = value;
+                    else if (key == "inclination") orbit.inclinationDeg = value;
+                    else if (key == "raan") orbit.raanDeg = value;
+                    else if (key == "phase") orbit.phaseDeg = value;
+                    else if (key == "period") orbit.periodS = value;
+                    else fail("unknown orbit parameter '" + key + "'");
+                }
+                if (orbit.periodS <= 0.0) {
+                    fail("orbit period must be positive");
+                    continue;
+                }
+                SampleCircularOrbit(orbit, t0, t1, orbitStepS, trajectory);
+            }
+            trajectories.push_back(std::move(trajectory));
+            if (word == "TRAJECTORY") open = &trajectories.back();
+            continue;
+        }
+
+        TrajectoryPoint point;
+        std::istringstream numbers(line);
+        if (!open || !(numbers >> point.t >> point.p.x >> point.p.y >> point.p.z)) {
+            fail("unexpected line");
+            continue;
+        }
+        if (!open->points.empty() && point.t <= open->points.back().t) {
+            fail("trajectory times must increase");
+            continue;
+        }
+        open->points.push_back(point);
+    }
+    for (const Trajectory& t : trajectories) {
+        if (t.points.empty()) {
+            std::cerr << path << ": trajectory " << t.name << " has no points\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// ComputeContactPlan()
+// ---------------------------------------------------------------------
+namespace {
+
+struct Vec3 {
+    double x, y, z;
+};
+
+inline Vec3 operator-(const NodePosition& a, const NodePosition& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+struct Box {
+    double lo[3], hi[3];
+};
+
+// Everything one pair needs inside one slab
+class PairSolver {
+public:
+    PairSolver(const std::vector<Trajectory>& trajectories, const ContactRules& rules)
+        : trajectories_(trajectories), rules_(rules), centre_{0.0, 0.0, -rules.moonRadiusM}
+    {
+    }
+
+    // Contact intervals of a and b within [s, e], in time order
+    void solve(uint32_t a, uint32_t b, double s, double e, std::vector<ContactWindow>& out)
+    {
+        const Trajectory& ta = trajectories_[a];
+        const Trajectory& tb = trajectories_[b];
+        breaks_.clear();
+        breaks_.push_back(s);
+        addBreaks(ta, s, e);
+        addBreaks(tb, s, e);
+        breaks_.push_back(e);
+        std::sort(breaks_.begin(), breaks_.end());
+        breaks_.erase(std::unique(breaks_.begin(), breaks_.end()), breaks_.end());
+
+        const double r2 = rules_.maxRangeM * rules_.maxRangeM;
+        for (size_t k = 0; k + 1 < breaks_.size(); ++k) {
+            double u = breaks_[k], v = breaks_[k + 1];
+            // Both nodes move linearly here, so the squared distance is a
+            // quadratic in the segment fraction f
+            Piece piece{u, v, PositionAt(ta, u), PositionAt(ta, v), PositionAt(tb, u), PositionAt(tb, v)};
+            Vec3 d0 = piece.b0 - piece.a0;
+            Vec3 d1 = piece.b1 - piece.a1;
+            Vec3 dd{d1.x - d0.x, d1.y - d0.y, d1.z - d0.z};
+            double qa = dot(dd, dd), qb = 2.0 * dot(d0, dd), qc = dot(d0, d0) - r2;
+            double f0, f1;
+            if (qa < 1e-12) {
+                if (qc > 0.0) continue;
+                f0 = 0.0;
+                f1 = 1.0;
+            } else {
+                double disc = qb * qb - 4.0 * qa * qc;
+                if (disc < 0.0) continue;
+                double sq = std::sqrt(disc);
+                f0 = std::max(0.0, (-qb - sq) / (2.0 * qa));
+                f1 = std::min(1.0, (-qb + sq) / (2.0 * qa));
+                if (f0 >= f1) continue;
+            }
+            // Distance extremes over [f0, f1]: the ends and the closest approach
+            auto dist = [&](double f) {
+                Vec3 d{d0.x + dd.x * f, d0.y + dd.y * f, d0.z + dd.z * f};
+                return std::sqrt(dot(d, d));
+            };
+            double fMin = qa < 1e-12 ? f0 : std::clamp(-qb / (2.0 * qa), f0, f1);
+            double lo = std::min({dist(f0), dist(f1), dist(fMin)});
+            double hi = std::max(dist(f0), dist(f1));
+            double w0 = u + f0 * (v - u), w1 = u + f1 * (v - u);
+            // No line of sight check needed while the nodes are closer than
+            // the sum of their lowest horizon distances over the piece
+            if (!rules_.occlusion || hi <= horizon(piece.a0, piece.a1) + horizon(piece.b0, piece.b1))
+                append(out, a, b, w0, w1, lo, hi);
+            else
+                visibleParts(piece, w0, w1, lo, hi, out, a, b);
+        }
+    }
+
+private:
+    void addBreaks(const Trajectory& t, double s, double e)
+    {
+        auto it = std::upper_bound(t.points.begin(), t.points.end(), s,
+                                   [](double v, const TrajectoryPoint& p) { return v < p.t; });
+        for (; it != t.points.end() && it->t < e; ++it) breaks_.push_back(it->t);
+    }
+
+    // One linear piece of both tracks
+    struct Piece {
+        double u, v;
+        NodePosition a0, a1, b0, b1;
+    };
+
+    // Distance to the horizon from the lowest point of the track p0 -> p1
+    double horizon(const NodePosition& p0, const NodePosition& p1) const
+    {
+        Vec3 w = p1 - p0;
+        Vec3 toCentre = centre_ - p0;
+        double ww = dot(w, w);
+        double f = ww > 0.0 ? std::clamp(dot(toCentre, w) / ww, 0.0, 1.0) : 0.0;
+        Vec3 closest{toCentre.x - w.x * f, toCentre.y - w.y * f, toCentre.z - w.z * f};
+        return std::sqrt(std::max(0.0, dot(closest, closest) - rules_.moonRadiusM * rules_.moonRadiusM));
+    }
+
+    bool visible(const Piece& piece, double t) const
+    {
+        double along = piece.v > piece.u ? (t - piece.u) / (piece.v - piece.u) : 0.0;
+        NodePosition pa = lerp(piece.a0, piece.a1, along), pb = lerp(piece.b0, piece.b1, along);
+        Vec3 w = pb - pa;
+        Vec3 toCentre = centre_ - pa;
+        double ww = dot(w, w);
+        double f = ww > 0.0 ? std::clamp(dot(toCentre, w) / ww, 0.0, 1.0) : 0.0;
+        Vec3 closest{toCentre.x - w.x * f, toCentre.y - w.y * f, toCentre.z - w.z * f};
+        return dot(closest, closest) >= (rules_.moonRadiusM - 1e-3) * (rules_.moonRadiusM - 1e-3);
+    }
+
+    // Split [w0, w1] at the occlusion edges, found by stepping losStepS and
+    // bisecting each change of state to a millisecond
+    void visibleParts(const Piece& piece, double w0, double w1, double lo, double hi,
+                      std::vector<ContactWindow>& out, uint32_t a, uint32_t b) const
+    {
+        double step = std::max(rules_.losStepS, 1e-3);
+        bool state = visible(piece, w0);
+        double openedAt = w0;
+        double prev = w0;
+        while (prev < w1) {
+            double next = std::min(prev + step, w1);
+            bool now = visible(piece, next);
+            if (now != state) {
+                double l = prev, r = next;
+                while (r - l > 1e-3) {
+                    double m = 0.5 * (l + r);
+                    (visible(piece, m) == state ? l : r) = m;
+                }
+                if (state) append(out, a, b, openedAt, r, lo, hi);
+                else openedAt = r;
+                state = now;
+            }
+            prev = next;
+        }
+        if (state) append(out, a, b, openedAt, w1, lo, hi);
+    }
+
+    static void append(std::vector<ContactWindow>& out, uint32_t a, uint32_t b, double s, double e, double lo,
+                       double hi)
+    {
+        if (e > s) out.push_back({a, b, s, e, lo, hi});
+    }
+
+    const std::vector<Trajectory>& trajectories_;
+    const ContactRules& rules_;
+    NodePosition centre_;
+    std::vector<double> breaks_;
+};
+
+} // namespace
+
+ContactPlan ComputeContactPlan(const std::vector<Trajectory>& trajectories, const ContactRules& rules,
+                               double t0, double t1, double slabS)
+{
+    ContactPlan plan;
+    const uint32_t n = static_cast<uint32_t>(trajectories.size());
+    if (n < 2 || t1 <= t0) return plan;
+    slabS = std::max(slabS, 1e-3);
+    const double grow = 0.5 * rules.maxRangeM;
+
+    PairSolver solver(trajectories, rules);
+    std::vector<Box> boxes(n);
+    std::vector<uint32_t> order(n), active;
+    std::vector<ContactWindow> pieces;
+    std::unordered_map<uint64_t, size_t> lastWindow;   // pair -> its latest entry in plan.windows
+
+    for (double s = t0; s < t1; s += slabS) {
+        double e = std::min(s + slabS, t1);
+        ++plan.slabs;
+
+        // Bounding box of each node over the slab (its ends and the corners
+        // of its track inside), grown by half the contact range
+        for (uint32_t i = 0; i < n; ++i) {
+            const Trajectory& t = trajectories[i];
+            NodePosition p = PositionAt(t, s);
+            Box& box = boxes[i];
+            box = {{p.x, p.y, p.z}, {p.x, p.y, p.z}};
+            auto extend = [&](const NodePosition& q) {
+                const double c[3] = {q.x, q.y, q.z};
+                for (int k = 0; k < 3; ++k) {
+                    box.lo[k] = std::min(box.lo[k], c[k]);
+                    box.hi[k] = std::max(box.hi[k], c[k]);
+                }
+            };
+            extend(PositionAt(t, e));
+            auto it = std::upper_bound(t.points.begin(), t.points.end(), s,
+                                       [](double v, const TrajectoryPoint& q) { return v < q.t; });
+            for (; it != t.points.end() && it->t < e; ++it) extend(it->p);
+            for (int k = 0; k < 3; ++k) {
+                box.lo[k] -= grow;
+                box.hi[k] += grow;
+            }
+        }
+
+        // Sweep along x; a pair is a candidate when its boxes overlap on all axes
+        for (uint32_t i = 0; i < n; ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return boxes[a].lo[0] < boxes[b].lo[0]; });
+        active.clear();
+        pieces.clear();
+        for (uint32_t i : order) {
+            const Box& bi = boxes[i];
+            size_t kept = 0;
+            for (uint32_t j : active) {
+                if (boxes[j].hi[0] < bi.lo[0]) continue;   // can no longer overlap anything
+                active[kept++] = j;
+                const Box& bj = boxes[j];
+                if (bj.hi[1] < bi.lo[1] || bi.hi[1] < bj.lo[1] || bj.hi[2] < bi.lo[2] || bi.hi[2] < bj.lo[2])
+                    continue;
+                ++plan.candidatePairs;
+                solver.solve(std::min(i, j), std::max(i, j), s, e, pieces);
+            }
+            active.resize(kept);
+            active.push_back(i);
+        }
+
+        // Pieces that continue a pair's previous window extend it
+        for (const ContactWindow& w : pieces) {
+            uint64_t key = static_cast<uint64_t>(w.a) * n + w.b;
+            auto it = lastWindow.find(key);
+            if (it != lastWindow.end() && plan.windows[it->second].end >= w.start - 1e-6) {
+                ContactWindow& open = plan.windows[it->second];
+                open.end = std::max(open.end, w.end);
+                open.minRangeM = std::min(open.minRangeM, w.minRangeM);
+                open.maxRangeM = std::max(open.maxRangeM, w.maxRangeM);
+                continue;
+            }
+            lastWindow[key] = plan.windows.size();
+            plan.windows.push_back(w);
+        }
+    }
+
+    std::sort(plan.windows.begin(), plan.windows.end(), [](const ContactWindow& x, const ContactWindow& y) {
+        if (x.start != y.start) return x.start < y.start;
+        return x.a != y.a ? x.a < y.a : x.b < y.b;
+    });
+    return plan;
+}
+
+bool WriteContactPlan(const std::string& path, const ContactPlan& plan,
+                      const std::vector<Trajectory>& trajectories)
+{
+    std::filesystem::path p(path);
+    std::error_code ec;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "a,b,start_s,end_s,min_range_m,max_range_m\n" << std::fixed << std::setprecision(3);
+    for (const ContactWindow& w : plan.windows)
+        out << trajectories[w.a].name << ',' << trajectories[w.b].name << ',' << w.start << ',' << w.end << ','
+            << w.minRangeM << ',' << w.maxRangeM << '\n';
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "routingGraph.h"
+
+// Time-varying node positions for contact planning. Positions are in the
+// local scenario frame (metres) with the Moon's centre at (0, 0, -radius),
+// so a scenario's surface plane touches the sphere at the origin.
+
+struct TrajectoryPoint {
+    double t;          // s from mission start
+    NodePosition p;
+};
+
+// Piecewise-linear track, points sorted by time; the node holds its first
+// position before the first point and its last after the last one
+struct Trajectory {
+    std::string name;
+    std::vector<TrajectoryPoint> points;
+};
+
+NodePosition PositionAt(const Trajectory& trajectory, double t);
+
+// Circular orbit around the Moon's centre, fixed in the Moon frame (the
+// ground track repeats every period)
+struct CircularOrbit {
+    double altitudeM{100e3};
+    double inclinationDeg{90.0};
+    double raanDeg{0.0};        // ascending node, measured from the local +x axis
+    double phaseDeg{0.0};       // argument of latitude at t = 0
+    double periodS{7200.0};
+};
+
+static const double kMoonRadiusM = 1737.4e3;
+
+// Chord-sample an orbit over [t0, t1]
+void SampleCircularOrbit(const CircularOrbit& orbit, double t0, double t1, double stepS, Trajectory& out);
+
+// Read a trajectory file:
+//
+//   TRAJECTORY <name>            followed by "<t> <x> <y> <z>" lines
+//   STATIC <name> <x> <y> <z>
+//   ORBIT <name> altitude=<m> inclination=<deg> raan=<deg> phase=<deg> period=<s>
+//
+// Orbits are sampled every orbitStepS over [t0, t1]. '#' starts a comment.
+bool LoadTrajectories(const std::string& path, double t0, double t1, double orbitStepS,
+                      std::vector<Trajectory>& trajectories);
+
+// When two nodes can talk: within range and, with occlusion on, the straight
+// line between them clears the Moon
+struct ContactRules {
+    double maxRangeM{50e3};
+    bool occlusion{true};
+    double moonRadiusM{kMoonRadiusM};
+    double losStepS{10.0};     // visibility sampling inside a range window
+};
+
+// Period [start, end) in which nodes a < b are in contact, with the
+// distance extremes over it
+struct ContactWindow {
+    uint32_t a;
+    uint32_t b;
+    double start;
+    double end;
+    double minRangeM;
+    double maxRangeM;
+};
+
+struct ContactPlan {
+    std::vector<ContactWindow> windows;   // sorted by start time
+    size_t slabs{};
+    size_t candidatePairs{};               // pair/slab combinations checked exactly
+};
+
+// Compute every contact window over [t0, t1]. The timeline is cut into
+// slabs; in each slab the nodes' bounding boxes (grown by half the range)
+// are swept along x to find the pairs that can possibly meet, and only
+// those are solved exactly: the range crossings of each linear piece come
+// from a quadratic, the occlusion edges from sampling plus bisection.
+ContactPlan ComputeContactPlan(const std::vector<Trajectory>& trajectories, const ContactRules& rules,
+                               double t0, double t1, double slabS = 600.0);
+
+// "a,b,start_s,end_s,min_range_m,max_range_m" with node names
+bool WriteContactPlan(const std::string& path, const ContactPlan& plan,
+                      const std::vector<Trajectory>& trajectories);
@@ -0,0 +1,336 @@
+/* -*- Mode: C++; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+  Lunar DT Contact Plan Simulation
+  --------------------------------
+  Moving rovers, fixed stations and relay orbiters (a trajectory file, see
+  contactPlan.h) exchanging traffic over a mission timeline. All contact
+  windows are computed once up front by ComputeContactPlan(); the
+  simulation then only switches links up and down at the window edges and
+  recomputes the global routes there, so no geometry is evaluated per
+  packet and a multi-day timeline costs a handful of events per contact.
+
+  Every pair that ever meets gets a point-to-point link whose delay is set
+  at the start of each window from the window's mean range. Each node runs
+  a UdpEcho client towards the sink, which is reachable on a stub LAN
+  address that stays up whatever its contacts do.
+*/
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/mobility-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include "contactPlan.h"
+#include "binaryTrace.h"
+
+using namespace ns3;
+
+// --------------------------- Link state --------------------------------------
+struct ContactLink
+{
+  Ptr<Channel> channel;
+  Ptr<Ipv4> ipvA;
+  Ptr<Ipv4> ipvB;
+  uint32_t ifA = 0;
+  uint32_t ifB = 0;
+  uint32_t traceId = 0;
+};
+
+static uint64_t g_contactLinkChanges = 0;
+static uint64_t g_contactRouteUpdates = 0;
+
+static void SetContactState(ContactLink* link, bool up, double delayS)
+{
+  if (up)
+  {
+    link->channel->SetAttribute("Delay", TimeValue(Seconds(delayS)));
+    link->ipvA->SetUp(link->ifA);
+    link->ipvB->SetUp(link->ifB);
+  }
+  else
+  {
+    link->ipvA->SetDown(link->ifA);
+    link->ipvB->SetDown(link->ifB);
+  }
+  ++g_contactLinkChanges;
+  TraceContact(link->traceId, Simulator::Now().GetNanoSeconds(), up, delayS * 1000.0);
+}
+
+static void RecomputeContactRoutes()
+{
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables();
+  ++g_contactRouteUpdates;
+}
+
+// --------------------------- Traffic -----------------------------------------
+struct ContactFlowStats
+{
+  uint32_t sent = 0;
+  uint32_t received = 0;
+  double rttSumMs = 0.0;
+  std::unordered_map<uint64_t, Time> pending;   // send time by packet uid
+};
+
+static void OnContactEchoTx(ContactFlowStats* stats, Ptr<const Packet> packet)
+{
+  stats->sent++;
+  stats->pending[packet->GetUid()] = Simulator::Now();
+}
+
+// The echo server sends back the packet it received, which keeps its uid,
+// so a reply is matched to its own request even when several are in
+// flight (intervals below the Earth-Moon round trip); unanswered requests
+// stay pending
+static void OnContactEchoRx(ContactFlowStats* stats, Ptr<const Packet> packet)
+{
+  auto it = stats->pending.find(packet->GetUid());
+  if (it == stats->pending.end())
+    return;
+  stats->received++;
+  stats->rttSumMs += (Simulator::Now() - it->second).GetSeconds() * 1e3;
+  stats->pending.erase(it);
+}
+
+// --------------------------- Entry point -------------------------------------
+int runContactPlanSimulation(int argc, char* argv[])
+{
+  std::cout << "\n[INFO] === Starting Contact Plan Simulation ===" << std::endl;
+
+  std::string trajectoryFile;
+  double start = 0.0;
+  double duration = 86400.0;
+  double maxRange = 50e3;
+  bool occlusion = true;
+  double slab = 600.0;
+  double losStep = 10.0;
+  double orbitStep = 60.0;
+  std::string sink;
+  double interval = 60.0;
+  std::string dataRate = "1Mbps";
+  std::string planFile = "./scratch/output/contact_plan.csv";
+
+  CommandLine cmd;
+  cmd.AddValue("trajectories", "Trajectory file (TRAJECTORY / STATIC / ORBIT entries)", trajectoryFile);
+  cmd.AddValue("start", "Mission time at which the simulation starts (s)", start);
+  cmd.AddValue("duration", "Simulated mission time (s)", duration);
+  cmd.AddValue("maxRange", "Maximum link range (m)", maxRange);
+  cmd.AddValue("occlusion", "Require a line of sight clear of the Moon", occlusion);
+  cmd.AddValue("slab", "Time slab of the contact sweep (s)", slab);
+  cmd.AddValue("losStep", "Line-of-sight sampling step inside a window (s)", losStep);
+  cmd.AddValue("orbitStep", "Chord length of sampled orbits (s)", orbitStep);
+  cmd.AddValue("sink", "Node every other node sends to (default: first node)", sink);
+  cmd.AddValue("interval", "Echo request interval per node (s)", interval);
+  cmd.AddValue("dataRate", "Data rate of the contact links", dataRate);
+  cmd.AddValue("planFile", "CSV receiving the contact windows (none = skip)", planFile);
+  cmd.Parse(argc, argv);
+
+  const double end = start + duration;
+  std::vector<Trajectory> trajectories;
+  if (trajectoryFile.empty() || !LoadTrajectories(trajectoryFile, start, end, orbitStep, trajectories))
+  {
+    std::cerr << "[ERROR] No usable trajectories (--trajectories=<file>)." << std::endl;
+    return -1;
+  }
+  if (trajectories.size() < 2)
+  {
+    std::cerr << "[ERROR] A contact plan needs at least two nodes." << std::endl;
+    return -1;
+  }
+
+  // ---- Contact plan, computed once for the whole timeline
+  ContactRules rules;
+  rules.maxRangeM = maxRange;
+  rules.occlusion = occlusion;
+  rules.losStepS = losStep;
+  auto t0 = std::chrono::steady_clock::now();
+  ContactPlan plan = ComputeContactPlan(trajectories, rules, start, end, slab);
+  const std::streamsize precision = std::cout.precision();
+  double planMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  std::cout << "[INFO] Contact plan: " << plan.windows.size() << " windows for " << trajectories.size()
+            << " nodes over " << duration / 3600.0 << " h (" << plan.candidatePairs << " pair checks in "
+            << plan.slabs << " slabs, " << std::fixed << std::setprecision(1) << planMs << " ms)"
+            << std::defaultfloat << std::setprecision(precision) << std::endl;
+  if (!planFile.empty() && planFile != "none")
+  {
+    if (WriteContactPlan(planFile, plan, trajectories))
+      std::cout << "[INFO] Contact windows written to " << planFile << std::endl;
+    else
+      std::cerr << "[WARNING] Could not write " << planFile << std::endl;
+  }
+
+  uint32_t sinkIndex = 0;
+  if (!sink.empty())
+  {
+    auto it = std::find_if(trajectories.begin(), trajectories.end(),
+                           [&](const Trajectory& t) { return t.name == sink; });
+    if (it == trajectories.end())
+    {
+      std::cerr << "[ERROR] Sink node '" << sink << "' is not in " << trajectoryFile << std::endl;
+      return -1;
+    }
+    sinkIndex = static_cast<uint32_t>(it - trajectories.begin());
+  }
+
+  // ---- Nodes follow their trajectories (simulation time = mission time - start)
+  auto buildStart = std::chrono::steady_clock::now();
+  NodeContainer nodes;
+  nodes.Create(trajectories.size());
+  MobilityHelper mobility;
+  mobility.SetMobilityModel("ns3::WaypointMobilityModel");
+  mobility.Install(nodes);
+  for (uint32_t i = 0; i < nodes.GetN(); ++i)
+  {
+    Ptr<WaypointMobilityModel> model = nodes.Get(i)->GetObject<WaypointMobilityModel>();
+    const Trajectory& t = trajectories[i];
+    auto add = [&](double when, const NodePosition& p) {
+      model->AddWaypoint(Waypoint(Seconds(when - start), Vector(p.x, p.y, p.z)));
+    };
+    add(start, PositionAt(t, start));
+    for (const TrajectoryPoint& point : t.points)
+    {
+      if (point.t > start && point.t < end)
+        add(point.t, point.p);
+    }
+    add(end, PositionAt(t, end));
+  }
+
+  InternetStackHelper internet;
+  internet.Install(nodes);
+
+  // ---- One link per pair that ever meets, down until its first window
+  std::map<std::pair<uint32_t, uint32_t>, size_t> linkOf;
+  for (const ContactWindow& w : plan.windows)
+    linkOf.emplace(std::make_pair(w.a, w.b), linkOf.size());
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute("DataRate", StringValue(dataRate));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.252");
+  std::vector<ContactLink> links(linkOf.size());
+  for (const auto& entry : linkOf)
+  {
+    NetDeviceContainer devices = p2p.Install(nodes.Get(entry.first.first), nodes.Get(entry.first.second));
+    ipv4.Assign(devices);
+    ipv4.NewNetwork();
+    ContactLink& link = links[entry.second];
+    link.channel = devices.Get(0)->GetChannel();
+    link.ipvA = nodes.Get(entry.first.first)->GetObject<Ipv4>();
+    link.ipvB = nodes.Get(entry.first.second)->GetObject<Ipv4>();
+    link.ifA = link.ipvA->GetInterfaceForDevice(devices.Get(0));
+    link.ifB = link.ipvB->GetInterfaceForDevice(devices.Get(1));
+    link.ipvA->SetDown(link.ifA);
+    link.ipvB->SetDown(link.ifB);
+    if (TraceEnabled(kTraceContact))
+      link.traceId = TraceIntern(trajectories[entry.first.first].name + " <-> " +
+                                 trajectories[entry.first.second].name);
+  }
+
+  // The sink's own address lives on a single-node LAN, always up
+  CsmaHelper csma;
+  NetDeviceContainer sinkLan = csma.Install(NodeContainer(nodes.Get(sinkIndex)));
+  Ipv4AddressHelper lanAddress;
+  lanAddress.SetBase("172.16.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer sinkInterface = lanAddress.Assign(sinkLan);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+  // ---- Window edges drive link state; routes are recomputed once per edge time
+  struct ContactEvent
+  {
+    double t;
+    size_t link;
+    bool up;
+    double delayS;
+  };
+  std::vector<ContactEvent> events;
+  events.reserve(2 * plan.windows.size());
+  const double c = 299792458.0;
+  for (const ContactWindow& w : plan.windows)
+  {
+    size_t link = linkOf[std::make_pair(w.a, w.b)];
+    events.push_back({std::max(w.start, start) - start, link, true, 0.5 * (w.minRangeM + w.maxRangeM) / c});
+    if (w.end < end)
+      events.push_back({w.end - start, link, false, 0.0});
+  }
+  // Downs before ups at the same instant, so a window that ends where the
+  // next one starts leaves the link up
+  std::stable_sort(events.begin(), events.end(), [](const ContactEvent& x, const ContactEvent& y) {
+    return x.t != y.t ? x.t < y.t : (!x.up && y.up);
+  });
+  for (size_t i = 0; i < events.size(); ++i)
+  {
+    const ContactEvent& e = events[i];
+    Simulator::Schedule(Seconds(e.t), &SetContactState, &links[e.link], e.up, e.delayS);
+    if (i + 1 == events.size() || events[i + 1].t != e.t)
+      Simulator::Schedule(Seconds(e.t), &RecomputeContactRoutes);
+  }
+
+  // ---- Traffic: every node echoes to the sink
+  const uint16_t port = 9;
+  UdpEchoServerHelper echoServer(port);
+  ApplicationContainer serverApps = echoServer.Install(nodes.Get(sinkIndex));
+  serverApps.Start(Seconds(0.0));
+  serverApps.Stop(Seconds(duration));
+
+  std::vector<ContactFlowStats> flows(nodes.GetN());
+  uint32_t packets = static_cast<uint32_t>(std::max(1.0, duration / std::max(interval, 1e-3)));
+  for (uint32_t i = 0; i < nodes.GetN(); ++i)
+  {
+    if (i == sinkIndex)
+      continue;
+    UdpEchoClientHelper echoClient(sinkInterface.GetAddress(0), port);
+    echoClient.SetAttribute("MaxPackets", UintegerValue(packets));
+    echoClient.SetAttribute("Interval", TimeValue(Seconds(interval)));
+    echoClient.SetAttribute("PacketSize", UintegerValue(512));
+    ApplicationContainer clientApps = echoClient.Install(nodes.Get(i));
+    clientApps.Start(Seconds(1.0));
+    clientApps.Stop(Seconds(duration));
+    clientApps.Get(0)->TraceConnectWithoutContext("Tx", MakeBoundCallback(&OnContactEchoTx, &flows[i]));
+    clientApps.Get(0)->TraceConnectWithoutContext("Rx", MakeBoundCallback(&OnContactEchoRx, &flows[i]));
+  }
+  double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+  auto runStart = std::chrono::steady_clock::now();
+  Simulator::Stop(Seconds(duration));
+  Simulator::Run();
+  double runMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+  Simulator::Destroy();
+
+  // ---- Report
+  std::cout << "\n[RESULT] Echo delivery to " << trajectories[sinkIndex].name << ":\n";
+  uint64_t sent = 0, received = 0;
+  double rttSum = 0.0;
+  for (uint32_t i = 0; i < flows.size(); ++i)
+  {
+    if (i == sinkIndex)
+      continue;
+    const ContactFlowStats& f = flows[i];
+    sent += f.sent;
+    received += f.received;
+    rttSum += f.rttSumMs;
+    std::cout << "  " << std::left << std::setw(16) << trajectories[i].name << std::right << std::setw(7)
+              << f.received << "/" << f.sent;
+    if (f.received > 0)
+      std::cout << "  mean RTT " << std::fixed << std::setprecision(1) << f.rttSumMs / f.received << " ms"
+                << std::defaultfloat << std::setprecision(precision);
+    std::cout << '\n';
+  }
+  std::cout << "[RESULT] Total " << received << "/" << sent << " echoes";
+  if (received > 0)
+    std::cout << ", mean RTT " << std::fixed << std::setprecision(1) << rttSum / received << " ms";
+  std::cout << "\n[TIMING] plan " << std::fixed << std::setprecision(1) << planMs << " ms, build " << buildMs
+            << " ms, run " << runMs << " ms (" << links.size() << " links, " << g_contactLinkChanges
+            << " link changes, " << g_contactRouteUpdates << " route updates)" << std::defaultfloat
+            << std::setprecision(precision) << std::endl;
+  g_contactLinkChanges = 0;
+  g_contactRouteUpdates = 0;
+  return 0;
+}
@@ -0,0 +1,443 @@
+#include "contractionHierarchy.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <thread>
+
+// Witness searches give up after settling this many nodes; the shortcut
+// is then added anyway, which is always correct, just less sparse
+static const uint32_t kWitnessSettleLimit = 100;
+
+static const char kChMagic[8] = {'L', 'D', 'T', 'C', 'H', 0, 0, 1};
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t size)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t TopologyHash(const RoutingGraph& graph)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (uint32_t v = 0; v < graph.nodeCount(); ++v) {
+        std::string_view name = graph.names[v];
+        h = fnv1a(h, name.data(), name.size());
+        h = fnv1a(h, "", 1);
+    }
+    h = fnv1a(h, graph.offsets.data(), graph.offsets.size() * sizeof(uint32_t));
+    h = fnv1a(h, graph.targets.data(), graph.targets.size() * sizeof(uint32_t));
+    h = fnv1a(h, graph.weights.data(), graph.weights.size() * sizeof(double));
+    return h;
+}
+
+// Insert edge to node, or lower its weight if it already exists
+static void addOrImprove(std::vector<ChEdge>& list, uint32_t node, double weight, uint32_t middle)
+{
+    for (ChEdge& e : list) {
+        if (e.node != node) continue;
+        if (weight < e.weight) { e.weight = weight; e.middle = middle; }
+        return;
+    }
+    list.push_back({node, middle, weight});
+}
+
+static void removeEdgesTo(std::vector<ChEdge>& list, uint32_t node)
+{
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [node](const ChEdge& e) { return e.node == node; }),
+               list.end());
+}
+
+// ---------------------------------------------------------------------
+// BuildContractionHierarchy()
+// Nodes are contracted in lazily updated edge-difference order; each
+// contraction adds the shortcuts u -> w (via v) that no witness path
+// avoiding v can match.
+// ---------------------------------------------------------------------
+ContractionHierarchy BuildContractionHierarchy(const RoutingGraph& graph)
+{
+    ScopedPhase phase("ch_build");
+    const uint32_t n = graph.nodeCount();
+    const double inf = std::numeric_limits<double>::infinity();
+
+    std::vector<std::vector<ChEdge>> out(n), in(n);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t k = graph.offsets[u]; k < graph.offsets[u + 1]; ++k) {
+            uint32_t v = graph.targets[k];
+            if (v == u || !(graph.weights[k] < inf)) continue; // unusable link
+            addOrImprove(out[u], v, graph.weights[k], kInvalidNode);
+            addOrImprove(in[v], u, graph.weights[k], kInvalidNode);
+        }
+    }
+
+    std::vector<char> contracted(n, 0);
+    std::vector<uint32_t> deletedNeighbors(n, 0);
+    std::vector<uint32_t> level(n, 0);
+
+    // Bounded Dijkstra used for witness searches
+    std::vector<double> dist(n, inf);
+    std::vector<uint32_t> touched;
+    using QueueEntry = std::pair<double, uint32_t>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> pq;
+
+    auto witnessSearch = [&](uint32_t source, uint32_t skip, double maxDist) {
+        for (uint32_t x : touched) dist[x] = inf;
+        touched.clear();
+        while (!pq.empty()) pq.pop();
+
+        dist[source] = 0.0;
+        touched.push_back(source);
+        pq.push({0.0, source});
+        uint32_t settled = 0;
+        while (!pq.empty()) {
+            auto [d, x] = pq.top();
+            pq.pop();
+            if (d > dist[x]) continue;
+            if (d > maxDist || ++settled > kWitnessSettleLimit) break;
+            for (const ChEdge& e : out[x]) {
+                if (e.node == skip || contracted[e.node]) continue;
+                double nd = d + e.weight;
+                if (nd < dist[e.node]) {
+                    if (dist[e.node] == inf) touched.push_back(e.node);
+                    dist[e.node] = nd;
+                    pq.push({nd, e.node});
+                }
+            }
+        }
+    };
+
+    struct Shortcut { uint32_t from, to; double weight; };
+    std::vector<Shortcut> shortcuts;
+
+    // Collect the shortcuts contracting v would need
+    auto findShortcuts = [&](uint32_t v) {
+        shortcuts.clear();
+        for (const ChEdge& inEdge : in[v]) {
+            uint32_t u = inEdge.node;
+            double maxCandidate = -1.0;
+            for (const ChEdge& outEdge : out[v])
+                if (outEdge.node != u) maxCandidate = std::max(maxCandidate, inEdge.weight + outEdge.weight);
+            if (maxCandidate < 0.0) continue;
+
+            witnessSearch(u, v, maxCandidate);
+            for (const ChEdge& outEdge : out[v]) {
+                if (outEdge.node == u) continue;
+                double candidate = inEdge.weight + outEdge.weight;
+                if (dist[outEdge.node] > candidate)
+                    shortcuts.push_back({u, outEdge.node, candidate});
+            }
+        }
+    };
+
+    // 2 x edge difference + contracted neighbours + hierarchy depth
+    auto priority = [&](uint32_t v) {
+        findShortcuts(v);
+        int64_t edgeDifference = static_cast<int64_t>(shortcuts.size())
+                               - static_cast<int64_t>(in[v].size() + out[v].size());
+        return 2 * edgeDifference + deletedNeighbors[v] + level[v];
+    };
+
+    using OrderEntry = std::pair<int64_t, uint32_t>;
+    std::priority_queue<OrderEntry, std::vector<OrderEntry>, std::greater<OrderEntry>> order;
+    for (uint32_t v = 0; v < n; ++v) order.push({priority(v), v});
+
+    ContractionHierarchy ch;
+    ch.rank.assign(n, 0);
+    std::vector<std::vector<ChEdge>> fwdUp(n), bwdUp(n);
+    uint32_t nextRank = 0;
+
+    while (!order.empty()) {
+        uint32_t v = order.top().second;
+        order.pop();
+        if (contracted[v]) continue;
+
+        // Lazy update: re-queue if v is no longer the cheapest node
+        int64_t current = priority(v);
+        if (!order.empty() && current > order.top().first) {
+            order.push({current, v});
+            continue;
+        }
+
+        // shortcuts now holds v's shortcuts (computed by priority())
+        fwdUp[v] = out[v];
+        bwdUp[v] = in[v];
+        contracted[v] = 1;
+        ch.rank[v] = nextRank++;
+
+        auto detach = [&](std::vector<ChEdge>& neighbourList, uint32_t neighbour) {
+            removeEdgesTo(neighbourList, v);
+            deletedNeighbors[neighbour]++;
+            level[neighbour] = std::max(level[neighbour], level[v] + 1);
+        };
+        for (const ChEdge& e : out[v]) detach(in[e.node], e.node);
+        for (const ChEdge& e : in[v]) detach(out[e.node], e.node);
+        for (const Shortcut& s : shortcuts) {
+            addOrImprove(out[s.from], s.to, s.weight, v);
+            addOrImprove(in[s.to], s.from, s.weight, v);
+        }
+        std::vector<ChEdge>().swap(out[v]);
+        std::vector<ChEdge>().swap(in[v]);
+    }
+
+    auto flatten = [n](std::vector<std::vector<ChEdge>>& lists, std::vector<uint32_t>& offsets,
+                       std::vector<ChEdge>& edges) {
+        offsets.assign(n + 1, 0);
+        for (uint32_t v = 0; v < n; ++v) offsets[v + 1] = offsets[v] + static_cast<uint32_t>(lists[v].size());
+        edges.reserve(offsets[n]);
+        for (auto& list : lists) {
+            edges.insert(edges.end(), list.begin(), list.end());
+            std::vector<ChEdge>().swap(list);
+        }
+    };
+    flatten(fwdUp, ch.fwdOffsets, ch.fwdEdges);
+    flatten(bwdUp, ch.bwdOffsets, ch.bwdEdges);
+    ch.topologyHash = TopologyHash(graph);
+    return ch;
+}
+
+// ---------------------------------------------------------------------
+// Queries
+// ---------------------------------------------------------------------
+static const ChEdge* findEdge(const std::vector<uint32_t>& offsets, const std::vector<ChEdge>& edges,
+                              uint32_t owner, uint32_t node)
+{
+    for (uint32_t k = offsets[owner]; k < offsets[owner + 1]; ++k)
+        if (edges[k].node == node) return &edges[k];
+    return nullptr;
+}
+
+// Append the original nodes of edge from -> to (excluding from)
+static void unpackEdge(const ContractionHierarchy& ch, uint32_t from, uint32_t to, uint32_t middle,
+                       std::vector<uint32_t>& path)
+{
+    if (middle == kInvalidNode) {
+        path.push_back(to);
+        return;
+    }
+    // from -> middle is stored downward from 'from', i.e. in middle's bwd list
+    const ChEdge* first = findEdge(ch.bwdOffsets, ch.bwdEdges, middle, from);
+    const ChEdge* second = findEdge(ch.fwdOffsets, ch.fwdEdges, middle, to);
+    unpackEdge(ch, from, middle, first ? first->middle : kInvalidNode, path);
+    unpackEdge(ch, middle, to, second ? second->middle : kInvalidNode, path);
+}
+
+static void prepareWorkspace(ChQueryWorkspace& ws, uint32_t n)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    if (ws.distF.size() != n) {
+        ws.distF.assign(n, inf);
+        ws.distB.assign(n, inf);
+        ws.prevF.assign(n, kInvalidNode);
+        ws.prevB.assign(n, kInvalidNode);
+        ws.parentF.assign(n, kInvalidNode);
+        ws.parentB.assign(n, kInvalidNode);
+        ws.heapF.reset(n);
+        ws.heapB.reset(n);
+        ws.touched.clear();
+        return;
+    }
+    for (uint32_t v : ws.touched) {
+        ws.distF[v] = ws.distB[v] = inf;
+        ws.prevF[v] = ws.prevB[v] = kInvalidNode;
+        ws.parentF[v] = ws.parentB[v] = kInvalidNode;
+    }
+    ws.touched.clear();
+    ws.heapF.clear();
+    ws.heapB.clear();
+}
+
+bool QueryContractionHierarchy(const ContractionHierarchy& ch, uint32_t start, uint32_t goal,
+                               ChQueryWorkspace& ws, RouteAnswer& answer, bool withPath)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    answer.cost = inf;
+    answer.path.clear();
+    if (start >= ch.nodeCount() || goal >= ch.nodeCount()) return false;
+
+    prepareWorkspace(ws, ch.nodeCount());
+    ws.distF[start] = 0.0;
+    ws.distB[goal] = 0.0;
+    ws.touched.push_back(start);
+    ws.touched.push_back(goal);
+    ws.heapF.pushOrDecrease(start, 0.0);
+    ws.heapB.pushOrDecrease(goal, 0.0);
+
+    double best = inf;
+    uint32_t meet = kInvalidNode;
+    if (start == goal) { best = 0.0; meet = start; }
+
+    // One settle step of a direction; edges only ever lead upward. A node
+    // reached more cheaply from above through a downward edge (stored in the
+    // opposite direction's lists) cannot be on a shortest path and is stalled.
+    auto step = [&](IndexedMinHeap& heap, std::vector<double>& dist, std::vector<double>& otherDist,
+                    std::vector<uint32_t>& prev, std::vector<uint32_t>& parent,
+                    const std::vector<uint32_t>& offsets, const std::vector<ChEdge>& edges,
+                    const std::vector<uint32_t>& downOffsets, const std::vector<ChEdge>& downEdges) {
+        uint32_t u = heap.pop();
+        double du = dist[u];
+        for (uint32_t k = downOffsets[u]; k < downOffsets[u + 1]; ++k)
+            if (dist[downEdges[k].node] + downEdges[k].weight < du) return;
+
+        for (uint32_t k = offsets[u]; k < offsets[u + 1]; ++k) {
+            uint32_t v = edges[k].node;
+            double alt = du + edges[k].weight;
+            if (alt < dist[v]) {
+                if (ws.distF[v] == inf && ws.distB[v] == inf) ws.touched.push_back(v);
+                dist[v] = alt;
+                prev[v] = k;
+                parent[v] = u;
+                heap.pushOrDecrease(v, alt);
+                if (otherDist[v] != inf && alt + otherDist[v] < best) {
+                    best = alt + otherDist[v];
+                    meet = v;
+                }
+            }
+        }
+    };
+
+    while (true) {
+        bool forward = !ws.heapF.empty() && ws.heapF.topKey() < best;
+        bool backward = !ws.heapB.empty() && ws.heapB.topKey() < best;
+        if (!forward && !backward) break;
+        if (forward && (!backward || ws.heapF.topKey() <= ws.heapB.topKey()))
+            step(ws.heapF, ws.distF, ws.distB, ws.prevF, ws.parentF, ch.fwdOffsets, ch.fwdEdges,
+                 ch.bwdOffsets, ch.bwdEdges);
+        else
+            step(ws.heapB, ws.distB, ws.distF, ws.prevB, ws.parentB, ch.bwdOffsets, ch.bwdEdges,
+                 ch.fwdOffsets, ch.fwdEdges);
+    }
+
+    if (meet == kInvalidNode) return false;
+    answer.cost = best;
+    if (!withPath) return true;
+
+    // start .. meet: walk forward parents back, then unpack in order
+    std::vector<uint32_t> upChain;
+    for (uint32_t v = meet; v != start; v = ws.parentF[v]) upChain.push_back(v);
+    std::reverse(upChain.begin(), upChain.end());
+
+    answer.path.push_back(start);
+    for (uint32_t v : upChain)
+        unpackEdge(ch, ws.parentF[v], v, ch.fwdEdges[ws.prevF[v]].middle, answer.path);
+
+    // meet .. goal: backward parents already lead toward the goal
+    for (uint32_t v = meet; v != goal; v = ws.parentB[v])
+        unpackEdge(ch, v, ws.parentB[v], ch.bwdEdges[ws.prevB[v]].middle, answer.path);
+    return true;
+}
+
+void QueryContractionHierarchyBatch(const ContractionHierarchy& ch,
+                                    const std::vector<RouteQuery>& queries,
+                                    std::vector<RouteAnswer>& answers,
+                                    unsigned threads, bool withPaths)
+{
+    answers.assign(queries.size(), RouteAnswer());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads > queries.size()) threads = static_cast<unsigned>(std::max<size_t>(queries.size(), 1));
+
+    const size_t chunk = 64;
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        ChQueryWorkspace ws;
+        for (size_t begin = next.fetch_add(chunk); begin < queries.size(); begin = next.fetch_add(chunk)) {
+            size_t end = std::min(queries.size(), begin + chunk);
+            for (size_t i = begin; i < end; ++i) {
+                auto t0 = std::chrono::steady_clock::now();
+                QueryContractionHierarchy(ch, queries[i].start, queries[i].goal, ws, answers[i], withPaths);
+                answers[i].latencyUs =
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
+
+// ---------------------------------------------------------------------
+// Persistence
+// ---------------------------------------------------------------------
+template <typename T>
+static void writeArray(std::ofstream& out, const std::vector<T>& v)
+{
+    uint64_t size = v.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(size * sizeof(T)));
+}
+
+template <typename T>
+static bool readArray(std::ifstream& in, std::vector<T>& v)
+{
+    uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) return false;
+    if (size > (uint64_t(1) << 40) / sizeof(T)) return false;
+    v.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(v.data()),
+                                     static_cast<std::streamsize>(size * sizeof(T))));
+}
+
+bool SaveContractionHierarchy(const ContractionHierarchy& ch, const std::string& path)
+{
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(kChMagic, sizeof(kChMagic));
+        out.write(reinterpret_cast<const char*>(&ch.topologyHash), sizeof(ch.topologyHash));
+        writeArray(out, ch.rank);
+        writeArray(out, ch.fwdOffsets);
+        writeArray(out, ch.fwdEdges);
+        writeArray(out, ch.bwdOffsets);
+        writeArray(out, ch.bwdEdges);
+        if (!out.good()) return false;
+    }
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool LoadContractionHierarchy(const std::string& path, ContractionHierarchy& ch)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    char magic[sizeof(kChMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kChMagic, sizeof(kChMagic)) != 0) return false;
+    if (!in.read(reinterpret_cast<char*>(&ch.topologyHash), sizeof(ch.topologyHash))) return false;
+    if (!readArray(in, ch.rank) || !readArray(in, ch.fwdOffsets) || !readArray(in, ch.fwdEdges) ||
+        !readArray(in, ch.bwdOffsets) || !readArray(in, ch.bwdEdges))
+        return false;
+
+    uint32_t n = ch.nodeCount();
+    return ch.fwdOffsets.size() == n + 1u && ch.bwdOffsets.size() == n + 1u &&
+           ch.fwdOffsets[n] == ch.fwdEdges.size() && ch.bwdOffsets[n] == ch.bwdEdges.size();
+}
+
+ContractionHierarchy LoadOrBuildContractionHierarchy(const RoutingGraph& graph,
+                                                     const std::string& indexPath,
+                                                     bool* rebuilt)
+{
+    ContractionHierarchy ch;
+    uint64_t hash = TopologyHash(graph);
+    if (LoadContractionHierarchy(indexPath, ch) && ch.topologyHash == hash &&
+        ch.nodeCount() == graph.nodeCount()) {
+        if (rebuilt) *rebuilt = false;
+        return ch;
+    }
+
+    ch = BuildContractionHierarchy(graph);
+    if (!SaveContractionHierarchy(ch, indexPath))
+        std::cerr << "[WARNING] Could not write routing index " << indexPath << '\n';
+    if (rebuilt) *rebuilt = true;
+    return ch;
+}
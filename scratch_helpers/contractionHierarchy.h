@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "routingGraph.h"
+
+// Upward edge of the hierarchy. For shortcuts, middle is the contracted
+// node the shortcut bypasses; original links carry kInvalidNode.
+struct ChEdge {
+    uint32_t node;
+    uint32_t middle;
+    double weight;
+};
+
+// Contraction hierarchy over a RoutingGraph. fwd lists edges u -> v with
+// rank[v] > rank[u]; bwd lists, for node v, edges u -> v with
+// rank[u] > rank[v] (stored under v, node = u).
+struct ContractionHierarchy {
+    uint64_t topologyHash{};
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> fwdOffsets;
+    std::vector<ChEdge> fwdEdges;
+    std::vector<uint32_t> bwdOffsets;
+    std::vector<ChEdge> bwdEdges;
+
+    uint32_t nodeCount() const { return static_cast<uint32_t>(rank.size()); }
+};
+
+struct RouteQuery {
+    uint32_t start;
+    uint32_t goal;
+};
+
+struct RouteAnswer {
+    double cost{};
+    std::vector<uint32_t> path;   // start .. goal, empty if unreachable
+    double latencyUs{};           // wall time of the query (batch API)
+};
+
+// Scratch state for one querying thread
+struct ChQueryWorkspace {
+    std::vector<double> distF, distB;
+    std::vector<uint32_t> prevF, prevB;       // index into fwdEdges / bwdEdges
+    std::vector<uint32_t> parentF, parentB;
+    std::vector<uint32_t> touched;
+    IndexedMinHeap heapF, heapB;
+};
+
+// Hash over everything the hierarchy depends on (names, links, weights)
+uint64_t TopologyHash(const RoutingGraph& graph);
+
+ContractionHierarchy BuildContractionHierarchy(const RoutingGraph& graph);
+
+bool QueryContractionHierarchy(const ContractionHierarchy& ch, uint32_t start, uint32_t goal,
+                               ChQueryWorkspace& ws, RouteAnswer& answer, bool withPath = true);
+
+// Answer many queries, spread over threads (0 = all hardware threads);
+// each answer records its own latency
+void QueryContractionHierarchyBatch(const ContractionHierarchy& ch,
+                                    const std::vector<RouteQuery>& queries,
+                                    std::vector<RouteAnswer>& answers,
+                                    unsigned threads = 0, bool withPaths = true);
+
+bool SaveContractionHierarchy(const ContractionHierarchy& ch, const std::string& path);
+bool LoadContractionHierarchy(const std::string& path, ContractionHierarchy& ch);
+
+// Reuse the index stored at indexPath when its topology hash matches the
+// graph, otherwise build it and write it back. rebuilt reports which
+// happened.
+ContractionHierarchy LoadOrBuildContractionHierarchy(const RoutingGraph& graph,
+                                                     const std::string& indexPath,
+                                                     bool* rebuilt = nullptr);
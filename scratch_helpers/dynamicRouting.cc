@@ -0,0 +1,251 @@
+#include "dynamicRouting.h"
+#include <algorithm>
+#include <limits>
+
+// ---------------------------------------------------------------------
+// DynamicRouter
+// ---------------------------------------------------------------------
+DynamicRouter::DynamicRouter(const RoutingGraph& graph)
+    : names_(graph.names), positions_(graph.positions)
+{
+    uint32_t n = graph.nodeCount();
+    out_.resize(n);
+    in_.resize(n);
+    arcs_.reserve(graph.edgeCount());
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t k = graph.offsets[u]; k < graph.offsets[u + 1]; ++k) {
+            uint32_t id = static_cast<uint32_t>(arcs_.size());
+            arcs_.push_back({u, graph.targets[k], graph.weights[k], true});
+            out_[u].push_back(id);
+            in_[graph.targets[k]].push_back(id);
+        }
+    }
+    heap_.reset(n);
+    affected_.assign(n, 0);
+}
+
+void DynamicRouter::setWeightFunction(std::function<double(uint32_t from, uint32_t to)> fn)
+{
+    weightOf_ = std::move(fn);
+}
+
+double DynamicRouter::linkWeight(uint32_t from, uint32_t to) const
+{
+    if (weightOf_) return weightOf_(from, to);
+    return EuclideanDistance(positions_[from], positions_[to]);
+}
+
+uint32_t DynamicRouter::findArc(uint32_t from, uint32_t to) const
+{
+    for (uint32_t a : out_[from])
+        if (arcs_[a].to == to) return a;
+    return kInvalidNode;
+}
+
+// ---------------------------------------------------------------------
+// Updates
+// ---------------------------------------------------------------------
+RepairStats DynamicRouter::addLink(uint32_t from, uint32_t to)
+{
+    if (from >= nodeCount() || to >= nodeCount() || from == to) return {};
+    uint32_t a = findArc(from, to);
+    if (a == kInvalidNode) {
+        a = static_cast<uint32_t>(arcs_.size());
+        arcs_.push_back({from, to, std::numeric_limits<double>::infinity(), false});
+        out_[from].push_back(a);
+        in_[to].push_back(a);
+    }
+    if (arcs_[a].alive) return {};
+
+    arcs_[a].alive = true;
+    arcs_[a].weight = linkWeight(from, to);
+    return applyChanges({{a, std::numeric_limits<double>::infinity()}});
+}
+
+RepairStats DynamicRouter::removeLink(uint32_t from, uint32_t to)
+{
+    if (from >= nodeCount() || to >= nodeCount()) return {};
+    uint32_t a = findArc(from, to);
+    if (a == kInvalidNode || !arcs_[a].alive) return {};
+
+    double old = arcs_[a].weight;
+    arcs_[a].alive = false;
+    arcs_[a].weight = std::numeric_limits<double>::infinity();
+    return applyChanges({{a, old}});
+}
+
+RepairStats DynamicRouter::setLinkWeight(uint32_t from, uint32_t to, double weight)
+{
+    if (from >= nodeCount() || to >= nodeCount()) return {};
+    uint32_t a = findArc(from, to);
+    if (a == kInvalidNode || !arcs_[a].alive || arcs_[a].weight == weight) return {};
+
+    double old = arcs_[a].weight;
+    arcs_[a].weight = weight;
+    return applyChanges({{a, old}});
+}
+
+// Every link touching v is reweighted, and repaired as one batch
+RepairStats DynamicRouter::moveNode(uint32_t v, const NodePosition& position)
+{
+    if (v >= nodeCount()) return {};
+    positions_[v] = position;
+
+    std::vector<ArcChange> changes;
+    auto reweight = [&](uint32_t a) {
+        DynamicArc& arc = arcs_[a];
+        if (!arc.alive) return;
+        double w = linkWeight(arc.from, arc.to);
+        if (w == arc.weight) return;
+        changes.push_back({a, arc.weight});
+        arc.weight = w;
+    };
+    for (uint32_t a : out_[v]) reweight(a);
+    for (uint32_t a : in_[v]) reweight(a);
+    if (changes.empty()) return {};
+    return applyChanges(changes);
+}
+
+RepairStats DynamicRouter::applyChanges(const std::vector<ArcChange>& changes)
+{
+    RepairStats stats;
+    for (ShortestPathTree& tree : trees_) repairTree(tree, changes, stats);
+    return stats;
+}
+
+// ---------------------------------------------------------------------
+// Tree maintenance
+// ---------------------------------------------------------------------
+void DynamicRouter::buildTree(ShortestPathTree& tree)
+{
+    uint32_t n = nodeCount();
+    tree.dist.assign(n, std::numeric_limits<double>::infinity());
+    tree.parentArc.assign(n, kInvalidNode);
+    tree.dist[tree.source] = 0.0;
+    heap_.clear();
+    heap_.pushOrDecrease(tree.source, 0.0);
+    RepairStats unused;
+    propagate(tree, unused);
+}
+
+// Dijkstra continuing from whatever is in the heap; labels only go down
+void DynamicRouter::propagate(ShortestPathTree& tree, RepairStats& stats)
+{
+    while (!heap_.empty()) {
+        uint32_t u = heap_.pop();
+        ++stats.settled;
+        double du = tree.dist[u];
+        for (uint32_t a : out_[u]) {
+            const DynamicArc& arc = arcs_[a];
+            if (!arc.alive) continue;
+            double alt = du + arc.weight;
+            if (alt < tree.dist[arc.to]) {
+                tree.dist[arc.to] = alt;
+                tree.parentArc[arc.to] = a;
+                heap_.pushOrDecrease(arc.to, alt);
+            }
+        }
+    }
+}
+
+void DynamicRouter::repairTree(ShortestPathTree& tree, const std::vector<ArcChange>& changes,
+                               RepairStats& stats)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    heap_.clear();
+
+    // 1. Tree links that failed or got more expensive: everything below
+    //    them loses its route
+    for (const ArcChange& c : changes) {
+        const DynamicArc& arc = arcs_[c.arc];
+        bool worse = !arc.alive || arc.weight > c.oldWeight;
+        if (!worse || tree.parentArc[arc.to] != c.arc || affected_[arc.to]) continue;
+
+        affected_[arc.to] = 1;
+        size_t first = affectedList_.size();
+        affectedList_.push_back(arc.to);
+        for (size_t i = first; i < affectedList_.size(); ++i) {
+            uint32_t y = affectedList_[i];
+            for (uint32_t a : out_[y]) {
+                uint32_t x = arcs_[a].to;
+                if (tree.parentArc[x] == a && !affected_[x]) {
+                    affected_[x] = 1;
+                    affectedList_.push_back(x);
+                }
+            }
+        }
+    }
+    stats.invalidated += affectedList_.size();
+
+    for (uint32_t x : affectedList_) {
+        tree.dist[x] = inf;
+        tree.parentArc[x] = kInvalidNode;
+    }
+
+    // 2. Re-seed the invalidated subtrees from their intact in-neighbours
+    for (uint32_t x : affectedList_) {
+        for (uint32_t a : in_[x]) {
+            const DynamicArc& arc = arcs_[a];
+            if (!arc.alive || affected_[arc.from]) continue;
+            double alt = tree.dist[arc.from] + arc.weight;
+            if (alt < tree.dist[x]) {
+                tree.dist[x] = alt;
+                tree.parentArc[x] = a;
+            }
+        }
+        if (tree.dist[x] < inf) heap_.pushOrDecrease(x, tree.dist[x]);
+    }
+    for (uint32_t x : affectedList_) affected_[x] = 0;
+    affectedList_.clear();
+
+    // 3. New or cheaper links may shorten routes through their head
+    for (const ArcChange& c : changes) {
+        const DynamicArc& arc = arcs_[c.arc];
+        if (!arc.alive) continue;
+        double alt = tree.dist[arc.from] + arc.weight;
+        if (alt < tree.dist[arc.to]) {
+            tree.dist[arc.to] = alt;
+            tree.parentArc[arc.to] = c.arc;
+            heap_.pushOrDecrease(arc.to, alt);
+        }
+    }
+
+    // 4. Settle the changed region
+    propagate(tree, stats);
+}
+
+const ShortestPathTree& DynamicRouter::treeFrom(uint32_t source)
+{
+    auto it = treeIndex_.find(source);
+    if (it != treeIndex_.end()) return trees_[it->second];
+
+    treeIndex_[source] = trees_.size();
+    trees_.emplace_back();
+    trees_.back().source = source;
+    buildTree(trees_.back());
+    return trees_.back();
+}
+
+// ---------------------------------------------------------------------
+// Queries
+// ---------------------------------------------------------------------
+double DynamicRouter::distance(uint32_t source, uint32_t target)
+{
+    if (source >= nodeCount() || target >= nodeCount())
+        return std::numeric_limits<double>::infinity();
+    return treeFrom(source).dist[target];
+}
+
+bool DynamicRouter::route(uint32_t source, uint32_t target, std::vector<uint32_t>& path)
+{
+    path.clear();
+    if (source >= nodeCount() || target >= nodeCount()) return false;
+    const ShortestPathTree& tree = treeFrom(source);
+    if (tree.dist[target] == std::numeric_limits<double>::infinity()) return false;
+
+    for (uint32_t v = target; v != source; v = arcs_[tree.parentArc[v]].from)
+        path.push_back(v);
+    path.push_back(source);
+    std::reverse(path.begin(), path.end());
+    return true;
+}
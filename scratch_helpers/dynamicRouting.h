@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "routingGraph.h"
+
+// Directed link of the dynamic topology. Failed links stay in the arc pool
+// (alive = false) so restoring them reuses the same id.
+struct DynamicArc {
+    uint32_t from;
+    uint32_t to;
+    double weight;
+    bool alive;
+};
+
+// Shortest-path tree from one source. parentArc[v] is the arc entering v on
+// its shortest path (kInvalidNode for the source and unreachable nodes).
+struct ShortestPathTree {
+    uint32_t source{kInvalidNode};
+    std::vector<double> dist;
+    std::vector<uint32_t> parentArc;
+};
+
+struct RepairStats {
+    size_t invalidated{};   // tree nodes whose route had to be rebuilt
+    size_t settled{};       // nodes settled while repairing, over all trees
+};
+
+// Routing topology that changes under link failures, new links and node
+// moves, keeping shortest-path trees from the queried sources up to date.
+// Each update repairs only the parts of each tree it affects: subtrees
+// hanging below a failed or more expensive tree link are rebuilt from their
+// intact neighbours, and cheaper links are propagated forward from their head.
+class DynamicRouter {
+public:
+    // Copy the nodes, links and weights of a built graph
+    explicit DynamicRouter(const RoutingGraph& graph);
+
+    // Weight of a new or moved link; defaults to the Euclidean distance
+    // between the current node positions
+    void setWeightFunction(std::function<double(uint32_t from, uint32_t to)> fn);
+
+    uint32_t nodeCount() const { return static_cast<uint32_t>(names_.size()); }
+    uint32_t idOf(std::string_view name) const { return names_.find(name); }
+    std::string_view nameOf(uint32_t v) const { return names_[v]; }
+    const NodePosition& position(uint32_t v) const { return positions_[v]; }
+
+    // Updates. Each returns what the repair cost across all maintained trees.
+    RepairStats addLink(uint32_t from, uint32_t to);          // also restores a failed link
+    RepairStats removeLink(uint32_t from, uint32_t to);
+    RepairStats setLinkWeight(uint32_t from, uint32_t to, double weight);
+    RepairStats moveNode(uint32_t v, const NodePosition& position);
+
+    // Queries. The first query from a source builds its tree (full Dijkstra);
+    // later queries read it directly.
+    double distance(uint32_t source, uint32_t target);
+    bool route(uint32_t source, uint32_t target, std::vector<uint32_t>& path);
+    size_t treeCount() const { return trees_.size(); }
+    const std::vector<DynamicArc>& arcs() const { return arcs_; }
+
+private:
+    struct ArcChange {
+        uint32_t arc;
+        double oldWeight;   // infinity if the arc was not alive before
+    };
+
+    double linkWeight(uint32_t from, uint32_t to) const;
+    uint32_t findArc(uint32_t from, uint32_t to) const;
+    const ShortestPathTree& treeFrom(uint32_t source);
+    void buildTree(ShortestPathTree& tree);
+    RepairStats applyChanges(const std::vector<ArcChange>& changes);
+    void repairTree(ShortestPathTree& tree, const std::vector<ArcChange>& changes, RepairStats& stats);
+    void propagate(ShortestPathTree& tree, RepairStats& stats);
+
+    NameTable names_;
+    std::vector<NodePosition> positions_;
+    std::vector<DynamicArc> arcs_;
+    std::vector<std::vector<uint32_t>> out_;
+    std::vector<std::vector<uint32_t>> in_;
+    std::function<double(uint32_t, uint32_t)> weightOf_;
+
+    std::vector<ShortestPathTree> trees_;
+    std::unordered_map<uint32_t, size_t> treeIndex_;
+
+    // Repair scratch space
+    IndexedMinHeap heap_;
+    std::vector<char> affected_;
+    std::vector<uint32_t> affectedList_;
+};
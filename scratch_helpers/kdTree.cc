@@ -0,0 +1,104 @@
+#include "kdTree.h"
+#include <algorithm>
+#include <limits>
+
+// ---------------------------------------------------------------------
+// KdTree
+// ---------------------------------------------------------------------
+void KdTree::build(const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs)
+{
+    uint32_t n = static_cast<uint32_t>(xs.size());
+    coords_.resize(3 * static_cast<size_t>(n));
+    for (uint32_t i = 0; i < n; ++i) {
+        coords_[3 * i] = xs[i];
+        coords_[3 * i + 1] = ys[i];
+        coords_[3 * i + 2] = zs[i];
+    }
+    order_.resize(n);
+    for (uint32_t i = 0; i < n; ++i) order_[i] = i;
+    axis_.assign(n, 0);
+    buildRange(0, n);
+}
+
+// Split each range at the median of its widest axis; ranges of at most
+// kLeafSize points are left as unsorted buckets
+void KdTree::buildRange(uint32_t lo, uint32_t hi)
+{
+    if (hi - lo <= kLeafSize) return;
+
+    double minC[3], maxC[3];
+    for (int a = 0; a < 3; ++a) {
+        minC[a] = std::numeric_limits<double>::infinity();
+        maxC[a] = -minC[a];
+    }
+    for (uint32_t i = lo; i < hi; ++i) {
+        const double* p = &coords_[3 * order_[i]];
+        for (int a = 0; a < 3; ++a) {
+            minC[a] = std::min(minC[a], p[a]);
+            maxC[a] = std::max(maxC[a], p[a]);
+        }
+    }
+    uint8_t axis = 0;
+    for (uint8_t a = 1; a < 3; ++a)
+        if (maxC[a] - minC[a] > maxC[axis] - minC[axis]) axis = a;
+
+    uint32_t mid = lo + (hi - lo) / 2;
+    std::nth_element(order_.begin() + lo, order_.begin() + mid, order_.begin() + hi,
+                     [&](uint32_t a, uint32_t b) { return coords_[3 * a + axis] < coords_[3 * b + axis]; });
+    axis_[mid] = axis;
+    buildRange(lo, mid);
+    buildRange(mid + 1, hi);
+}
+
+static bool farther(const KdNeighbor& a, const KdNeighbor& b)
+{
+    return a.dist2 < b.dist2;   // max-heap on distance
+}
+
+void KdTree::searchRange(uint32_t lo, uint32_t hi, const double q[3], uint32_t k,
+                         std::vector<KdNeighbor>& heap) const
+{
+    auto consider = [&](uint32_t idx) {
+        const double* p = &coords_[3 * idx];
+        double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (heap.size() < k) {
+            heap.push_back({idx, d2});
+            std::push_heap(heap.begin(), heap.end(), farther);
+        } else if (d2 < heap.front().dist2) {
+            std::pop_heap(heap.begin(), heap.end(), farther);
+            heap.back() = {idx, d2};
+            std::push_heap(heap.begin(), heap.end(), farther);
+        }
+    };
+
+    if (hi - lo <= kLeafSize) {
+        for (uint32_t i = lo; i < hi; ++i) consider(order_[i]);
+        return;
+    }
+
+    uint32_t mid = lo + (hi - lo) / 2;
+    uint32_t idx = order_[mid];
+    uint8_t axis = axis_[mid];
+    double diff = q[axis] - coords_[3 * idx + axis];
+    consider(idx);
+
+    // Near side first; the far side only if the splitting plane is closer
+    // than the current k-th neighbour
+    if (diff < 0) {
+        searchRange(lo, mid, q, k, heap);
+        if (heap.size() < k || diff * diff < heap.front().dist2) searchRange(mid + 1, hi, q, k, heap);
+    } else {
+        searchRange(mid + 1, hi, q, k, heap);
+        if (heap.size() < k || diff * diff < heap.front().dist2) searchRange(lo, mid, q, k, heap);
+    }
+}
+
+void KdTree::nearest(double x, double y, double z, uint32_t k, std::vector<KdNeighbor>& out) const
+{
+    out.clear();
+    if (k == 0 || order_.empty()) return;
+    const double q[3] = {x, y, z};
+    searchRange(0, size(), q, std::min(k, size()), out);
+    std::sort_heap(out.begin(), out.end(), farther);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct KdNeighbor {
+    uint32_t index;   // position in the point list given to build()
+    double dist2;     // squared distance to the query point
+};
+
+// Static 3-D k-d tree over a point set (e.g. eNB positions), built once and
+// queried for the k nearest points in O(log n) expected time per query
+class KdTree {
+public:
+    void build(const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs);
+    uint32_t size() const { return static_cast<uint32_t>(order_.size()); }
+
+    // The k points closest to (x, y, z), nearest first
+    void nearest(double x, double y, double z, uint32_t k, std::vector<KdNeighbor>& out) const;
+
+private:
+    static const uint32_t kLeafSize = 8;
+
+    void buildRange(uint32_t lo, uint32_t hi);
+    void searchRange(uint32_t lo, uint32_t hi, const double q[3], uint32_t k,
+                     std::vector<KdNeighbor>& heap) const;
+
+    std::vector<double> coords_;     // x, y, z interleaved by point index
+    std::vector<uint32_t> order_;    // point indices, permuted into tree order
+    std::vector<uint8_t> axis_;      // split axis of the node at order_[mid]
+};
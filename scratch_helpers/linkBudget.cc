@@ -0,0 +1,176 @@
+#include "linkBudget.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+double ReferenceLossDb(double freqMHz)
+{
+    return 32.44 + 20.0 * std::log10(freqMHz / 1000.0);
+}
+
+LinkBudgetNodes MakeLinkBudgetNodes(const std::vector<NodeConfig>& nodes)
+{
+    LinkBudgetNodes soa;
+    size_t n = nodes.size();
+    soa.x.resize(n); soa.y.resize(n); soa.z.resize(n);
+    soa.txPowerDbm.resize(n);
+    soa.refLossDb.resize(n);
+    soa.wavelengthM.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        soa.x[i] = nodes[i].x;
+        soa.y[i] = nodes[i].y;
+        soa.z[i] = nodes[i].z;
+        soa.txPowerDbm[i] = nodes[i].txPowerBm;
+        soa.refLossDb[i] = nodes[i].freqMHz > 0.0 ? ReferenceLossDb(nodes[i].freqMHz)
+                                                  : std::numeric_limits<double>::infinity();
+        soa.wavelengthM[i] = nodes[i].freqMHz > 0.0 ? 299.792458 / nodes[i].freqMHz : 0.0;
+    }
+    return soa;
+}
+
+// Rows are handed out to threads in blocks of this many transmitters
+static const size_t kRowBlock = 16;
+// Receivers are tested in tiles of one bit-matrix word
+static const size_t kTile = 64;
+
+// ---------------------------------------------------------------------
+// ComputeLinkBudgets()
+// SNR(d) = Ptx + Gt + Gr - PL(1m) - N - 10 n log10(max(d, 1 m)), so for a
+// given transmitter "SNR >= threshold" is just max(d^2, 1) <= r2 with a
+// per-row r2. The inner loop is therefore only subtract/multiply/compare
+// over the SoA arrays, which the compiler vectorizes; log10 is evaluated
+// only for pairs that turn out feasible. With terrain, those pairs are then
+// profiled against the DEM and dropped if the diffraction loss pushes them
+// below the threshold; the free-space pass keeps the terrain queries to
+// the pairs that could close at all.
+// ---------------------------------------------------------------------
+LinkBudgetResult ComputeLinkBudgets(const LinkBudgetNodes& nodes, const LinkBudgetParams& params)
+{
+    ScopedPhase phase("link_budgets");
+    const size_t n = nodes.x.size();
+    const double pathExponent = params.model == PathLossModel::Friis ? 2.0 : params.exponent;
+    const double slope = 5.0 * pathExponent; // 10 n log10(d) == 5 n log10(d^2)
+    const double noiseDbm = -174.0 + 10.0 * std::log10(params.bandwidthHz) + params.noiseFigureDb;
+
+    LinkBudgetResult result;
+    FeasibilityMatrix& m = result.feasible;
+    m.n = n;
+    m.wordsPerRow = (n + kTile - 1) / kTile;
+    m.bits.assign(m.n * m.wordsPerRow, 0);
+
+    std::vector<std::vector<LinkBudgetEntry>> rows(params.buildAdjacency ? n : 0);
+    std::vector<size_t> rowCounts(n, 0);
+
+    const double* xs = nodes.x.data();
+    const double* ys = nodes.y.data();
+    const double* zs = nodes.z.data();
+
+    // Terrain endpoints, resolved once per node
+    std::vector<TerrainPoint> terrainAt;
+    if (params.terrain) {
+        terrainAt.resize(n);
+        for (size_t i = 0; i < n; ++i) terrainAt[i] = params.terrain->Resolve({xs[i], ys[i], zs[i]});
+    }
+    std::atomic<uint64_t> terrainQueries{0};
+
+    auto processRow = [&](size_t i) {
+        // Best SNR the transmitter can reach (at 1 m) and the matching d^2 bound
+        double snrAt1m = nodes.txPowerDbm[i] + params.txGainDbi + params.rxGainDbi
+                       - nodes.refLossDb[i] - noiseDbm;
+        double r2 = std::pow(10.0, (snrAt1m - params.minSnrDb) / slope);
+        if (!(r2 >= 1.0)) return; // cannot close even at 1 m (or no valid frequency)
+
+        const double xi = xs[i], yi = ys[i], zi = zs[i];
+        uint64_t* rowBits = m.bits.data() + i * m.wordsPerRow;
+        size_t count = 0;
+
+        for (size_t base = 0; base < n; base += kTile) {
+            size_t len = std::min(kTile, n - base);
+            unsigned char hit[kTile];
+            for (size_t k = 0; k < len; ++k) {
+                double dx = xs[base + k] - xi;
+                double dy = ys[base + k] - yi;
+                double dz = zs[base + k] - zi;
+                double d2 = dx * dx + dy * dy + dz * dz;
+                hit[k] = std::max(d2, 1.0) <= r2;
+            }
+            uint64_t word = 0;
+            for (size_t k = 0; k < len; ++k)
+                word |= static_cast<uint64_t>(hit[k]) << k;
+            if (base <= i && i < base + len)
+                word &= ~(uint64_t(1) << (i - base)); // no self links
+            rowBits[base / kTile] = word;
+            count += static_cast<size_t>(__builtin_popcountll(word));
+        }
+        rowCounts[i] = count;
+
+        if ((!params.buildAdjacency && !params.terrain) || count == 0) return;
+        std::vector<LinkBudgetEntry>* out = params.buildAdjacency ? &rows[i] : nullptr;
+        if (out) out->reserve(count);
+        uint64_t queried = 0;
+        for (size_t w = 0; w < m.wordsPerRow; ++w) {
+            for (uint64_t word = rowBits[w]; word != 0; word &= word - 1) {
+                size_t j = w * kTile + static_cast<size_t>(__builtin_ctzll(word));
+                double dx = xs[j] - xi, dy = ys[j] - yi, dz = zs[j] - zi;
+                double d2 = std::max(dx * dx + dy * dy + dz * dz, 1.0);
+                double pathLoss = nodes.refLossDb[i] + slope * std::log10(d2);
+                double terrainLoss = 0.0;
+                if (params.terrain) {
+                    terrainLoss = params.terrain->Profile(terrainAt[i], terrainAt[j], nodes.wavelengthM[i])
+                                      .diffractionLossDb;
+                    pathLoss += terrainLoss;
+                    ++queried;
+                }
+                double rxPower = nodes.txPowerDbm[i] + params.txGainDbi + params.rxGainDbi - pathLoss;
+                if (terrainLoss > 0.0 && rxPower - noiseDbm < params.minSnrDb) {
+                    rowBits[w] &= ~(uint64_t(1) << (j % kTile));
+                    --rowCounts[i];
+                    continue;
+                }
+                if (out)
+                    out->push_back({static_cast<uint32_t>(j), static_cast<float>(std::sqrt(d2)),
+                                    static_cast<float>(pathLoss), static_cast<float>(rxPower),
+                                    static_cast<float>(rxPower - noiseDbm), static_cast<float>(terrainLoss)});
+            }
+        }
+        terrainQueries += queried;
+    };
+
+    unsigned threads = params.threads ? params.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t blocks = (n + kRowBlock - 1) / kRowBlock;
+    if (threads > blocks) threads = static_cast<unsigned>(std::max<size_t>(blocks, 1));
+
+    std::atomic<size_t> nextBlock{0};
+    auto worker = [&]() {
+        for (size_t b = nextBlock++; b < blocks; b = nextBlock++) {
+            size_t end = std::min(n, (b + 1) * kRowBlock);
+            for (size_t i = b * kRowBlock; i < end; ++i) processRow(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    result.offsets.assign(n + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        result.feasibleCount += rowCounts[i];
+        result.offsets[i + 1] = result.offsets[i] + (params.buildAdjacency ? rowCounts[i] : 0);
+    }
+    if (params.buildAdjacency) {
+        result.entries.reserve(result.offsets[n]);
+        for (auto& row : rows) {
+            result.entries.insert(result.entries.end(), row.begin(), row.end());
+            std::vector<LinkBudgetEntry>().swap(row);
+        }
+    }
+    CountProfileEvent("link_budget_pairs", n * (n ? n - 1 : 0));
+    CountProfileEvent("link_budget_feasible", result.feasibleCount);
+    if (params.terrain) CountProfileEvent("terrain_queries", terrainQueries.load());
+    return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "LDT_shared.h"
+#include "terrain.h"
+
+// Path-loss model used by the link-budget kernel
+enum class PathLossModel {
+    Friis,    // free space, exponent fixed at 2
+    CloseIn   // CI model: FSPL(1 m) + 10 n log10(d), as in lunar_dt_CI.cc
+};
+
+struct LinkBudgetParams {
+    PathLossModel model{PathLossModel::Friis};
+    double exponent{2.2};        // CI path-loss exponent n (ignored for Friis)
+    double bandwidthHz{20e6};    // 802.11a channel width
+    double noiseFigureDb{8.0};   // same RxNoiseFigure as lunarTransmissionSim.cc
+    double txGainDbi{0.0};
+    double rxGainDbi{0.0};
+    double minSnrDb{5.0};        // links at or above this SNR are feasible
+    unsigned threads{0};         // 0 = all hardware threads
+    bool buildAdjacency{true};   // also compute per-link budgets for feasible pairs
+    const TerrainMap* terrain{}; // if set, pairs feasible in free space also pay diffraction loss
+};
+
+// Structure-of-arrays view of a scenario consumed by the kernel
+struct LinkBudgetNodes {
+    std::vector<double> x, y, z;
+    std::vector<double> txPowerDbm;
+    std::vector<double> refLossDb;   // path loss at 1 m for the node's tx frequency
+    std::vector<double> wavelengthM; // of the node's tx frequency
+};
+
+// Dense N x N bit matrix, row = transmitter, column = receiver
+struct FeasibilityMatrix {
+    size_t n{};
+    size_t wordsPerRow{};
+    std::vector<uint64_t> bits;
+
+    bool feasible(size_t tx, size_t rx) const
+    {
+        return (bits[tx * wordsPerRow + rx / 64] >> (rx % 64)) & 1u;
+    }
+};
+
+struct LinkBudgetEntry {
+    uint32_t rx;
+    float distance;
+    float pathLossDb;
+    float rxPowerDbm;
+    float snrDb;
+    float terrainLossDb;
+};
+
+// Feasible links in compressed rows: links of tx i are
+// entries[offsets[i] .. offsets[i + 1])
+struct LinkBudgetResult {
+    FeasibilityMatrix feasible;
+    std::vector<uint64_t> offsets;
+    std::vector<LinkBudgetEntry> entries;
+    size_t feasibleCount{};
+};
+
+// Path loss at 1 m for a carrier in MHz (FSPL(1m) = 32.44 + 20 log10(f_GHz))
+double ReferenceLossDb(double freqMHz);
+
+LinkBudgetNodes MakeLinkBudgetNodes(const std::vector<NodeConfig>& nodes);
+
+LinkBudgetResult ComputeLinkBudgets(const LinkBudgetNodes& nodes, const LinkBudgetParams& params);
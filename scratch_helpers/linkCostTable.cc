@@ -0,0 +1,125 @@
+#include "linkCostTable.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+static const double kSpeedOfLight = 299792458.0;
+
+double ParseDataRateBps(const std::string& text)
+{
+    const char* s = text.c_str();
+    char* end = nullptr;
+    double value = std::strtod(s, &end);
+    if (end == s || value < 0.0) return 0.0;
+
+    std::string unit;
+    for (const char* p = end; *p; ++p)
+        if (!std::isspace(static_cast<unsigned char>(*p)) && *p != '"') unit += *p;
+
+    if (unit.empty() || unit == "bps" || unit == "b/s") return value;
+    if (unit == "kbps" || unit == "Kbps" || unit == "kb/s") return value * 1e3;
+    if (unit == "Mbps" || unit == "mbps" || unit == "Mb/s") return value * 1e6;
+    if (unit == "Gbps" || unit == "gbps" || unit == "Gb/s") return value * 1e9;
+    if (unit == "Bps") return value * 8.0;
+    if (unit == "KBps" || unit == "kBps") return value * 8e3;
+    if (unit == "MBps") return value * 8e6;
+    if (unit == "GBps") return value * 8e9;
+    return 0.0;
+}
+
+double LatencyLowerBoundPerMetre()
+{
+    return 1.0 / kSpeedOfLight;
+}
+
+static uint64_t signatureOf(const RadioProfile& r)
+{
+    double fields[] = {r.position.x, r.position.y, r.position.z, r.freqMHz,
+                       r.txPowerDbm, r.txRateBps, r.rxRateBps};
+    uint64_t h = 1469598103934665603ull;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(fields);
+    for (size_t i = 0; i < sizeof(fields); ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+void LinkCostTable::setParams(const LinkCostParams& params)
+{
+    params_ = params;
+    nodeSignatures_.clear(); // every edge is stale now
+}
+
+// Path loss from the CI model, capacity limited by both the configured
+// data rates and the Shannon bound at the link SNR, latency as propagation
+// + serialization + per-hop processing.
+LinkCostEntry LinkCostTable::evaluate(const RadioProfile& tx, const RadioProfile& rx) const
+{
+    LinkCostEntry e;
+    const double inf = std::numeric_limits<double>::infinity();
+    double d = std::max(EuclideanDistance(tx.position, rx.position), 1.0);
+
+    if (tx.freqMHz <= 0.0) {
+        e.pathLossDb = e.latencyS = inf;
+        e.snrDb = -inf;
+        return e;
+    }
+    double noiseDbm = -174.0 + 10.0 * std::log10(params_.bandwidthHz) + params_.noiseFigureDb;
+    e.pathLossDb = 32.44 + 20.0 * std::log10(tx.freqMHz / 1000.0) + 10.0 * params_.exponent * std::log10(d);
+    e.snrDb = tx.txPowerDbm - e.pathLossDb - noiseDbm;
+    if (e.snrDb < params_.minSnrDb) {
+        e.latencyS = inf;
+        return e;
+    }
+
+    e.capacityBps = params_.bandwidthHz * std::log2(1.0 + std::pow(10.0, e.snrDb / 10.0));
+    if (tx.txRateBps > 0.0) e.capacityBps = std::min(e.capacityBps, tx.txRateBps);
+    if (rx.rxRateBps > 0.0) e.capacityBps = std::min(e.capacityBps, rx.rxRateBps);
+
+    e.latencyS = d / kSpeedOfLight + params_.packetBytes * 8.0 / e.capacityBps + params_.perHopDelayS;
+    return e;
+}
+
+size_t LinkCostTable::update(const RoutingGraph& graph, const std::vector<RadioProfile>& radios)
+{
+    const uint32_t n = graph.nodeCount();
+
+    // Topology changes (different links) invalidate the whole table
+    uint64_t topology = 1469598103934665603ull;
+    for (uint32_t v : graph.offsets) { topology ^= v; topology *= 1099511628211ull; }
+    for (uint32_t v : graph.targets) { topology ^= v; topology *= 1099511628211ull; }
+    bool full = topology != topology_ || nodeSignatures_.size() != n;
+    if (full) {
+        topology_ = topology;
+        nodeSignatures_.assign(n, 0);
+        entries_.assign(graph.edgeCount(), LinkCostEntry());
+        costs_.assign(graph.edgeCount(), std::numeric_limits<double>::infinity());
+    }
+
+    std::vector<char> dirty(n, 0);
+    bool anyDirty = false;
+    for (uint32_t v = 0; v < n; ++v) {
+        uint64_t sig = signatureOf(radios[v]);
+        if (full || sig != nodeSignatures_[v]) {
+            nodeSignatures_[v] = sig;
+            dirty[v] = 1;
+            anyDirty = true;
+        }
+    }
+    if (!anyDirty) return 0;
+
+    size_t evaluated = 0;
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t k = graph.offsets[u]; k < graph.offsets[u + 1]; ++k) {
+            uint32_t v = graph.targets[k];
+            if (!dirty[u] && !dirty[v]) continue;
+            entries_[k] = evaluate(radios[u], radios[v]);
+            costs_[k] = entries_[k].latencyS;
+            ++evaluated;
+        }
+    }
+    return evaluated;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "routingGraph.h"
+
+// Radio parameters of one routing node (see NodeConfig)
+struct RadioProfile {
+    NodePosition position{};
+    double freqMHz{};
+    double txPowerDbm{};
+    double txRateBps{};   // 0 = not configured
+    double rxRateBps{};
+};
+
+struct LinkCostParams {
+    double exponent{2.2};         // CI path-loss exponent, as in lunar_dt_CI.cc
+    double bandwidthHz{20e6};     // 802.11a channel
+    double noiseFigureDb{8.0};
+    double minSnrDb{5.0};         // below this the link is unusable
+    double packetBytes{512.0};    // echo payload used by lunarTransmissionSim.cc
+    double perHopDelayS{1e-3};    // forwarding/processing time per hop
+};
+
+struct LinkCostEntry {
+    double pathLossDb{};
+    double snrDb{};
+    double capacityBps{};
+    double latencyS{};            // routing cost; infinity if the link cannot close
+};
+
+// Per-edge radio cost aligned with RoutingGraph::targets. Costs are
+// computed once; update() recomputes only edges touching nodes whose
+// position or radio parameters changed.
+class LinkCostTable {
+public:
+    void setParams(const LinkCostParams& params);
+    const LinkCostParams& params() const { return params_; }
+
+    // Recompute everything that is stale; returns the number of edges evaluated
+    size_t update(const RoutingGraph& graph, const std::vector<RadioProfile>& radios);
+
+    const std::vector<double>& costs() const { return costs_; }
+    const LinkCostEntry& entry(uint32_t edge) const { return entries_[edge]; }
+    bool empty() const { return costs_.empty(); }
+
+    // Cost of a single tx -> rx link under the current parameters
+    LinkCostEntry evaluate(const RadioProfile& tx, const RadioProfile& rx) const;
+
+private:
+    LinkCostParams params_;
+    uint64_t topology_{};
+    std::vector<uint64_t> nodeSignatures_;
+    std::vector<LinkCostEntry> entries_;
+    std::vector<double> costs_;
+};
+
+// Latency lower bound per metre of straight-line distance (1/c), used to
+// scale the A* heuristic when routing on link latencies
+double LatencyLowerBoundPerMetre();
+
+// Parse "10Mbps", "1.5 Gbps", "9600" (bps) ...; returns 0 if empty or invalid
+double ParseDataRateBps(const std::string& text);
@@ -0,0 +1,165 @@
+#include "linkResultCache.h"
+#include "scenarioCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// The ns-3 build the simulator code comes from: the shared library (or, in
+// a static build, the executable) holding Simulator::Now, with its size and
+// mtime, so rebuilding or upgrading ns-3 invalidates every entry
+std::string SimulatorBuildId()
+{
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&ns3::Simulator::Now), &info) == 0 || !info.dli_fname)
+        return "unknown";
+    std::ostringstream id;
+    id << fs::path(info.dli_fname).filename().string();
+    struct stat st;
+    if (stat(info.dli_fname, &st) == 0)
+        id << ':' << st.st_size << ':' << st.st_mtim.tv_sec;
+    return id.str();
+}
+
+// Every attribute default changed from the value its TypeId registered
+// (NS_ATTRIBUTE_DEFAULT, Config::SetDefault), as sorted "Type::Name=value"
+std::string ChangedAttributeDefaults()
+{
+    std::vector<std::string> changed;
+    for (uint16_t i = 0; i < ns3::TypeId::GetRegisteredN(); ++i) {
+        ns3::TypeId tid = ns3::TypeId::GetRegistered(i);
+        for (std::size_t j = 0; j < tid.GetAttributeN(); ++j) {
+            ns3::TypeId::AttributeInformation info = tid.GetAttribute(j);
+            if (!info.initialValue || !info.originalInitialValue || !info.checker)
+                continue;
+            std::string value = info.initialValue->SerializeToString(info.checker);
+            if (value != info.originalInitialValue->SerializeToString(info.checker))
+                changed.push_back(tid.GetName() + "::" + info.name + "=" + value);
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    std::string joined;
+    for (const std::string& c : changed) {
+        if (!joined.empty()) joined += ';';
+        joined += c;
+    }
+    // The key is stored as one line of the entry file
+    std::replace(joined.begin(), joined.end(), '\n', ' ');
+    return joined;
+}
+
+LinkResultCache::LinkResultCache(std::string dir)
+    : dir_(std::move(dir)),
+      simulatorId_(SimulatorBuildId()),
+      attributeDefaults_(ChangedAttributeDefaults())
+{
+}
+
+// Doubles are written as hex floats, so the key changes with any input bit
+std::string LinkResultCache::Key(const LinkJob& link) const
+{
+    std::ostringstream key;
+    key << std::hexfloat
+        << "model=" << kLinkModelVersion
+        << " ns3=" << simulatorId_
+        << " seed=" << RngSeedManager::GetSeed()
+        << " run=" << RngSeedManager::GetRun()
+        << " d=" << link.distance
+        << " f=" << link.freqMHz
+        << " p=" << link.txPowerdBm
+        << " rate=" << link.rate
+        << " defaults=" << attributeDefaults_;
+    return key.str();
+}
+
+std::string LinkResultCache::pathOf(const std::string& key) const
+{
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx",
+                  static_cast<unsigned long long>(ScenarioContentHash(key)));
+    return dir_ + "/" + std::string(name, 2) + "/" + name + ".lr";
+}
+
+bool LinkResultCache::Lookup(const LinkJob& link, LinkResult& result)
+{
+    std::string key = Key(link);
+    std::ifstream in(pathOf(key));
+    std::string magic, storedKey, values;
+    if (in.is_open() && std::getline(in, magic) && magic == "LDTLR1" && std::getline(in, storedKey) &&
+        storedKey == key && std::getline(in, values)) {
+        std::istringstream fields(values);
+        std::string rtt;
+        LinkResult r;
+        if (fields >> r.packetsSent >> r.packetsReceived >> rtt) {
+            r.meanRttMs = std::strtod(rtt.c_str(), nullptr);
+            result = r;
+            ++stats_.hits;
+            return true;
+        }
+    }
+    ++stats_.misses;
+    return false;
+}
+
+void LinkResultCache::Store(const LinkJob& link, const LinkResult& result)
+{
+    std::string key = Key(link);
+    std::string path = pathOf(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << "LDTLR1\n" << key << '\n' << result.packetsSent << ' ' << result.packetsReceived << ' '
+            << std::hexfloat << result.meanRttMs << '\n';
+        if (!out) {
+            ++stats_.writeErrors;
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ++stats_.writeErrors;
+        fs::remove(tmp, ec);
+        return;
+    }
+    ++stats_.stores;
+}
+
+void PrintLinkCacheReport(const LinkResultCache& cache, std::ostream& out)
+{
+    const LinkCacheStats& s = cache.Stats();
+    uint64_t lookups = s.hits + s.misses;
+    out << "[CACHE] Link results: " << s.hits << " hits, " << s.misses << " misses";
+    if (lookups > 0) {
+        const std::streamsize precision = out.precision();
+        out << " (" << std::fixed << std::setprecision(1) << 100.0 * s.hits / lookups << "% hit rate)"
+            << std::defaultfloat << std::setprecision(precision);
+    }
+    out << ", " << s.stores << " stored";
+    if (s.writeErrors > 0) out << ", " << s.writeErrors << " write errors";
+    out << " [" << cache.Directory() << "]" << std::endl;
+}
+
+static ns3::GlobalValue g_resultCache("LdtResultCache",
+                                      "Reuse simulateTransmission() results stored on disk",
+                                      ns3::BooleanValue(true),
+                                      ns3::MakeBooleanChecker());
+
+bool LinkResultCachingEnabled()
+{
+    ns3::BooleanValue value;
+    g_resultCache.GetValue(value);
+    return value.Get();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include "LDT_shared.h"
+
+// Model behind simulateTransmission(); bump it whenever that function (PHY,
+// loss chain, echo traffic) changes so old results stop matching
+static const char* const kLinkModelVersion = "80211a-ap/friis+fixedrss-3dBm/nf8/echo5x512B@1s/v3";
+
+// Persistent cache of simulateTransmission() results. Entries are addressed
+// by a hash of the canonical key text: the link inputs, the RNG seed and
+// run, kLinkModelVersion, the identity of the ns-3 build (library name,
+// size and mtime) and every changed attribute default. The defaults are
+// read when the cache is constructed; Config::SetDefault calls made while
+// a cache is alive are not seen by it. Each entry is a file <dir>/<hh>/<hash>.lr that also
+// stores the key text, so a hash collision reads as a miss, never as a
+// wrong result. Entries are written to a temporary file and renamed, so
+// concurrent writers (forked workers, the job server) never see partial files.
+struct LinkCacheStats {
+    uint64_t hits{};
+    uint64_t misses{};
+    uint64_t stores{};
+    uint64_t writeErrors{};
+};
+
+class LinkResultCache {
+public:
+    explicit LinkResultCache(std::string dir = "./scratch/output/link_cache");
+
+    // Canonical description of everything the link result depends on
+    std::string Key(const LinkJob& link) const;
+
+    bool Lookup(const LinkJob& link, LinkResult& result);
+    void Store(const LinkJob& link, const LinkResult& result);
+
+    const LinkCacheStats& Stats() const { return stats_; }
+    const std::string& Directory() const { return dir_; }
+
+private:
+    std::string pathOf(const std::string& key) const;
+
+    std::string dir_;
+    std::string simulatorId_;
+    std::string attributeDefaults_;
+    LinkCacheStats stats_;
+};
+
+// "[CACHE] ..." line with hit/miss counts and hit rate
+void PrintLinkCacheReport(const LinkResultCache& cache, std::ostream& out);
+
+// Identity of the ns-3 build in use (library name, size and mtime)
+std::string SimulatorBuildId();
+
+// Attribute defaults that differ from their registered values, sorted
+// "Type::Name=value" joined by ';' (empty when none were changed)
+std::string ChangedAttributeDefaults();
+
+// Global switch, settable with NS_GLOBAL_VALUE="LdtResultCache=false"
+bool LinkResultCachingEnabled();
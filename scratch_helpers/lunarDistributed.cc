@@ -0,0 +1,479 @@
+/* -*- Mode: C++; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+  Lunar DT Distributed Simulation Module
+  --------------------------------------
+  Runs the CI topology (Earth, LunarGW, lunar surface cells and their UEs)
+  split across ns-3 MPI ranks. Entry point for scratch/LDT_mpi.cc; uses the
+  topology helpers of lunar_dt_CI.cc, which must be included first.
+
+  The LTE radio stack cannot be distributed in ns-3, so every hop is a
+  point-to-point link with the propagation delay of the real geometry:
+  Earth <-> LunarGW (1.28 s), LunarGW <-> cell (backhaul) and cell <-> UE.
+  LDT_mpi uses null-message synchronization, where each rank only waits on
+  the ranks it has links to, with those links' delays as lookahead: the
+  Earth rank runs up to 1.28 s ahead of the gateway, while the surface
+  strips keep step with the gateway at the backhaul delay (about 1 ms).
+*/
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include "kdTree.h"
+#include "scenarioCache.h"
+
+using namespace ns3;
+
+// --------------------------- Partition ---------------------------------------
+// Rank of every node. Earth (ground segment) runs on rank 0 and the gateway
+// with its backhaul on rank 1; the surface cells are cut into contiguous
+// strips along their widest horizontal axis, one strip per remaining rank,
+// balanced by the number of UEs each cell serves. UEs follow their cell.
+// With fewer than three ranks the segments fold onto the last rank.
+struct LunarPartition
+{
+  uint32_t ranks = 1;
+  uint32_t earth = 0;
+  uint32_t gateway = 0;
+  std::vector<uint32_t> enb;
+  std::vector<uint32_t> ue;
+};
+
+static LunarPartition PartitionLunarTopology(const CiTopology& topo, const std::vector<uint32_t>& serving,
+                                             uint32_t ranks)
+{
+  LunarPartition part;
+  part.ranks = std::max<uint32_t>(ranks, 1);
+  part.gateway = std::min<uint32_t>(1, part.ranks - 1);
+  uint32_t firstSurface = std::min<uint32_t>(2, part.ranks - 1);
+  uint32_t strips = part.ranks - firstSurface;
+  part.enb.assign(topo.enbPos.size(), firstSurface);
+
+  if (strips > 1 && !topo.enbPos.empty())
+  {
+    double minX = topo.enbPos[0].x, maxX = minX, minY = topo.enbPos[0].y, maxY = minY;
+    for (const Vector& p : topo.enbPos)
+    {
+      minX = std::min(minX, p.x);
+      maxX = std::max(maxX, p.x);
+      minY = std::min(minY, p.y);
+      maxY = std::max(maxY, p.y);
+    }
+    bool alongX = maxX - minX >= maxY - minY;
+
+    std::vector<uint32_t> order(topo.enbPos.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return alongX ? topo.enbPos[a].x < topo.enbPos[b].x : topo.enbPos[a].y < topo.enbPos[b].y;
+    });
+
+    // A cell costs its own events plus those of the UEs it serves
+    std::vector<double> load(topo.enbPos.size(), 1.0);
+    for (uint32_t s : serving)
+      load[s] += 1.0;
+    double total = std::accumulate(load.begin(), load.end(), 0.0);
+
+    double filled = 0.0;
+    uint32_t strip = 0;
+    for (uint32_t i : order)
+    {
+      if (strip + 1 < strips && filled >= total * (strip + 1) / strips)
+        ++strip;
+      part.enb[i] = firstSurface + strip;
+      filled += load[i];
+    }
+  }
+
+  part.ue.resize(serving.size());
+  for (size_t i = 0; i < serving.size(); ++i)
+    part.ue[i] = part.enb[serving[i]];
+  return part;
+}
+
+// Serving cell of every UE: the nearest cell
+static std::vector<uint32_t> NearestCells(const CiTopology& topo)
+{
+  std::vector<double> xs, ys, zs;
+  xs.reserve(topo.enbPos.size());
+  ys.reserve(topo.enbPos.size());
+  zs.reserve(topo.enbPos.size());
+  for (const Vector& p : topo.enbPos)
+  {
+    xs.push_back(p.x);
+    ys.push_back(p.y);
+    zs.push_back(p.z);
+  }
+  KdTree tree;
+  tree.build(xs, ys, zs);
+
+  std::vector<uint32_t> serving(topo.uePos.size(), 0);
+  std::vector<KdNeighbor> nearest;
+  for (size_t i = 0; i < topo.uePos.size(); ++i)
+  {
+    tree.nearest(topo.uePos[i].x, topo.uePos[i].y, topo.uePos[i].z, 1, nearest);
+    if (!nearest.empty())
+      serving[i] = nearest[0].index;
+  }
+  return serving;
+}
+
+// --------------------------- Timing log --------------------------------------
+// One row per run in scratch/output/ldt_mpi_timing.csv; runs with the same
+// config key simulate the same scenario, so ranks=1 rows are the baseline
+struct DistributedTiming
+{
+  std::string config;
+  uint32_t ranks = 1;
+  uint32_t nodes = 0;
+  double setupS = 0.0;
+  double runS = 0.0;
+  uint64_t sent = 0;
+  uint64_t echoed = 0;
+};
+
+static bool FindSequentialBaseline(const std::string& path, const std::string& config, DistributedTiming& baseline)
+{
+  std::ifstream in(path.c_str());
+  std::string line;
+  bool found = false;
+  while (std::getline(in, line))
+  {
+    std::istringstream row(line);
+    DistributedTiming t;
+    std::string field;
+    std::vector<std::string> fields;
+    while (std::getline(row, field, ','))
+      fields.push_back(field);
+    if (fields.size() != 7 || fields[0] != config || fields[1] != "1")
+      continue;
+    try
+    {
+      t.config = fields[0];
+      t.nodes = static_cast<uint32_t>(std::stoul(fields[2]));
+      t.setupS = std::stod(fields[3]);
+      t.runS = std::stod(fields[4]);
+      t.sent = std::stoull(fields[5]);
+      t.echoed = std::stoull(fields[6]);
+    }
+    catch (const std::exception&)
+    {
+      std::cerr << "[WARNING] Skipping malformed row in " << path << ": " << line << std::endl;
+      continue;
+    }
+    baseline = t; // latest baseline wins
+    found = true;
+  }
+  return found;
+}
+
+static void AppendTiming(const std::string& path, const DistributedTiming& t)
+{
+  std::filesystem::path p(path);
+  if (p.has_parent_path())
+    std::filesystem::create_directories(p.parent_path());
+  bool fresh = !std::filesystem::exists(p);
+  std::ofstream out(path.c_str(), std::ios::app);
+  if (!out.is_open())
+  {
+    std::cerr << "[WARNING] Could not write timing log " << path << std::endl;
+    return;
+  }
+  if (fresh)
+    out << "config,ranks,nodes,setup_s,run_s,sent,echoed\n";
+  out << t.config << ',' << t.ranks << ',' << t.nodes << ',' << std::setprecision(6) << t.setupS << ','
+      << t.runS << ',' << t.sent << ',' << t.echoed << '\n';
+}
+
+// --------------------------- Echo counters -----------------------------------
+// Applications on this rank only; summed over ranks after the run
+static uint64_t g_echoSent = 0;
+static uint64_t g_echoReceived = 0;
+
+static void CountEchoTx(Ptr<const Packet>)
+{
+  ++g_echoSent;
+}
+
+static void CountEchoRx(Ptr<const Packet>)
+{
+  ++g_echoReceived;
+}
+
+// ----------------------------------------------------------------------------
+// Entry point for LDT_mpi.cc. MpiInterface must already be enabled when the
+// program runs under mpirun; otherwise the model runs on this process alone.
+// ----------------------------------------------------------------------------
+int runLunarDistributed(int argc, char* argv[])
+{
+  uint32_t rank = 0;
+  uint32_t ranks = 1;
+#ifdef NS3_MPI
+  if (MpiInterface::IsEnabled())
+  {
+    rank = MpiInterface::GetSystemId();
+    ranks = MpiInterface::GetSize();
+  }
+#endif
+  const bool root = rank == 0;
+  auto setupStart = std::chrono::steady_clock::now();
+
+  double L = 1200.0;
+  uint32_t numEnb = 0;
+  uint32_t numUe = 0;
+  std::string layout = "grid";
+  double enbSpacing = 150.0;
+  std::string scenarioFile;
+  std::string conf;
+  double earthDelay = 1.28;
+  std::string earthRate = "10Mbps";
+  double backhaulDelay = 0.001;
+  std::string backhaulRate = "100Mbps";
+  std::string surfaceRate = "20Mbps";
+  uint32_t packets = 10;
+  double interval = 1.0;
+  uint32_t packetSize = 512;
+  double simTime = 0.0;
+  bool sequential = false;
+  std::string timingFile = "./scratch/output/ldt_mpi_timing.csv";
+
+  CommandLine cmd;
+  cmd.AddValue("L", "Moon offset in meters along +X (gateway position)", L);
+  cmd.AddValue("numEnb", "Number of generated cells (0 = built-in demo layout)", numEnb);
+  cmd.AddValue("numUe", "Number of generated UEs", numUe);
+  cmd.AddValue("layout", "Generated cell layout: grid | hex | random", layout);
+  cmd.AddValue("enbSpacing", "Distance between generated cells (m)", enbSpacing);
+  cmd.AddValue("scenario", "NODECONFIGHEADER scenario with eNB/UE/Gateway/Earth nodes", scenarioFile);
+  cmd.AddValue("conf", "Path to config file (same keys as the CI simulation)", conf);
+  cmd.AddValue("earthDelay", "Earth-Moon one-way delay (s)", earthDelay);
+  cmd.AddValue("earthRate", "Earth-Moon link data rate", earthRate);
+  cmd.AddValue("backhaulDelay", "Gateway-cell backhaul delay on top of propagation (s)", backhaulDelay);
+  cmd.AddValue("backhaulRate", "Gateway-cell backhaul data rate", backhaulRate);
+  cmd.AddValue("surfaceRate", "Cell-UE link data rate", surfaceRate);
+  cmd.AddValue("packets", "Echo requests sent by every UE to Earth", packets);
+  cmd.AddValue("interval", "Interval between echo requests (s)", interval);
+  cmd.AddValue("packetSize", "Echo payload size (bytes)", packetSize);
+  cmd.AddValue("simTime", "Simulated time (s, 0 = until the last echo returns)", simTime);
+  cmd.AddValue("sequential", "Run without MPI to record the sequential baseline", sequential);
+  cmd.AddValue("timingFile", "CSV log of run times used for the speedup report", timingFile);
+  cmd.Parse(argc, argv);
+
+  if (!conf.empty())
+  {
+    std::unordered_map<std::string, std::string> kv;
+    if (!LoadConfigFile(conf, kv))
+      return -1;
+    if (kv.count("L")) L = std::stod(kv["L"]);
+    if (kv.count("numEnb")) numEnb = static_cast<uint32_t>(std::stoul(kv["numEnb"]));
+    if (kv.count("numUe")) numUe = static_cast<uint32_t>(std::stoul(kv["numUe"]));
+    if (kv.count("layout")) layout = kv["layout"];
+    if (kv.count("enbSpacing")) enbSpacing = std::stod(kv["enbSpacing"]);
+    if (kv.count("scenario")) scenarioFile = kv["scenario"];
+    if (kv.count("earthDelay")) earthDelay = std::stod(kv["earthDelay"]);
+    if (kv.count("earthRate")) earthRate = kv["earthRate"];
+    if (kv.count("backhaulDelay")) backhaulDelay = std::stod(kv["backhaulDelay"]);
+    if (kv.count("backhaulRate")) backhaulRate = kv["backhaulRate"];
+    if (kv.count("surfaceRate")) surfaceRate = kv["surfaceRate"];
+    if (kv.count("packets")) packets = static_cast<uint32_t>(std::stoul(kv["packets"]));
+    if (kv.count("interval")) interval = std::stod(kv["interval"]);
+    if (kv.count("packetSize")) packetSize = static_cast<uint32_t>(std::stoul(kv["packetSize"]));
+    if (kv.count("simTime")) simTime = std::stod(kv["simTime"]);
+  }
+  if (simTime <= 0.0)
+    simTime = 2.0 + packets * interval + 2.0 * earthDelay;
+
+  // Every rank builds the same topology (random layouts use the default
+  // seed), so all ranks agree on node ids and the partition
+  CiTopology topo;
+  if (!scenarioFile.empty())
+  {
+    if (!LoadCiTopology(scenarioFile, topo))
+      return -1;
+  }
+  else if (numEnb > 0)
+    GenerateCiTopology(L, numEnb, numUe, layout, enbSpacing, topo);
+  else
+    DefaultCiTopology(L, topo);
+
+  std::vector<uint32_t> serving = NearestCells(topo);
+  LunarPartition part = PartitionLunarTopology(topo, serving, ranks);
+
+  // Nodes exist on every rank; each is simulated only by its systemId
+  NodeContainer earth;
+  earth.Create(1, part.earth);
+  NodeContainer lunarGw;
+  lunarGw.Create(1, part.gateway);
+  NodeContainer cells;
+  for (uint32_t r : part.enb)
+    cells.Create(1, r);
+  NodeContainer ues;
+  for (uint32_t r : part.ue)
+    ues.Create(1, r);
+
+  InternetStackHelper internet;
+  internet.Install(earth);
+  internet.Install(lunarGw);
+  internet.Install(cells);
+  internet.Install(ues);
+
+  // Links between nodes on different ranks become remote channels; their
+  // delays are the lookahead between those ranks (Earth-Moon and backhaul
+  // cuts reported separately)
+  const double c = 299792458.0;
+  PointToPointHelper p2p;
+  Ipv4AddressHelper address("10.0.0.0", "255.255.255.252");
+  double lookahead = std::numeric_limits<double>::infinity();
+  auto link = [&](Ptr<Node> a, Ptr<Node> b, const std::string& rate, double delay) {
+    p2p.SetDeviceAttribute("DataRate", StringValue(rate));
+    p2p.SetChannelAttribute("Delay", TimeValue(Seconds(delay)));
+    Ipv4InterfaceContainer ifs = address.Assign(p2p.Install(a, b));
+    address.NewNetwork();
+    if (a->GetSystemId() != b->GetSystemId())
+      lookahead = std::min(lookahead, delay);
+    return ifs;
+  };
+
+  Ipv4InterfaceContainer earthLink = link(earth.Get(0), lunarGw.Get(0), earthRate, earthDelay);
+  const double earthLookahead = lookahead;
+  lookahead = std::numeric_limits<double>::infinity();
+  for (uint32_t i = 0; i < cells.GetN(); ++i)
+    link(lunarGw.Get(0), cells.Get(i), backhaulRate,
+         backhaulDelay + CalculateDistance(topo.gateway, topo.enbPos[i]) / c);
+  const double backhaulLookahead = lookahead;
+  for (uint32_t i = 0; i < ues.GetN(); ++i)
+    link(cells.Get(serving[i]), ues.Get(i), surfaceRate,
+         std::max(CalculateDistance(topo.enbPos[serving[i]], topo.uePos[i]) / c, 1e-6));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+  // Applications only on the nodes this rank owns
+  const uint16_t port = 9;
+  if (part.earth == rank)
+  {
+    UdpEchoServerHelper server(port);
+    ApplicationContainer apps = server.Install(earth.Get(0));
+    apps.Start(Seconds(0.0));
+    apps.Stop(Seconds(simTime));
+  }
+  UdpEchoClientHelper client(earthLink.GetAddress(0), port);
+  client.SetAttribute("MaxPackets", UintegerValue(packets));
+  client.SetAttribute("Interval", TimeValue(Seconds(interval)));
+  client.SetAttribute("PacketSize", UintegerValue(packetSize));
+  for (uint32_t i = 0; i < ues.GetN(); ++i)
+  {
+    if (part.ue[i] != rank)
+      continue;
+    ApplicationContainer apps = client.Install(ues.Get(i));
+    apps.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&CountEchoTx));
+    apps.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&CountEchoRx));
+    // Spread the first requests over one interval
+    apps.Start(Seconds(1.0 + interval * (i % 100) / 100.0));
+    apps.Stop(Seconds(simTime));
+  }
+
+  DistributedTiming timing;
+  timing.ranks = ranks;
+  timing.nodes = 2 + cells.GetN() + ues.GetN();
+  timing.setupS = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+
+  if (root)
+  {
+    std::vector<uint32_t> perRank(part.ranks, 0);
+    perRank[part.earth]++;
+    perRank[part.gateway]++;
+    for (uint32_t r : part.enb)
+      perRank[r]++;
+    for (uint32_t r : part.ue)
+      perRank[r]++;
+    std::cout << "\n[INFO] === Lunar DT distributed simulation ===\n"
+              << "  Ranks: " << ranks << (ranks == 1 ? " (sequential)" : "") << "\n"
+              << "  Nodes: " << timing.nodes << " (" << cells.GetN() << " cells, " << ues.GetN() << " UEs)\n";
+    for (uint32_t r = 0; r < part.ranks; ++r)
+    {
+      std::cout << "  rank " << r << ": " << perRank[r] << " nodes"
+                << (r == part.earth ? " [Earth]" : "") << (r == part.gateway ? " [LunarGW]" : "") << "\n";
+      if (perRank[r] == 0)
+        std::cout << "[WARNING] Rank " << r << " has no nodes; use fewer ranks or more cells." << std::endl;
+    }
+    if (ranks > 1)
+    {
+      auto ms = [](double s) { return std::isinf(s) ? std::string("-") : std::to_string(s * 1e3) + " ms"; };
+      std::cout << "  Lookahead: Earth-Moon " << ms(earthLookahead) << ", backhaul " << ms(backhaulLookahead)
+                << "\n";
+    }
+    std::cout << std::flush;
+  }
+
+  Simulator::Stop(Seconds(simTime));
+  auto runStart = std::chrono::steady_clock::now();
+  Simulator::Run();
+  timing.runS = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+  Simulator::Destroy();
+
+  timing.sent = g_echoSent;
+  timing.echoed = g_echoReceived;
+#ifdef NS3_MPI
+  if (ranks > 1)
+  {
+    // Slowest rank sets the wall time; echo counts add up
+    double localTimes[2] = {timing.setupS, timing.runS};
+    double times[2] = {0.0, 0.0};
+    MPI_Reduce(localTimes, times, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    uint64_t localCounts[2] = {timing.sent, timing.echoed};
+    uint64_t counts[2] = {0, 0};
+    MPI_Reduce(localCounts, counts, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    timing.setupS = times[0];
+    timing.runS = times[1];
+    timing.sent = counts[0];
+    timing.echoed = counts[1];
+  }
+#endif
+  if (!root)
+    return 0;
+
+  // Everything that changes the simulated scenario goes into the key
+  std::ostringstream key;
+  key << L << '|' << numEnb << '|' << numUe << '|' << layout << '|' << enbSpacing << '|' << scenarioFile << '|'
+      << earthDelay << '|' << earthRate << '|' << backhaulDelay << '|' << backhaulRate << '|' << surfaceRate << '|'
+      << packets << '|' << interval << '|' << packetSize << '|' << simTime;
+  std::ostringstream hex;
+  hex << std::hex << std::setw(16) << std::setfill('0') << ScenarioContentHash(key.str());
+  timing.config = hex.str();
+
+  DistributedTiming baseline;
+  bool haveBaseline = FindSequentialBaseline(timingFile, timing.config, baseline);
+  AppendTiming(timingFile, timing);
+
+  const std::streamsize precision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(3)
+            << "[TIMING] setup " << timing.setupS << " s, run " << timing.runS << " s on " << ranks << " rank(s)\n"
+            << "[INFO] Echo requests sent: " << timing.sent << ", replies received: " << timing.echoed << "\n";
+  if (ranks > 1 && haveBaseline)
+  {
+    std::cout << "[TIMING] Sequential run " << baseline.runS << " s -> speedup " << std::setprecision(2)
+              << baseline.runS / std::max(timing.runS, 1e-9) << "x on " << ranks << " ranks\n";
+    if (baseline.sent != timing.sent || baseline.echoed != timing.echoed)
+      std::cout << "[WARNING] Echo counts differ from the sequential run (" << baseline.sent << "/" << baseline.echoed
+                << ")." << std::endl;
+  }
+  else if (ranks > 1)
+    std::cout << "[INFO] No sequential baseline for config " << timing.config
+              << "; run once with --sequential to record one.\n";
+  std::cout << std::defaultfloat << std::setprecision(precision) << "  Timing log: " << timingFile << "\n" << std::endl;
+  return 0;
+}
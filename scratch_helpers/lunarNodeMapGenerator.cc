@@ -1,14 +1,30 @@
-#include "ns3/core-module.h"
-#include "ns3/network-module.h"
-#include "ns3/mobility-module.h"
-#include "ns3/netanim-module.h"
 #include "LDT_shared.h"
+#include "netAnimWriter.h"
+#include "profiler.h"
+#include <chrono>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
 
-using namespace ns3;
+struct NodeColor {
+    uint8_t r, g, b;
+};
+
+static NodeColor classifyNodeType(std::string_view type)
+{
+    if (type.find("Base Station") != std::string_view::npos || type.find("gNB") != std::string_view::npos)
+        return {0, 128, 0};        // green
+    if (type.find("User Equipment") != std::string_view::npos)
+        return {255, 165, 0};      // orange
+    if (type.find("Gateway") != std::string_view::npos)
+        return {0, 0, 255};        // blue
+    return {200, 200, 200};        // gray
+}
 
 // ---------------------------------------------------------------------
 // generateNodeMapXML()
+// Writes the NetAnim node map straight from the node list; each distinct
+// Type string is classified once.
 // ---------------------------------------------------------------------
 void generateNodeMapXML(const std::vector<NodeConfig>& nodes,
                         const std::string& outputPath)
@@ -18,54 +34,41 @@ void generateNodeMapXML(const std::vector<NodeConfig>& nodes,
         return;
     }
 
+    ScopedPhase phase("node_map_xml");
     std::cout << "[INFO] Generating XML map: " << outputPath << std::endl;
+    auto t0 = std::chrono::steady_clock::now();
 
-    // Create node container
-    NodeContainer nodeContainer;
-    nodeContainer.Create(nodes.size());
-
-    // Assign static positions using a MobilityHelper
-    MobilityHelper mobility;
-    Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
-
-    for (size_t i = 0; i < nodes.size(); ++i) {
-        const NodeConfig& cfg = nodes[i];
-        positionAlloc->Add(Vector(cfg.x, cfg.y, cfg.z));
+    NetAnimWriter anim;
+    if (!anim.open(outputPath)) {
+        std::cerr << "[ERROR] Could not create " << outputPath << std::endl;
+        return;
     }
 
-    mobility.SetPositionAllocator(positionAlloc);
-    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    mobility.Install(nodeContainer);
-
-    // Create the NetAnim animation interface
-    AnimationInterface anim(outputPath);
-    anim.SetMaxPktsPerTraceFile(1);
-
-    // Update node visuals and descriptions
-    for (size_t i = 0; i < nodes.size(); ++i) {
-        Ptr<Node> n = nodeContainer.Get(i);
+    std::unordered_map<std::string_view, NodeColor> colorOfType;
+    const size_t listed = 20;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
         const NodeConfig& cfg = nodes[i];
+        auto it = colorOfType.find(cfg.type);
+        if (it == colorOfType.end()) it = colorOfType.emplace(cfg.type, classifyNodeType(cfg.type)).first;
 
-        anim.UpdateNodeDescription(n, cfg.name);
+        anim.node(i, cfg.x, cfg.y);
+        anim.color(i, it->second.r, it->second.g, it->second.b);
+        anim.description(i, cfg.name);
 
-        if (cfg.type.find("Base Station") != std::string::npos ||
-            cfg.type.find("gNB") != std::string::npos)
-            anim.UpdateNodeColor(n, 0, 128, 0);        // green
-        else if (cfg.type.find("User Equipment") != std::string::npos)
-            anim.UpdateNodeColor(n, 255, 165, 0);      // orange
-        else if (cfg.type.find("Gateway") != std::string::npos)
-            anim.UpdateNodeColor(n, 0, 0, 255);        // blue
-        else
-            anim.UpdateNodeColor(n, 200, 200, 200);    // gray
-
-        std::cout << " - Added " << cfg.name << " (" << cfg.type
-                  << ") at (" << cfg.x << ", " << cfg.y << ", " << cfg.z << ")\n";
+        if (i < listed)
+            std::cout << " - Added " << cfg.name << " (" << cfg.type
+                      << ") at (" << cfg.x << ", " << cfg.y << ", " << cfg.z << ")\n";
     }
+    if (nodes.size() > listed)
+        std::cout << " - ... and " << nodes.size() - listed << " more nodes\n";
 
-    Simulator::Stop(Seconds(0.1));
-    Simulator::Run();
-    Simulator::Destroy();
+    if (!anim.close()) {
+        std::cerr << "[ERROR] Writing " << outputPath << " failed." << std::endl;
+        return;
+    }
 
-    std::cout << "[INFO] Node map written to " << outputPath << std::endl;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "[INFO] Node map written to " << outputPath << " (" << nodes.size() << " nodes, "
+              << ms << " ms)" << std::endl;
     std::cout << "      Open this file in NetAnim to visualize layout.\n";
 }
@@ -5,32 +5,100 @@
 #include "ns3/wifi-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/applications-module.h"
+#include <deque>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include "LDT_shared.h"
+#include "cachingPropagationLoss.h"
+#include "terrainPropagationLoss.h"
+#include "phyAbstraction.h"
+#include "profiler.h"
+#include "binaryTrace.h"
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("LunarCommExample");
 
-void simulateTransmission(double distance, double freqMHz, double txPowerdBm, std::string rate)
+// Echo round trips observed through the UdpEchoClient trace sources;
+// traceId names the link in the binary trace (0 = unnamed)
+struct EchoStats {
+  std::deque<Time> pending;
+  double rttSumMs{};
+  LinkResult result;
+  uint32_t traceId{};
+};
+
+static void OnEchoTx(EchoStats* stats, Ptr<const Packet> packet)
 {
-  bool verbose = true;
-  double freqGHz = freqMHz / 1000.0; // MHz → GHz
+  stats->result.packetsSent++;
+  stats->pending.push_back(Simulator::Now());
+  TraceEchoTx(stats->traceId, Simulator::Now().GetNanoSeconds(), packet->GetSize());
+}
 
-  LogComponentEnable("LunarCommExample", LOG_LEVEL_INFO);
+static void OnEchoRx(EchoStats* stats, Ptr<const Packet> packet)
+{
+  stats->result.packetsReceived++;
+  if (!stats->pending.empty()) {
+    double rttMs = (Simulator::Now() - stats->pending.front()).GetSeconds() * 1e3;
+    stats->rttSumMs += rttMs;
+    stats->pending.pop_front();
+    TraceEchoRx(stats->traceId, Simulator::Now().GetNanoSeconds(), packet->GetSize(), rttMs);
+  }
+}
+
+static LinkResult finishEchoStats(EchoStats& stats)
+{
+  if (stats.result.packetsReceived > 0)
+    stats.result.meanRttMs = stats.rttSumMs / stats.result.packetsReceived;
+  TraceLinkResult(stats.traceId, false, stats.result.packetsSent, stats.result.packetsReceived,
+                  stats.result.meanRttMs);
+  return stats.result;
+}
 
-  if (verbose) {
-    LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
+// Names the link that the following link runs trace (echo and result
+// records) and records its parameters; returns its trace id, 0 when the
+// link and echo categories are both off
+uint32_t traceLinkStart(const LinkJob& link)
+{
+  if (!TraceEnabled(kTraceLink | kTraceEcho)) {
+    TraceSetLink(0);
+    return 0;
   }
+  uint32_t id = TraceIntern(link.txName + " -> " + link.rxName);
+  TraceSetLink(id);
+  TraceLinkStart(id, TraceIntern(link.rate), link.distance, link.freqMHz, link.txPowerdBm);
+  return id;
+}
 
-  NodeContainer nodes;
-  nodes.Create(2);
-  Ptr<Node> txNode = nodes.Get(0);
-  Ptr<Node> rxNode = nodes.Get(1);
+static GlobalValue g_verboseLinkLog("LdtVerboseLog",
+                                    "NS_LOG INFO output of the echo applications, one console line per "
+                                    "packet (the binary trace's echo category records the same events)",
+                                    BooleanValue(false),
+                                    MakeBooleanChecker());
 
-  SetNodePosition(txNode, Vector(0.0, 0.0, 0.0));
-  SetNodePosition(rxNode, Vector(distance, 0.0, 0.0));
+static void enableLinkLogging()
+{
+  BooleanValue verbose;
+  g_verboseLinkLog.GetValue(verbose);
+  if (!verbose.Get())
+    return;
+
+  LogComponentEnable("LunarCommExample", LOG_LEVEL_INFO);
+  LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
+  LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
+}
+
+// Install one lunar radio link between two nodes that already carry an
+// Internet stack: a dedicated 802.11a channel at the tx frequency, a device
+// pair, a fresh subnet from ipv4 and a UdpEcho flow from tx to rx. With a
+// terrain file the channel also pays the terrain's diffraction loss, which
+// only makes sense when the nodes sit at their scenario positions.
+static void installLunarLink(Ptr<Node> txNode, Ptr<Node> rxNode, double freqMHz, double txPowerdBm,
+                             Ipv4AddressHelper& ipv4, uint16_t port, EchoStats* stats,
+                             const std::string& terrainFile = std::string())
+{
+  double freqGHz = freqMHz / 1000.0; // MHz → GHz
 
   WifiHelper wifi;
   wifi.SetStandard(WIFI_STANDARD_80211a);
@@ -41,44 +109,166 @@ void simulateTransmission(double distance, double freqMHz, double txPowerdBm, st
   channel.AddPropagationLoss("ns3::FriisPropagationLossModel",
                              "Frequency", DoubleValue(freqGHz * 1e9));
   channel.AddPropagationLoss("ns3::FixedRssLossModel",
-                             "Rss", DoubleValue(-3.0));
+                             "Rss", DoubleValue(kLinkFixedRssDbm));
   channel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
-  phy.SetChannel(channel.Create());
+  Ptr<YansWifiChannel> wifiChannel = channel.Create();
+  if (!terrainFile.empty() || PathLossCachingEnabled()) {
+    PointerValue loss;
+    wifiChannel->GetAttribute("PropagationLossModel", loss);
+    Ptr<PropagationLossModel> model = loss.Get<PropagationLossModel>();
+    if (!terrainFile.empty()) model = MakeTerrainLossModel(model, terrainFile, freqGHz * 1e9);
+    if (PathLossCachingEnabled()) model = MakeCachingLossModel(model);
+    wifiChannel->SetPropagationLossModel(model);
+  }
+  phy.SetChannel(wifiChannel);
 
-  phy.Set("RxNoiseFigure", DoubleValue(8.0));
+  phy.Set("RxNoiseFigure", DoubleValue(kLinkNoiseFigureDb));
   phy.Set("TxPowerStart", DoubleValue(txPowerdBm));
   phy.Set("TxPowerEnd", DoubleValue(txPowerdBm));
 
+  // The receiver is the access point; the transmitter associates from its
+  // beacons before the echo traffic starts (a STA MAC drops every frame,
+  // ARP included, while it is not associated)
   WifiMacHelper mac;
   Ssid ssid = Ssid("lunar-link");
   mac.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid), "ActiveProbing", BooleanValue(false));
+  NetDeviceContainer devices = wifi.Install(phy, mac, txNode);
+  mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+  devices.Add(wifi.Install(phy, mac, rxNode));
+
+  Ipv4InterfaceContainer interfaces = ipv4.Assign(devices);
+  ipv4.NewNetwork();
 
-  NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+  UdpEchoServerHelper echoServer(port);
+  ApplicationContainer serverApps = echoServer.Install(rxNode);
+  serverApps.Start(Seconds(1.0));
+  serverApps.Stop(Seconds(kEchoTraffic.stopS));
+
+  UdpEchoClientHelper echoClient(interfaces.GetAddress(1), port);
+  echoClient.SetAttribute("MaxPackets", UintegerValue(kEchoTraffic.packets));
+  echoClient.SetAttribute("Interval", TimeValue(Seconds(kEchoTraffic.intervalS)));
+  echoClient.SetAttribute("PacketSize", UintegerValue(kEchoTraffic.payloadBytes));
+  ApplicationContainer clientApps = echoClient.Install(txNode);
+  clientApps.Start(Seconds(kEchoTraffic.startS));
+  clientApps.Stop(Seconds(kEchoTraffic.stopS));
+
+  clientApps.Get(0)->TraceConnectWithoutContext("Tx", MakeBoundCallback(&OnEchoTx, stats));
+  clientApps.Get(0)->TraceConnectWithoutContext("Rx", MakeBoundCallback(&OnEchoRx, stats));
+}
+
+LinkResult simulateTransmission(double distance, double freqMHz, double txPowerdBm, std::string rate)
+{
+  ScopedPhase phase("simulate_transmission");
+  enableLinkLogging();
+  std::optional<ScopedPhase> build(std::in_place, "build");
+
+  NodeContainer nodes;
+  nodes.Create(2);
+  Ptr<Node> txNode = nodes.Get(0);
+  Ptr<Node> rxNode = nodes.Get(1);
+
+  SetNodePosition(txNode, Vector(0.0, 0.0, 0.0));
+  SetNodePosition(rxNode, Vector(distance, 0.0, 0.0));
 
   InternetStackHelper internet;
   internet.Install(nodes);
 
   Ipv4AddressHelper ipv4;
   ipv4.SetBase("10.1.1.0", "255.255.255.0");
-  Ipv4InterfaceContainer interfaces = ipv4.Assign(devices);
-
-  uint16_t port = 4000;
-  UdpEchoServerHelper echoServer(port);
-  ApplicationContainer serverApps = echoServer.Install(nodes.Get(1));
-  serverApps.Start(Seconds(1.0));
-  serverApps.Stop(Seconds(10.0));
 
-  UdpEchoClientHelper echoClient(interfaces.GetAddress(1), port);
-  echoClient.SetAttribute("MaxPackets", UintegerValue(5));
-  echoClient.SetAttribute("Interval", TimeValue(Seconds(1.0)));
-  echoClient.SetAttribute("PacketSize", UintegerValue(512));
-  ApplicationContainer clientApps = echoClient.Install(nodes.Get(0));
-  clientApps.Start(Seconds(2.0));
-  clientApps.Stop(Seconds(10.0));
+  EchoStats stats;
+  stats.traceId = TraceCurrentLink();
+  installLunarLink(txNode, rxNode, freqMHz, txPowerdBm, ipv4, 4000, &stats);
+  build.reset();
 
   Simulator::Stop(Seconds(11.0));
-  Simulator::Run();
-  Simulator::Destroy();
+  {
+    ScopedPhase run("run", true);
+    Simulator::Run();
+  }
+  {
+    ScopedPhase destroy("destroy");
+    Simulator::Destroy();
+  }
 
   NS_LOG_INFO("Lunar communication simulation complete!");
+
+  return finishEchoStats(stats);
+}
+
+// ---------------------------------------------------------------------
+// simulateScenario()
+// Builds the whole configured topology once (one ns-3 node per
+// NodeConfig, one channel + device pair + echo flow per link) and runs
+// it in a single simulation. Results are returned in link order.
+// Nodes keep their configured positions, so the LdtTerrain descriptor,
+// if set, shadows the links that cross crater rims.
+// ---------------------------------------------------------------------
+std::vector<LinkResult> simulateScenario(const std::vector<NodeConfig>& configs,
+                                         const std::vector<LinkJob>& links)
+{
+  ScopedPhase phase("simulate_scenario");
+  enableLinkLogging();
+  std::optional<ScopedPhase> build(std::in_place, "build");
+
+  std::unordered_map<std::string, uint32_t> indexOf;
+  indexOf.reserve(configs.size());
+  for (uint32_t i = 0; i < configs.size(); ++i)
+    indexOf.emplace(configs[i].name, i);
+
+  NodeContainer nodes;
+  nodes.Create(configs.size());
+  for (uint32_t i = 0; i < configs.size(); ++i)
+    SetNodePosition(nodes.Get(i), Vector(configs[i].x, configs[i].y, configs[i].z));
+
+  InternetStackHelper internet;
+  internet.Install(nodes);
+
+  std::string terrainFile = TerrainFileSetting();
+  if (!terrainFile.empty())
+    std::cout << "[INFO] Terrain diffraction from " << terrainFile << std::endl;
+
+  // One /30 per link: each link is its own two-host network
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.252");
+
+  std::vector<EchoStats> stats(links.size());
+  std::vector<uint16_t> nextPort(configs.size(), 4000);
+  if (TraceEnabled(kTraceLink | kTraceEcho))
+    for (size_t i = 0; i < links.size(); ++i)
+      stats[i].traceId = TraceIntern(links[i].txName + " -> " + links[i].rxName);
+
+  for (size_t i = 0; i < links.size(); ++i) {
+    auto tx = indexOf.find(links[i].txName);
+    auto rx = indexOf.find(links[i].rxName);
+    if (tx == indexOf.end() || rx == indexOf.end()) {
+      std::cerr << "[WARNING] Link " << links[i].txName << " → " << links[i].rxName
+                << " references an unknown node, skipped.\n";
+      continue;
+    }
+    // Every echo server on a receiving node needs its own port
+    uint16_t port = nextPort[rx->second]++;
+    installLunarLink(nodes.Get(tx->second), nodes.Get(rx->second),
+                     links[i].freqMHz, links[i].txPowerdBm, ipv4, port, &stats[i], terrainFile);
+  }
+  build.reset();
+  CountProfileEvent("scenario_links", links.size());
+
+  Simulator::Stop(Seconds(11.0));
+  {
+    ScopedPhase run("run", true);
+    Simulator::Run();
+  }
+  {
+    ScopedPhase destroy("destroy");
+    Simulator::Destroy();
+  }
+
+  NS_LOG_INFO("Lunar scenario simulation complete!");
+
+  std::vector<LinkResult> results;
+  results.reserve(links.size());
+  for (auto& s : stats)
+    results.push_back(finishEchoStats(s));
+  return results;
 }
@@ -25,6 +25,15 @@
 #include <algorithm>
 #include <iostream>
 #include <filesystem>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include "kdTree.h"
+#include "scenarioParser.h"
+#include "cachingPropagationLoss.h"
+#include "terrainPropagationLoss.h"
+#include "profiler.h"
+#include "binaryTrace.h"
 
 using namespace ns3;
 namespace fs = std::filesystem;
@@ -91,35 +100,256 @@ static double Fspl1m_dB(double fGHz)
   return 32.44 + 20.0 * std::log10(fGHz); // FSPL(1m)
 }
 
-static Ptr<NetDevice> PickNearestEnb(Ptr<Node> ueNode, const NetDeviceContainer& enbDevs)
+// --------------------------- UE Association ---------------------------------
+enum class AttachMode
 {
-  Ptr<MobilityModel> mmUe = ueNode->GetObject<MobilityModel>();
-  Vector uePos = mmUe->GetPosition();
-  double bestDist2 = std::numeric_limits<double>::infinity();
-  Ptr<NetDevice> bestEnb = nullptr;
-
-  for (uint32_t i = 0; i < enbDevs.GetN(); ++i)
-  {
-    Ptr<Node> enbNode = enbDevs.Get(i)->GetNode();
-    Ptr<MobilityModel> mmEnb = enbNode->GetObject<MobilityModel>();
-    Vector enbPos = mmEnb->GetPosition();
-    double dx = uePos.x - enbPos.x;
-    double dy = uePos.y - enbPos.y;
-    double dz = uePos.z - enbPos.z;
-    double d2 = dx * dx + dy * dy + dz * dz;
-    if (d2 < bestDist2)
+  Nearest,   // closest eNB
+  BestPower  // strongest CI received power among the attachK closest eNBs
+};
+
+// Pick the serving eNB (index into enbDevs) for every UE. The eNB positions
+// are indexed once in a k-d tree, so each UE costs O(log eNB) instead of a
+// scan over all cells. With terrain, the candidates of every UE are profiled
+// in one threaded batch and their diffraction loss joins the comparison.
+static std::vector<uint32_t> AssociateUes(const NetDeviceContainer& ueDevs, const NetDeviceContainer& enbDevs,
+                                          AttachMode mode, uint32_t attachK,
+                                          double refLoss, double n, double gEnb, double gUe,
+                                          const TerrainMap* terrain = nullptr, double wavelengthM = 0.0)
+{
+  uint32_t numEnb = enbDevs.GetN();
+  std::vector<double> xs(numEnb), ys(numEnb), zs(numEnb), txPower(numEnb, 0.0);
+  for (uint32_t i = 0; i < numEnb; ++i)
+  {
+    Vector p = enbDevs.Get(i)->GetNode()->GetObject<MobilityModel>()->GetPosition();
+    xs[i] = p.x;
+    ys[i] = p.y;
+    zs[i] = p.z;
+    Ptr<LteEnbNetDevice> enb = DynamicCast<LteEnbNetDevice>(enbDevs.Get(i));
+    if (enb && enb->GetPhy())
+      txPower[i] = enb->GetPhy()->GetTxPower();
+  }
+  KdTree tree;
+  tree.build(xs, ys, zs);
+
+  uint32_t k = mode == AttachMode::Nearest ? 1 : std::max<uint32_t>(attachK, 1);
+  std::vector<uint32_t> serving(ueDevs.GetN(), 0);
+  std::vector<KdNeighbor> candidates;
+  // Candidates of every UE, and their terrain queries, when terrain is on
+  bool useTerrain = terrain && mode == AttachMode::BestPower;
+  std::vector<std::vector<KdNeighbor>> shortlist(useTerrain ? ueDevs.GetN() : 0);
+  std::vector<TerrainQuery> queries;
+  for (uint32_t u = 0; u < ueDevs.GetN(); ++u)
+  {
+    Vector p = ueDevs.Get(u)->GetNode()->GetObject<MobilityModel>()->GetPosition();
+    tree.nearest(p.x, p.y, p.z, k, candidates);
+    if (candidates.empty())
+      continue;
+    serving[u] = candidates[0].index;
+    if (mode == AttachMode::Nearest)
+      continue;
+    if (useTerrain)
+    {
+      for (const KdNeighbor& c : candidates)
+        queries.push_back({{xs[c.index], ys[c.index], zs[c.index]}, {p.x, p.y, p.z}, wavelengthM});
+      shortlist[u] = candidates;
+      continue;
+    }
+
+    // CI model: PL(d) = FSPL(1m) + 10 n log10(d), as configured on the channel
+    double bestRx = -std::numeric_limits<double>::infinity();
+    for (const KdNeighbor& c : candidates)
+    {
+      double d = std::max(std::sqrt(c.dist2), 1.0);
+      double rx = txPower[c.index] + gEnb + gUe - (refLoss + 10.0 * n * std::log10(d));
+      if (rx > bestRx)
+      {
+        bestRx = rx;
+        serving[u] = c.index;
+      }
+    }
+  }
+  if (!useTerrain)
+    return serving;
+
+  std::vector<TerrainProfile> profiles;
+  TerrainProfileBatch(*terrain, queries, profiles);
+  size_t q = 0;
+  for (uint32_t u = 0; u < shortlist.size(); ++u)
+  {
+    double bestRx = -std::numeric_limits<double>::infinity();
+    for (const KdNeighbor& c : shortlist[u])
+    {
+      double d = std::max(std::sqrt(c.dist2), 1.0);
+      double rx = txPower[c.index] + gEnb + gUe - (refLoss + 10.0 * n * std::log10(d))
+                  - profiles[q++].diffractionLossDb;
+      if (rx > bestRx)
+      {
+        bestRx = rx;
+        serving[u] = c.index;
+      }
+    }
+  }
+  return serving;
+}
+
+// --------------------------- Topology -----------------------------------------
+struct CiTopology
+{
+  Vector earth;
+  Vector gateway;
+  std::vector<Vector> enbPos;
+  std::vector<Vector> uePos;
+  std::vector<std::string> enbNames;
+  std::vector<std::string> ueNames;
+};
+
+// Original demo layout: two gNBs and three UEs next to the gateway
+static void DefaultCiTopology(double L, CiTopology& topo)
+{
+  topo.earth = Vector(0.0, 0.0, 0.0);
+  topo.gateway = Vector(L, 0.0, 0.0);
+  topo.enbPos = {Vector(L + 40.0, 10.0, 0.0), Vector(L + 180.0, -5.0, 0.0)};
+  topo.uePos = {Vector(L + 60.0, 25.0, 0.0), Vector(L + 200.0, -20.0, 0.0), Vector(L + 220.0, 15.0, 0.0)};
+}
+
+// numEnb cells laid out as a square grid, hex grid or uniformly at random,
+// starting 40 m past the gateway; numUe UEs dropped uniformly over the
+// covered area (extended by half a cell spacing on each side)
+static void GenerateCiTopology(double L, uint32_t numEnb, uint32_t numUe, const std::string& layout,
+                               double spacing, CiTopology& topo)
+{
+  topo.earth = Vector(0.0, 0.0, 0.0);
+  topo.gateway = Vector(L, 0.0, 0.0);
+  uint32_t cols = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(numEnb)))));
+  uint32_t rows = (numEnb + cols - 1) / std::max<uint32_t>(cols, 1);
+  double x0 = L + 40.0;
+  double width = (cols - 1) * spacing;
+  double height = (rows > 0 ? rows - 1 : 0) * spacing * (layout == "hex" ? std::sqrt(3.0) / 2.0 : 1.0);
+  double y0 = -height / 2.0;
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+  topo.enbPos.reserve(numEnb);
+  for (uint32_t i = 0; i < numEnb; ++i)
+  {
+    uint32_t r = i / cols;
+    uint32_t c = i % cols;
+    if (layout == "random")
+      topo.enbPos.push_back(Vector(rng->GetValue(x0, x0 + width), rng->GetValue(y0, y0 + height), 0.0));
+    else if (layout == "hex")
+      topo.enbPos.push_back(Vector(x0 + c * spacing + (r % 2 ? spacing / 2.0 : 0.0),
+                                   y0 + r * spacing * std::sqrt(3.0) / 2.0, 0.0));
+    else
+      topo.enbPos.push_back(Vector(x0 + c * spacing, y0 + r * spacing, 0.0));
+  }
+
+  double margin = spacing / 2.0;
+  topo.uePos.reserve(numUe);
+  for (uint32_t i = 0; i < numUe; ++i)
+    topo.uePos.push_back(Vector(rng->GetValue(x0 - margin, x0 + width + margin),
+                                rng->GetValue(y0 - margin, y0 + height + margin), 0.0));
+}
+
+// Take cells, UEs, the gateway and Earth from a NODECONFIGHEADER scenario,
+// classified by their Type (eNB/gNB, UE/Rover, Gateway/GW, Earth)
+static bool LoadCiTopology(const std::string& path, CiTopology& topo)
+{
+  Scenario scenario;
+  if (!LoadScenario(path, scenario))
+    return false;
+
+  size_t ignored = 0;
+  for (const NodeConfig& c : scenario.nodes)
+  {
+    std::string type = c.type;
+    std::transform(type.begin(), type.end(), type.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    Vector pos(c.x, c.y, c.z);
+    if (type.find("enb") != std::string::npos || type.find("gnb") != std::string::npos)
+    {
+      topo.enbPos.push_back(pos);
+      topo.enbNames.push_back(c.name);
+    }
+    else if (type == "ue" || type.find("rover") != std::string::npos || type.find("user") != std::string::npos)
     {
-      bestDist2 = d2;
-      bestEnb = enbDevs.Get(i);
+      topo.uePos.push_back(pos);
+      topo.ueNames.push_back(c.name);
     }
+    else if (type.find("gateway") != std::string::npos || type == "gw")
+      topo.gateway = pos;
+    else if (type.find("earth") != std::string::npos)
+      topo.earth = pos;
+    else
+      ++ignored;
+  }
+  if (ignored > 0)
+    std::cout << "[WARNING] " << ignored << " scenario nodes with other types ignored." << std::endl;
+  if (topo.enbPos.empty())
+  {
+    std::cerr << "[ERROR] Scenario " << path << " defines no eNB/gNB nodes." << std::endl;
+    return false;
   }
-  return bestEnb;
+  return true;
+}
+
+// Give every node in the container a constant position in one helper call
+static void InstallPositions(const NodeContainer& nodes, const std::vector<Vector>& positions)
+{
+  Ptr<ListPositionAllocator> alloc = CreateObject<ListPositionAllocator>();
+  for (const Vector& p : positions)
+    alloc->Add(p);
+  MobilityHelper mh;
+  mh.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+  mh.SetPositionAllocator(alloc);
+  mh.Install(nodes);
+}
+
+// Last RSRP/SINR report of one UE, converted to dBm / dB
+struct UeReport
+{
+  double rsrpDbm = 0.0;
+  double sinrDb = 0.0;
+  bool seen = false;
+  uint32_t ue = 0;
+};
+
+static void RecordUeReport(UeReport* report, uint16_t cellId, uint16_t /*rnti*/, double rsrp, double sinr,
+                           uint8_t /*ccId*/)
+{
+  report->rsrpDbm = 10.0 * std::log10(rsrp) + 30.0;
+  report->sinrDb = 10.0 * std::log10(sinr);
+  report->seen = true;
+  TraceUeReport(report->ue, Simulator::Now().GetNanoSeconds(), cellId, report->rsrpDbm, report->sinrDb);
+}
+
+// Aggregate the per-UE reports into the run's KPIs
+static void SummarizeUeReports(const std::vector<UeReport>& reports, CiResult& result)
+{
+  std::vector<double> sinr;
+  double rsrpSum = 0.0;
+  for (const UeReport& r : reports)
+  {
+    if (!r.seen)
+      continue;
+    rsrpSum += r.rsrpDbm;
+    sinr.push_back(r.sinrDb);
+  }
+  result.ueReports = static_cast<uint32_t>(sinr.size());
+  if (sinr.empty())
+    return;
+  std::sort(sinr.begin(), sinr.end());
+  result.meanRsrpDbm = rsrpSum / sinr.size();
+  double sinrSum = 0.0;
+  for (double v : sinr)
+    sinrSum += v;
+  result.meanSinrDb = sinrSum / sinr.size();
+  result.p5SinrDb = sinr[static_cast<size_t>(0.05 * (sinr.size() - 1))];
+  result.minSinrDb = sinr.front();
 }
 
 // ----------------------------------------------------------------------------
-// Callable entry point for LDT_main.cc
+// Callable entry point for LDT_main.cc. Command-line values override the
+// config file; result, if given, receives the run's KPIs.
 // ----------------------------------------------------------------------------
-int runLunarDtCI(int argc, char* argv[])
+int runLunarDtCI(int argc, char* argv[], CiResult* result = nullptr)
 {
   std::cout << "\n[INFO] === Starting Lunar CI LTE Simulation ===" << std::endl;
 
@@ -130,6 +360,15 @@ int runLunarDtCI(int argc, char* argv[])
   double gUe = 0.0;
   std::string animFile = "lunar_dt_min_ci.xml";
   std::string conf;
+  std::string attach = "nearest";
+  uint32_t attachK = 4;
+  uint32_t numEnb = 0;
+  uint32_t numUe = 0;
+  std::string layout = "grid";
+  double enbSpacing = 150.0;
+  std::string scenarioFile;
+  bool lossCache = false;
+  std::string terrainFile = TerrainFileSetting();
 
   // Default configuration file path
   std::string defaultConfPath = "../scratch/config/LTE_config/lunar_dt.conf";
@@ -142,6 +381,15 @@ int runLunarDtCI(int argc, char* argv[])
   cmd.AddValue("gUe", "UE isotropic antenna gain (dBi)", gUe);
   cmd.AddValue("animFile", "NetAnim output filename", animFile);
   cmd.AddValue("conf", "Path to config file", conf);
+  cmd.AddValue("attach", "UE association: nearest | power (best CI received power)", attach);
+  cmd.AddValue("attachK", "Candidate eNBs per UE in power association mode", attachK);
+  cmd.AddValue("numEnb", "Number of generated eNBs (0 = built-in demo layout)", numEnb);
+  cmd.AddValue("numUe", "Number of generated UEs", numUe);
+  cmd.AddValue("layout", "Generated eNB layout: grid | hex | random", layout);
+  cmd.AddValue("enbSpacing", "Distance between generated eNBs (m)", enbSpacing);
+  cmd.AddValue("scenario", "NODECONFIGHEADER scenario with eNB/UE/Gateway/Earth nodes", scenarioFile);
+  cmd.AddValue("lossCache", "Memoize CI path loss per eNB/UE pair", lossCache);
+  cmd.AddValue("terrain", "Terrain descriptor (*.dem) adding DEM diffraction loss (none = off)", terrainFile);
   cmd.Parse(argc, argv);
 
   // If no --conf provided, use default location
@@ -166,85 +414,210 @@ int runLunarDtCI(int argc, char* argv[])
     if (kv.count("gEnb")) gEnb = std::stod(kv["gEnb"]);
     if (kv.count("gUe")) gUe = std::stod(kv["gUe"]);
     if (kv.count("animFile")) animFile = kv["animFile"];
+    if (kv.count("attach")) attach = kv["attach"];
+    if (kv.count("attachK")) attachK = static_cast<uint32_t>(std::stoul(kv["attachK"]));
+    if (kv.count("numEnb")) numEnb = static_cast<uint32_t>(std::stoul(kv["numEnb"]));
+    if (kv.count("numUe")) numUe = static_cast<uint32_t>(std::stoul(kv["numUe"]));
+    if (kv.count("layout")) layout = kv["layout"];
+    if (kv.count("enbSpacing")) enbSpacing = std::stod(kv["enbSpacing"]);
+    if (kv.count("scenario")) scenarioFile = kv["scenario"];
+    if (kv.count("lossCache")) lossCache = kv["lossCache"] == "1" || kv["lossCache"] == "true" || kv["lossCache"] == "on";
+    if (kv.count("terrain")) terrainFile = kv["terrain"];
+    cmd.Parse(argc, argv); // explicit command-line values win over the file
+  }
+
+  // Build-phase timing report, also fed to the phase profiler
+  ScopedPhase ciPhase("lunar_dt_ci");
+  std::vector<std::pair<std::string, double>> phases;
+  auto runStart = std::chrono::steady_clock::now();
+  auto phaseStart = runStart;
+  double phaseCpuStart = ProfilingEnabled() ? ProcessCpuMs() : 0.0;
+  auto endPhase = [&](const std::string& name, uint64_t events = 0) {
+    auto now = std::chrono::steady_clock::now();
+    double wallMs = std::chrono::duration<double, std::milli>(now - phaseStart).count();
+    phases.emplace_back(name, wallMs);
+    phaseStart = now;
+    if (ProfilingEnabled())
+    {
+      double cpuNow = ProcessCpuMs();
+      RecordPhase(name, wallMs, cpuNow - phaseCpuStart, events);
+      phaseCpuStart = cpuNow;
+    }
+  };
+
+  CiTopology topo;
+  if (!scenarioFile.empty())
+  {
+    if (!LoadCiTopology(scenarioFile, topo))
+      return -1;
   }
+  else if (numEnb > 0)
+    GenerateCiTopology(L, numEnb, numUe, layout, enbSpacing, topo);
+  else
+    DefaultCiTopology(L, topo);
+  if (terrainFile == "none")
+    terrainFile.clear();
+  std::shared_ptr<const TerrainMap> terrain;
+  if (!terrainFile.empty())
+  {
+    terrain = LoadSharedTerrain(terrainFile);
+    if (!terrain)
+      return -1;
+  }
+  endPhase("topology");
 
   NodeContainer earth;     earth.Create(1);
   NodeContainer lunarGw;   lunarGw.Create(1);
-  NodeContainer gnbNodes;  gnbNodes.Create(2);
-  NodeContainer ueNodes;   ueNodes.Create(3);
-
-  Ptr<Node> nEarth = earth.Get(0);
-  Ptr<Node> nGw    = lunarGw.Get(0);
-  Ptr<Node> nGnb0  = gnbNodes.Get(0);
-  Ptr<Node> nGnb1  = gnbNodes.Get(1);
-  Ptr<Node> nUe0   = ueNodes.Get(0);
-  Ptr<Node> nUe1   = ueNodes.Get(1);
-  Ptr<Node> nUe2   = ueNodes.Get(2);
-
-  SetNodePosition(nEarth, Vector(0.0, 0.0, 0.0));
-  SetNodePosition(nGw,    Vector(L + 0.0, 0.0, 0.0));
-  SetNodePosition(nGnb0,  Vector(L + 40.0, 10.0, 0.0));
-  SetNodePosition(nGnb1,  Vector(L + 180.0, -5.0, 0.0));
-  SetNodePosition(nUe0,   Vector(L + 60.0, 25.0, 0.0));
-  SetNodePosition(nUe1,   Vector(L + 200.0, -20.0, 0.0));
-  SetNodePosition(nUe2,   Vector(L + 220.0, 15.0, 0.0));
+  NodeContainer gnbNodes;  gnbNodes.Create(topo.enbPos.size());
+  NodeContainer ueNodes;   ueNodes.Create(topo.uePos.size());
+  endPhase("create nodes");
+
+  InstallPositions(earth, {topo.earth});
+  InstallPositions(lunarGw, {topo.gateway});
+  InstallPositions(gnbNodes, topo.enbPos);
+  InstallPositions(ueNodes, topo.uePos);
+  endPhase("mobility");
 
   InternetStackHelper internet;
   internet.Install(ueNodes);
+  endPhase("internet stack");
 
   Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper>();
   Ptr<LteHelper> lteHelper = CreateObject<LteHelper>();
   lteHelper->SetEpcHelper(epcHelper);
 
   double refLoss = Fspl1m_dB(fGHz);
-  lteHelper->SetAttribute("PathlossModel", StringValue("ns3::LogDistancePropagationLossModel"));
+  // The terrain model wraps the CI model (and the cache, if on, wraps both).
+  // Its attributes are set on this run's models, not as defaults, so later
+  // runs in the same process do not inherit the terrain.
+  TypeIdValue ciModel(TypeId::LookupByName("ns3::LogDistancePropagationLossModel"));
+  if (lossCache)
+  {
+    // Static cells and UEs: evaluate the CI model once per pair
+    lteHelper->SetAttribute("PathlossModel", StringValue("ns3::CachingPropagationLossModel"));
+    if (terrain)
+    {
+      // Shared by the downlink and uplink caches; it holds no per-link state
+      Ptr<TerrainPropagationLossModel> terrainLoss = CreateObject<TerrainPropagationLossModel>();
+      terrainLoss->SetAttribute("InnerType", ciModel);
+      terrainLoss->SetAttribute("Frequency", DoubleValue(fGHz * 1e9));
+      terrainLoss->SetTerrain(terrain);
+      lteHelper->SetPathlossModelAttribute("Inner", PointerValue(terrainLoss));
+    }
+    else
+      lteHelper->SetPathlossModelAttribute("InnerType", ciModel);
+  }
+  else if (terrain)
+  {
+    lteHelper->SetAttribute("PathlossModel", StringValue("ns3::TerrainPropagationLossModel"));
+    lteHelper->SetPathlossModelAttribute("InnerType", ciModel);
+    lteHelper->SetPathlossModelAttribute("TerrainFile", StringValue(terrainFile));
+    lteHelper->SetPathlossModelAttribute("Frequency", DoubleValue(fGHz * 1e9));
+  }
+  else
+    lteHelper->SetAttribute("PathlossModel", StringValue("ns3::LogDistancePropagationLossModel"));
   Config::SetDefault("ns3::LogDistancePropagationLossModel::ReferenceDistance", DoubleValue(1.0));
   Config::SetDefault("ns3::LogDistancePropagationLossModel::ReferenceLoss", DoubleValue(refLoss));
   Config::SetDefault("ns3::LogDistancePropagationLossModel::Exponent", DoubleValue(n));
 
   Config::SetDefault("ns3::IsotropicAntennaModel::Gain", DoubleValue(gEnb));
   NetDeviceContainer enbDevs = lteHelper->InstallEnbDevice(gnbNodes);
+  endPhase("eNB devices");
   Config::SetDefault("ns3::IsotropicAntennaModel::Gain", DoubleValue(gUe));
   NetDeviceContainer ueDevs = lteHelper->InstallUeDevice(ueNodes);
+  endPhase("UE devices");
 
+  // AssociateUes() falls back to cell 0, which must exist
+  if (enbDevs.GetN() == 0 && ueDevs.GetN() > 0)
+  {
+    std::cerr << "[ERROR] No eNBs to attach the " << ueDevs.GetN() << " UEs to." << std::endl;
+    Simulator::Destroy();
+    return -1;
+  }
+  AttachMode attachMode = attach == "power" ? AttachMode::BestPower : AttachMode::Nearest;
+  std::vector<uint32_t> serving = AssociateUes(ueDevs, enbDevs, attachMode, attachK, refLoss, n, gEnb, gUe,
+                                                   terrain.get(), 0.299792458 / fGHz);
+  endPhase("association");
   for (uint32_t i = 0; i < ueDevs.GetN(); ++i)
   {
-    Ptr<NetDevice> ueDev = ueDevs.Get(i);
-    Ptr<Node> ueNode = ueDev->GetNode();
-    Ptr<NetDevice> bestEnbDev = PickNearestEnb(ueNode, enbDevs);
-    lteHelper->Attach(ueDev, bestEnbDev);
+    lteHelper->Attach(ueDevs.Get(i), enbDevs.Get(serving[i]));
   }
+  endPhase("attach");
+
+  std::vector<UeReport> ueReports(ueDevs.GetN());
+  for (uint32_t i = 0; i < ueDevs.GetN(); ++i)
+  {
+    ueReports[i].ue = i;
+    Ptr<LteUeNetDevice> ueDev = DynamicCast<LteUeNetDevice>(ueDevs.Get(i));
+    if (ueDev)
+      ueDev->GetPhy()->TraceConnectWithoutContext("ReportCurrentCellRsrpSinr",
+                                                  MakeBoundCallback(&RecordUeReport, &ueReports[i]));
+  }
+  std::cout << "[INFO] Associated " << ueDevs.GetN() << " UEs with " << enbDevs.GetN() << " eNBs ("
+            << (attachMode == AttachMode::BestPower ? "best power, k=" + std::to_string(attachK) : "nearest")
+            << ")" << std::endl;
 
   EnsureMobilityOnAllNodes(L);
 
-  AnimationInterface anim(animFile);
-  anim.SetMaxPktsPerTraceFile(1);
-
-  anim.UpdateNodeDescription(nEarth, "Earth");
-  anim.UpdateNodeDescription(nGw, "LunarGW");
-  anim.UpdateNodeDescription(nGnb0, "gNB0");
-  anim.UpdateNodeDescription(nGnb1, "gNB1");
-  anim.UpdateNodeDescription(nUe0, "UE0");
-  anim.UpdateNodeDescription(nUe1, "UE1");
-  anim.UpdateNodeDescription(nUe2, "UE2");
-
-  anim.UpdateNodeColor(nEarth, 255, 0, 0);
-  anim.UpdateNodeColor(nGw, 0, 0, 255);
-  anim.UpdateNodeColor(nGnb0, 0, 128, 0);
-  anim.UpdateNodeColor(nGnb1, 0, 128, 0);
-  anim.UpdateNodeColor(nUe0, 255, 165, 0);
-  anim.UpdateNodeColor(nUe1, 255, 165, 0);
-  anim.UpdateNodeColor(nUe2, 255, 165, 0);
+  // Large deployments can skip the NetAnim trace with animFile=none
+  std::unique_ptr<AnimationInterface> anim;
+  if (!animFile.empty() && animFile != "none")
+  {
+    anim = std::make_unique<AnimationInterface>(animFile);
+    anim->SetMaxPktsPerTraceFile(1);
+
+    anim->UpdateNodeDescription(earth.Get(0), "Earth");
+    anim->UpdateNodeDescription(lunarGw.Get(0), "LunarGW");
+    anim->UpdateNodeColor(earth.Get(0), 255, 0, 0);
+    anim->UpdateNodeColor(lunarGw.Get(0), 0, 0, 255);
+    for (uint32_t i = 0; i < gnbNodes.GetN(); ++i)
+    {
+      anim->UpdateNodeDescription(gnbNodes.Get(i), i < topo.enbNames.size() ? topo.enbNames[i] : "gNB" + std::to_string(i));
+      anim->UpdateNodeColor(gnbNodes.Get(i), 0, 128, 0);
+    }
+    for (uint32_t i = 0; i < ueNodes.GetN(); ++i)
+    {
+      anim->UpdateNodeDescription(ueNodes.Get(i), i < topo.ueNames.size() ? topo.ueNames[i] : "UE" + std::to_string(i));
+      anim->UpdateNodeColor(ueNodes.Get(i), 255, 165, 0);
+    }
+  }
+  endPhase("animation setup");
 
   Simulator::Stop(Seconds(2.0));
+  uint64_t eventsBefore = Simulator::GetEventCount();
   Simulator::Run();
+  endPhase("run", Simulator::GetEventCount() - eventsBefore);
+  anim.reset();
   Simulator::Destroy();
+  endPhase("teardown");
+
+  std::cout << "[TIMING] " << gnbNodes.GetN() << " eNBs, " << ueNodes.GetN() << " UEs\n";
+  double totalMs = 0.0;
+  std::streamsize precision = std::cout.precision();
+  for (const auto& phase : phases)
+  {
+    std::cout << "  " << std::left << std::setw(16) << phase.first << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10) << phase.second << " ms\n";
+    totalMs += phase.second;
+  }
+  std::cout << "  " << std::left << std::setw(16) << "total" << std::right
+            << std::setw(10) << totalMs << " ms" << std::defaultfloat << std::setprecision(precision) << std::endl;
 
   std::cout << "[INFO] CI LTE Simulation Complete.\n"
             << "  Config File: " << conf << "\n"
             << "  NetAnim File: " << animFile << "\n"
             << "  Path-Loss: FSPL(1m)=" << refLoss
-            << " dB, exponent n=" << n << ", f=" << fGHz << " GHz\n" << std::endl;
+            << " dB, exponent n=" << n << ", f=" << fGHz << " GHz"
+            << (lossCache ? " (cached per node pair)" : "")
+            << (terrain ? ", terrain " + terrainFile : std::string()) << "\n" << std::endl;
 
+  if (result)
+  {
+    *result = CiResult();
+    result->numEnb = gnbNodes.GetN();
+    result->numUe = ueNodes.GetN();
+    SummarizeUeReports(ueReports, *result);
+    result->wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+  }
   return 0;
 }
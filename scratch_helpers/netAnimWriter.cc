@@ -0,0 +1,113 @@
+#include "netAnimWriter.h"
+#include <charconv>
+#include <filesystem>
+
+NetAnimWriter::~NetAnimWriter()
+{
+    if (file_) close();
+}
+
+bool NetAnimWriter::open(const std::string& path)
+{
+    if (file_) close();
+    std::filesystem::path p(path);
+    std::error_code ec;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+    failed_ = false;
+    buffer_.clear();
+    buffer_.reserve(kBufferSize + 4096);
+    append("<anim ver=\"netanim-3.108\" filetype=\"animation\" >\n");
+    return true;
+}
+
+bool NetAnimWriter::close()
+{
+    if (!file_) return false;
+    append("</anim>\n");
+    flushBuffer();
+    if (std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+void NetAnimWriter::node(uint32_t id, double x, double y)
+{
+    append("<node id=\"");
+    appendNumber(id);
+    append("\" sysId=\"0\" locX=\"");
+    appendNumber(x);
+    append("\" locY=\"");
+    appendNumber(y);
+    append("\" />\n");
+}
+
+void NetAnimWriter::color(uint32_t id, uint8_t r, uint8_t g, uint8_t b)
+{
+    append("<nu p=\"c\" t=\"0\" id=\"");
+    appendNumber(id);
+    append("\" r=\"");
+    appendNumber(static_cast<uint32_t>(r));
+    append("\" g=\"");
+    appendNumber(static_cast<uint32_t>(g));
+    append("\" b=\"");
+    appendNumber(static_cast<uint32_t>(b));
+    append("\" />\n");
+}
+
+void NetAnimWriter::description(uint32_t id, std::string_view text)
+{
+    append("<nu p=\"d\" t=\"0\" id=\"");
+    appendNumber(id);
+    append("\" descr=\"");
+    appendEscaped(text);
+    append("\" />\n");
+}
+
+void NetAnimWriter::append(std::string_view s)
+{
+    buffer_.append(s.data(), s.size());
+    if (buffer_.size() >= kBufferSize) flushBuffer();
+}
+
+void NetAnimWriter::appendNumber(double v)
+{
+    char buf[32];
+    if (v == 0.0) v = 0.0;   // no "-0"
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    append(std::string_view(buf, r.ptr - buf));
+}
+
+void NetAnimWriter::appendNumber(uint32_t v)
+{
+    char buf[16];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    append(std::string_view(buf, r.ptr - buf));
+}
+
+void NetAnimWriter::appendEscaped(std::string_view s)
+{
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        const char* entity = nullptr;
+        switch (s[i]) {
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '"': entity = "&quot;"; break;
+            default: continue;
+        }
+        append(s.substr(start, i - start));
+        append(entity);
+        start = i + 1;
+    }
+    append(s.substr(start));
+}
+
+void NetAnimWriter::flushBuffer()
+{
+    if (file_ && !buffer_.empty() && std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size())
+        failed_ = true;
+    buffer_.clear();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Streaming writer for NetAnim animation XML (the subset AnimationInterface
+// emits for static nodes: <node>, colour and description updates at t=0).
+// Output is assembled in a memory buffer and written in large blocks, so a
+// map costs O(N) and needs no simulator.
+class NetAnimWriter {
+public:
+    NetAnimWriter() = default;
+    ~NetAnimWriter();
+    NetAnimWriter(const NetAnimWriter&) = delete;
+    NetAnimWriter& operator=(const NetAnimWriter&) = delete;
+
+    // Create path (and its directory) and write the <anim> header
+    bool open(const std::string& path);
+    // Write </anim> and close; false if any write failed
+    bool close();
+
+    void node(uint32_t id, double x, double y);
+    void color(uint32_t id, uint8_t r, uint8_t g, uint8_t b);
+    void description(uint32_t id, std::string_view text);
+
+private:
+    void append(std::string_view s);
+    void appendNumber(double v);
+    void appendNumber(uint32_t v);
+    void appendEscaped(std::string_view s);
+    void flushBuffer();
+
+    static const size_t kBufferSize = 1 << 20;
+
+    std::FILE* file_{};
+    std::string buffer_;
+    bool failed_{false};
+};
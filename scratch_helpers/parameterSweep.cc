@@ -0,0 +1,253 @@
+#include "parameterSweep.h"
+#include "scenarioCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+static std::string trimmed(const std::string& s)
+{
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// ---------------------------------------------------------------------
+// LoadSweepSpec()
+// ---------------------------------------------------------------------
+bool LoadSweepSpec(const std::string& path, SweepSpec& spec)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "[ERROR] Could not open " << path << std::endl;
+        return false;
+    }
+
+    spec = SweepSpec();
+    bool ok = true;
+    size_t lineNo = 0;
+    auto error = [&](const std::string& message) {
+        std::cerr << "[ERROR] " << path << ":" << lineNo << ": " << message << "\n";
+        ok = false;
+    };
+
+    std::string line;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        line = trimmed(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            error("expected 'key = value'");
+            continue;
+        }
+        std::string key = trimmed(line.substr(0, eq));
+        std::string value = trimmed(line.substr(eq + 1));
+
+        try {
+            if (key == "conf") {
+                spec.conf = value;
+            } else if (key == "output") {
+                spec.output = value;
+            } else if (key == "design") {
+                if (value == "grid") spec.design = SweepDesign::Grid;
+                else if (value == "lhs") spec.design = SweepDesign::LatinHypercube;
+                else if (value == "random") spec.design = SweepDesign::Random;
+                else error("design must be grid, lhs or random, got '" + value + "'");
+            } else if (key == "samples") {
+                spec.samples = static_cast<uint32_t>(std::stoul(value));
+            } else if (key == "seed") {
+                spec.seed = std::stoull(value);
+            } else if (key == "workers") {
+                spec.workers = static_cast<unsigned>(std::stoul(value));
+            } else {
+                SweepParameter p;
+                p.name = key;
+                std::istringstream fields(value);
+                if (!(fields >> p.lo >> p.hi) || p.hi < p.lo) {
+                    error("parameter '" + key + "' needs 'lo hi [levels]' with lo <= hi");
+                    continue;
+                }
+                if (!(fields >> p.levels)) p.levels = 2;
+                if (p.levels == 0) p.levels = 1;
+                spec.parameters.push_back(p);
+            }
+        } catch (const std::exception&) {
+            error("invalid number for '" + key + "': '" + value + "'");
+        }
+    }
+
+    if (spec.parameters.empty()) {
+        std::cerr << "[ERROR] " << path << ": no parameters to sweep.\n";
+        ok = false;
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// GenerateSweepPoints()
+// ---------------------------------------------------------------------
+std::vector<std::vector<double>> GenerateSweepPoints(const SweepSpec& spec)
+{
+    const size_t dims = spec.parameters.size();
+    std::vector<std::vector<double>> points;
+
+    // Explicit bit manipulation instead of std:: distributions, whose output
+    // differs between standard libraries
+    std::mt19937_64 rng(spec.seed);
+    auto uniform = [&]() { return static_cast<double>(rng() >> 11) * 0x1.0p-53; };
+    auto scale = [&](size_t j, double u) {
+        const SweepParameter& p = spec.parameters[j];
+        return p.lo + (p.hi - p.lo) * u;
+    };
+
+    if (spec.design == SweepDesign::Grid) {
+        size_t total = 1;
+        for (const SweepParameter& p : spec.parameters) total *= p.levels;
+        points.reserve(total);
+        std::vector<uint32_t> level(dims, 0);
+        for (size_t i = 0; i < total; ++i) {
+            std::vector<double> point(dims);
+            for (size_t j = 0; j < dims; ++j) {
+                uint32_t levels = spec.parameters[j].levels;
+                point[j] = scale(j, levels > 1 ? static_cast<double>(level[j]) / (levels - 1) : 0.0);
+            }
+            points.push_back(std::move(point));
+            // Odometer increment, last parameter fastest
+            for (size_t j = dims; j-- > 0;) {
+                if (++level[j] < spec.parameters[j].levels) break;
+                level[j] = 0;
+            }
+        }
+    } else if (spec.design == SweepDesign::LatinHypercube) {
+        // One sample in each of the n strata of every parameter, strata
+        // paired at random across parameters
+        const uint32_t n = spec.samples;
+        points.assign(n, std::vector<double>(dims));
+        std::vector<uint32_t> strata(n);
+        for (size_t j = 0; j < dims; ++j) {
+            for (uint32_t i = 0; i < n; ++i) strata[i] = i;
+            for (uint32_t i = n; i > 1; --i) std::swap(strata[i - 1], strata[rng() % i]);
+            for (uint32_t i = 0; i < n; ++i) points[i][j] = scale(j, (strata[i] + uniform()) / n);
+        }
+    } else {
+        points.assign(spec.samples, std::vector<double>(dims));
+        for (auto& point : points)
+            for (size_t j = 0; j < dims; ++j) point[j] = scale(j, uniform());
+    }
+
+    for (auto& point : points)
+        for (size_t j = 0; j < dims; ++j)
+            if (spec.parameters[j].integer) point[j] = std::round(point[j]);
+    return points;
+}
+
+std::string FormatSweepValue(double value)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+std::string SweepPointKey(const SweepSpec& spec, const std::vector<double>& point)
+{
+    std::string key;
+    for (size_t j = 0; j < spec.parameters.size(); ++j) {
+        if (j) key += ';';
+        key += spec.parameters[j].name + "=" + FormatSweepValue(point[j]);
+    }
+    return key;
+}
+
+// ---------------------------------------------------------------------
+// SweepTableIdentity()
+// ---------------------------------------------------------------------
+bool SweepTableIdentity(const SweepSpec& spec, std::string& identity)
+{
+    std::ifstream in(spec.conf, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "[ERROR] Could not read base configuration " << spec.conf << "\n";
+        return false;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(ScenarioContentHash(text.str())));
+
+    const char* design = spec.design == SweepDesign::Grid             ? "grid"
+                         : spec.design == SweepDesign::LatinHypercube ? "lhs"
+                                                                      : "random";
+    identity = std::string("# sweep conf_hash=") + hash + " design=" + design;
+    if (spec.design != SweepDesign::Grid) identity += " samples=" + std::to_string(spec.samples);
+    identity += " seed=" + std::to_string(spec.seed);
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// LoadCompletedSweepPoints()
+// ---------------------------------------------------------------------
+bool LoadCompletedSweepPoints(const std::string& path, const std::string& header,
+                              std::unordered_set<std::string>& done)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) return true;
+
+    // Every header line must match: the identity line, then the columns
+    std::istringstream expected(header);
+    std::string want, line, columnsLine;
+    bool first = true;
+    while (std::getline(expected, want)) {
+        if (!std::getline(in, line)) {
+            if (first) return true;
+            std::cerr << "[ERROR] " << path << " has an incomplete header.\n";
+            return false;
+        }
+        if (line != want) {
+            std::cerr << "[ERROR] " << path << " holds results of a different sweep ("
+                      << (first ? "base configuration, design or seed differ" : "columns differ")
+                      << "). Delete it or set another output.\n";
+            return false;
+        }
+        columnsLine = want;
+        first = false;
+    }
+    // A row cut short by an interrupted run is redone
+    const size_t columns = std::count(columnsLine.begin(), columnsLine.end(), ',');
+    while (std::getline(in, line)) {
+        if (in.eof() || static_cast<size_t>(std::count(line.begin(), line.end(), ',')) != columns) continue;
+        done.insert(line.substr(0, line.find(',')));
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// DropPartialSweepRow()
+// ---------------------------------------------------------------------
+bool DropPartialSweepRow(const std::string& path)
+{
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec || size == 0) return true;
+
+    // Rows are short; walk back to the last newline
+    uintmax_t keep = size;
+    {
+        std::ifstream in(path, std::ios::binary);
+        char c = 0;
+        while (keep > 0) {
+            in.seekg(static_cast<std::streamoff>(keep - 1));
+            if (!in.get(c)) return false;
+            if (c == '\n') break;
+            --keep;
+        }
+    }
+    if (keep == size) return true;
+    std::filesystem::resize_file(path, keep, ec);
+    return !ec;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// One swept parameter, sampled from [lo, hi]; levels is used by grid designs
+struct SweepParameter {
+    std::string name;
+    double lo{};
+    double hi{};
+    uint32_t levels{1};
+    bool integer{false};   // round sampled values (counts such as numEnb)
+};
+
+enum class SweepDesign { Grid, LatinHypercube, Random };
+
+// Contents of a .sweep file ('#' starts a comment):
+//   conf    = ./scratch/config/LTE_config/lunar_dt.conf   base configuration
+//   design  = grid | lhs | random
+//   samples = 2000          points of an lhs / random design
+//   seed    = 1
+//   workers = 0             worker processes (0 = all cores)
+//   output  = ./scratch/output/ci_sweep.csv
+//   n       = 2.0 3.5 16    any other key is a parameter: lo hi [levels]
+struct SweepSpec {
+    std::string conf;
+    SweepDesign design{SweepDesign::Grid};
+    uint32_t samples{100};
+    uint64_t seed{1};
+    unsigned workers{0};
+    std::string output;
+    std::vector<SweepParameter> parameters;
+};
+
+// Read a sweep specification; problems are reported as "file:line: message"
+bool LoadSweepSpec(const std::string& path, SweepSpec& spec);
+
+// The design's points, one value per parameter. Deterministic for a given
+// spec, so a restarted sweep regenerates exactly the same points.
+std::vector<std::vector<double>> GenerateSweepPoints(const SweepSpec& spec);
+
+// Value as passed on the command line and written to the results table
+std::string FormatSweepValue(double value);
+
+// Canonical "name=value;..." text of a point, its key in the results table
+std::string SweepPointKey(const SweepSpec& spec, const std::vector<double>& point);
+
+// "# sweep conf_hash=... design=... seed=..." line written above the
+// columns of a results table: the content hash of the base configuration
+// and the design settings, which decide a point's results besides its
+// swept values. False if spec.conf cannot be read.
+bool SweepTableIdentity(const SweepSpec& spec, std::string& identity);
+
+// Collect the keys (first column) of the rows already in a results table.
+// header holds the identity line and the column line. A missing file is an
+// empty table; a table whose header differs in any line is rejected, so
+// results of another sweep or base configuration are never mixed in.
+bool LoadCompletedSweepPoints(const std::string& path, const std::string& header,
+                              std::unordered_set<std::string>& done);
+
+// Truncate a results table after its last newline, removing a row cut
+// short by an interrupted run before new rows are appended
+bool DropPartialSweepRow(const std::string& path);
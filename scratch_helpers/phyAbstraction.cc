@@ -0,0 +1,364 @@
+// Table-driven link PHY. Uses the echo bookkeeping (EchoStats) of
+// lunarTransmissionSim.cc, which must be included first.
+#include "phyAbstraction.h"
+#include "linkResultCache.h"
+#include "profiler.h"
+#include "binaryTrace.h"
+#include "ns3/wifi-module.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// 802.11a MAC/PHY timing (20 MHz OFDM), microseconds
+static const double kSlotUs = 9.0;
+static const double kSifsUs = 16.0;
+static const double kDifsUs = kSifsUs + 2 * kSlotUs;
+static const double kPreambleUs = 20.0;   // L-STF + L-LTF + L-SIG
+static const double kSymbolUs = 4.0;
+static const uint32_t kCwMin = 15;
+static const uint32_t kCwMax = 1023;
+static const uint32_t kRetryLimit = 7;   // attempts per frame
+static const uint32_t kAckBytes = 14;
+static const uint32_t kArpFrameBytes = 28 + 8 + 24 + 4;   // ARP + LLC/SNAP + MAC header + FCS
+
+// Association with the receiver's AP (ns-3 ApWifiMac/StaWifiMac defaults)
+static const double kBeaconIntervalS = 0.1024;   // first beacon jittered within one interval
+static const double kScanWindowS = 0.12;         // passive scan (WaitBeaconTimeout)
+static const double kAssocTimeoutS = 0.5;        // AssocRequestTimeout before a retry
+static const uint32_t kAssocRequestBytes = 24 + 4 + 12 + 10 + 4;   // header, fixed fields, SSID, rates, FCS
+static const uint32_t kAssocResponseBytes = 24 + 6 + 10 + 4;
+
+// Echo frame on the air: payload + UDP + IPv4 + LLC/SNAP + MAC header + FCS
+static uint32_t echoFrameBytes()
+{
+    return kEchoTraffic.payloadBytes + 8 + 20 + 8 + 24 + 4;
+}
+
+// SERVICE field + PSDU + tail bits
+static uint64_t payloadBits(uint32_t bytes)
+{
+    return 16 + 8 * static_cast<uint64_t>(bytes) + 6;
+}
+
+static double frameUs(uint32_t bytes, double dataRateBps)
+{
+    double bitsPerSymbol = dataRateBps * kSymbolUs * 1e-6;
+    return kPreambleUs + kSymbolUs * std::ceil(payloadBits(bytes) / bitsPerSymbol);
+}
+
+double PhyTables::Per(size_t m, double snrDb) const
+{
+    const std::vector<float>& per = mcs[m].per;
+    double x = (snrDb - snrMinDb) / snrStepDb;
+    if (x <= 0.0) return per.front();
+    if (x >= points - 1) return per.back();
+    size_t i = static_cast<size_t>(x);
+    double f = x - i;
+    return per[i] * (1.0 - f) + per[i + 1] * f;
+}
+
+// A frame is lost if either its PHY header (L-SIG at 6 Mbps) or its
+// payload fails, as in the Yans PHY's reception decision
+void BuildPhyTables(PhyTables& tables)
+{
+    using namespace ns3;
+    ScopedPhase phase("phy_tables_build");
+    tables.simulatorId = SimulatorBuildId();
+    tables.frameBytes = echoFrameBytes();
+    tables.mcs.clear();
+
+    Ptr<ErrorRateModel> model = CreateObject<TableBasedErrorRateModel>();
+    const std::vector<WifiMode> modes = {
+        OfdmPhy::GetOfdmRate6Mbps(),  OfdmPhy::GetOfdmRate9Mbps(),  OfdmPhy::GetOfdmRate12Mbps(),
+        OfdmPhy::GetOfdmRate18Mbps(), OfdmPhy::GetOfdmRate24Mbps(), OfdmPhy::GetOfdmRate36Mbps(),
+        OfdmPhy::GetOfdmRate48Mbps(), OfdmPhy::GetOfdmRate54Mbps()};
+    WifiMode headerMode = OfdmPhy::GetOfdmRate6Mbps();
+    WifiTxVector headerVector;
+    headerVector.SetMode(headerMode);
+    headerVector.SetChannelWidth(20);
+
+    for (const WifiMode& mode : modes) {
+        WifiTxVector txVector;
+        txVector.SetMode(mode);
+        txVector.SetChannelWidth(20);
+        PhyMcsTable table;
+        table.mode = mode.GetUniqueName();
+        table.dataRateBps = static_cast<double>(mode.GetDataRate(txVector));
+        table.per.resize(tables.points);
+        for (uint32_t i = 0; i < tables.points; ++i) {
+            double snr = std::pow(10.0, (tables.snrMinDb + i * tables.snrStepDb) / 10.0);
+            double header = model->GetChunkSuccessRate(headerMode, headerVector, snr, 24, 1,
+                                                       WIFI_PPDU_FIELD_NON_HT_HEADER);
+            double payload = model->GetChunkSuccessRate(mode, txVector, snr, payloadBits(tables.frameBytes));
+            table.per[i] = static_cast<float>(1.0 - header * payload);
+        }
+        tables.mcs.push_back(std::move(table));
+    }
+}
+
+static const char kPhyTablesMagic[8] = {'L', 'D', 'T', 'P', 'H', 'Y', '0', '1'};
+
+template <typename T>
+static void writePod(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readPod(std::istream& in, T& value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+static void writeString(std::ostream& out, const std::string& s)
+{
+    writePod(out, static_cast<uint32_t>(s.size()));
+    out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+static bool readString(std::istream& in, std::string& s)
+{
+    uint32_t size;
+    if (!readPod(in, size) || size > 4096) return false;
+    s.resize(size);
+    return static_cast<bool>(in.read(s.data(), size));
+}
+
+bool SavePhyTables(const std::string& path, const PhyTables& tables)
+{
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "[ERROR] Could not write " << path << std::endl;
+            return false;
+        }
+        out.write(kPhyTablesMagic, sizeof(kPhyTablesMagic));
+        writePod(out, static_cast<uint32_t>(tables.mcs.size()));
+        writePod(out, tables.points);
+        writePod(out, tables.snrMinDb);
+        writePod(out, tables.snrStepDb);
+        writePod(out, tables.frameBytes);
+        writeString(out, tables.simulatorId);
+        for (const PhyMcsTable& m : tables.mcs) {
+            writeString(out, m.mode);
+            writePod(out, m.dataRateBps);
+            out.write(reinterpret_cast<const char*>(m.per.data()),
+                      static_cast<std::streamsize>(m.per.size() * sizeof(float)));
+        }
+        if (!out) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool LoadPhyTables(const std::string& path, PhyTables& tables)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kPhyTablesMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kPhyTablesMagic, sizeof(magic)) != 0)
+        return false;
+    uint32_t count;
+    PhyTables t;
+    if (!readPod(in, count) || !readPod(in, t.points) || !readPod(in, t.snrMinDb) ||
+        !readPod(in, t.snrStepDb) || !readPod(in, t.frameBytes) || !readString(in, t.simulatorId) ||
+        count == 0 || count > 64 || t.points < 2 || t.points > 100000)
+        return false;
+    t.mcs.resize(count);
+    for (PhyMcsTable& m : t.mcs) {
+        m.per.resize(t.points);
+        if (!readString(in, m.mode) || !readPod(in, m.dataRateBps) ||
+            !in.read(reinterpret_cast<char*>(m.per.data()), t.points * sizeof(float)))
+            return false;
+    }
+    tables = std::move(t);
+    return true;
+}
+
+void EnsurePhyTables(const std::string& path, PhyTables& tables)
+{
+    if (LoadPhyTables(path, tables) && tables.simulatorId == SimulatorBuildId() &&
+        tables.frameBytes == echoFrameBytes())
+        return;
+
+    std::cout << "[INFO] Sampling 802.11a PER tables from the ns-3 error-rate model..." << std::endl;
+    BuildPhyTables(tables);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    if (!SavePhyTables(path, tables)) {
+        std::cerr << "[WARNING] PHY tables could not be saved to " << path << std::endl;
+        return;
+    }
+    std::cout << "[INFO] PHY tables written to " << path << std::endl;
+}
+
+// ---------------------------------------------------------------------
+// SimulateTransmissionTable()
+// Replays the echo schedule frame by frame: every unicast frame takes
+// DIFS + random backoff + data + SIFS + ACK per attempt and is retried
+// with a doubled contention window until it gets through or the retry
+// limit is hit. Before any traffic the transmitter associates: it waits
+// for a beacon (basic rate, no retries), sends the association request at
+// the end of that scan window and retries every AssocRequestTimeout until
+// request and response get through; requests sent before then are dropped
+// by its MAC. The first echo is preceded by the ARP exchange. RTTs are
+// matched to the oldest outstanding request, as the UdpEchoClient traces
+// are in the detailed run.
+// ---------------------------------------------------------------------
+LinkResult SimulateTransmissionTable(const PhyTables& tables, double distance, double /* freqMHz */,
+                                     double /* txPowerdBm */, const std::string& /* rate */)
+{
+    // The detailed loss chain ends in FixedRssLossModel, which sets the
+    // received level outright, so only the delay depends on the distance
+    double rxDbm = kLinkFixedRssDbm;
+    double noiseDbm = -174.0 + 10.0 * std::log10(kLinkChannelWidthHz) + kLinkNoiseFigureDb;
+    double snrDb = rxDbm - noiseDbm;
+    bool audible = rxDbm >= kLinkRxSensitivityDbm;
+    double propagationUs = distance / 299792458.0 * 1e6;
+
+    // Best expected goodput stands in for the ideal rate manager
+    size_t best = 0;
+    double bestGoodput = -1.0;
+    for (size_t m = 0; m < tables.mcs.size(); ++m) {
+        double goodput = tables.mcs[m].dataRateBps * (1.0 - tables.Per(m, snrDb));
+        if (goodput > bestGoodput) {
+            bestGoodput = goodput;
+            best = m;
+        }
+    }
+    const double dataRate = tables.mcs[best].dataRateBps;
+    const double per = audible ? tables.Per(best, snrDb) : 1.0;
+    const double basicPer = audible ? tables.Per(0, snrDb) : 1.0;
+    // ACKs go at the highest mandatory rate (6/12/24 Mbps) not above the data rate
+    double ackRate = dataRate >= 24e6 ? 24e6 : dataRate >= 12e6 ? 12e6 : 6e6;
+    double ackUs = kSifsUs + frameUs(kAckBytes, ackRate) + propagationUs;
+
+    std::seed_seq seed{static_cast<uint64_t>(ns3::RngSeedManager::GetSeed()), ns3::RngSeedManager::GetRun()};
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Time to deliver one unicast frame, or a negative value if it is dropped
+    auto unicastUs = [&](uint32_t bytes, double rate, double framePer) {
+        double elapsed = 0.0;
+        uint32_t cw = kCwMin;
+        for (uint32_t attempt = 0; attempt < kRetryLimit; ++attempt) {
+            uint32_t slots = static_cast<uint32_t>(uniform(rng) * (cw + 1));
+            elapsed += kDifsUs + slots * kSlotUs + frameUs(bytes, rate) + propagationUs;
+            if (uniform(rng) >= framePer) return elapsed + ackUs;
+            elapsed += ackUs;   // ACK timeout
+            cw = std::min(2 * cw + 1, kCwMax);
+        }
+        return -1.0;
+    };
+
+    // Association: first beacon heard, then request/response pairs
+    double associatedS = -1.0;
+    double beaconS = uniform(rng) * kBeaconIntervalS;
+    while (beaconS < kEchoTraffic.stopS && uniform(rng) < basicPer) beaconS += kBeaconIntervalS;
+    double scanEndS = (std::floor(beaconS / kScanWindowS) + 1.0) * kScanWindowS;
+    for (double t = scanEndS; t < kEchoTraffic.stopS; t += kAssocTimeoutS) {
+        double request = unicastUs(kAssocRequestBytes, 6e6, basicPer);
+        double response = request < 0.0 ? -1.0 : unicastUs(kAssocResponseBytes, 6e6, basicPer);
+        if (response >= 0.0) {
+            associatedS = t + (request + response) * 1e-6;
+            break;
+        }
+    }
+
+    EchoStats stats;
+    stats.traceId = TraceCurrentLink();
+    bool arpResolved = false;
+    for (uint32_t k = 0; k < kEchoTraffic.packets; ++k) {
+        double sendS = kEchoTraffic.startS + k * kEchoTraffic.intervalS;
+        if (sendS >= kEchoTraffic.stopS) break;
+        stats.result.packetsSent++;
+        stats.pending.push_back(ns3::Seconds(sendS));
+        TraceEchoTx(stats.traceId, static_cast<int64_t>(sendS * 1e9), kEchoTraffic.payloadBytes);
+        if (associatedS < 0.0 || sendS < associatedS) continue;
+
+        double us = 0.0;
+        if (!arpResolved) {
+            // Broadcast request at the basic rate (no retries), unicast reply
+            us += kDifsUs + frameUs(kArpFrameBytes, 6e6) + propagationUs;
+            if (uniform(rng) < basicPer) continue;
+            double reply = unicastUs(kArpFrameBytes, dataRate, per);
+            if (reply < 0.0) continue;
+            us += reply;
+            arpResolved = true;
+        }
+        double request = unicastUs(echoFrameBytes(), dataRate, per);
+        if (request < 0.0) continue;
+        double response = unicastUs(echoFrameBytes(), dataRate, per);
+        if (response < 0.0) continue;
+        us += request + response;
+
+        double receiveS = sendS + us * 1e-6;
+        if (receiveS >= kEchoTraffic.stopS) continue;
+        stats.result.packetsReceived++;
+        double rttMs = (receiveS - stats.pending.front().GetSeconds()) * 1e3;
+        stats.rttSumMs += rttMs;
+        stats.pending.pop_front();
+        TraceEchoRx(stats.traceId, static_cast<int64_t>(receiveS * 1e9), kEchoTraffic.payloadBytes, rttMs);
+    }
+    CountProfileEvent("table_phy_links");
+    return finishEchoStats(stats);
+}
+
+void WritePhyValidationReport(const std::vector<PhyValidationRow>& rows, std::ostream& out,
+                              const std::string& csvPath)
+{
+    auto ratio = [](const LinkResult& r) {
+        return r.packetsSent > 0 ? double(r.packetsReceived) / r.packetsSent : 0.0;
+    };
+
+    double deliveryErr = 0.0, rttErr = 0.0, fullMs = 0.0, tableMs = 0.0;
+    size_t agree = 0;
+    out << "\n[RESULT] Table PHY vs full PHY\n"
+        << "  " << std::left << std::setw(28) << "link" << std::right << std::setw(12) << "full echo"
+        << std::setw(12) << "table echo" << std::setw(12) << "full RTT" << std::setw(12) << "table RTT" << '\n';
+    for (const PhyValidationRow& row : rows) {
+        double dr = std::fabs(ratio(row.full) - ratio(row.table));
+        double dt = std::fabs(row.full.meanRttMs - row.table.meanRttMs);
+        deliveryErr += dr;
+        rttErr += dt;
+        fullMs += row.fullMs;
+        tableMs += row.tableMs;
+        if (row.full.packetsReceived == row.table.packetsReceived) ++agree;
+        std::string name = row.link.txName + " -> " + row.link.rxName;
+        out << "  " << std::left << std::setw(28) << name << std::right
+            << std::setw(12) << (std::to_string(row.full.packetsReceived) + "/" + std::to_string(row.full.packetsSent))
+            << std::setw(12) << (std::to_string(row.table.packetsReceived) + "/" + std::to_string(row.table.packetsSent))
+            << std::setw(12) << row.full.meanRttMs << std::setw(12) << row.table.meanRttMs << '\n';
+    }
+    size_t n = std::max<size_t>(rows.size(), 1);
+    out << "  Links                    : " << rows.size() << " (" << agree << " with the same echo count)\n"
+        << "  Mean |delivery error|    : " << deliveryErr / n << '\n'
+        << "  Mean |RTT error|         : " << rttErr / n << " ms\n"
+        << "  Wall time full / table   : " << fullMs << " ms / " << tableMs << " ms";
+    if (tableMs > 0.0) {
+        std::streamsize precision = out.precision();
+        out << " (" << std::fixed << std::setprecision(1) << fullMs / tableMs << "x)" << std::defaultfloat
+            << std::setprecision(precision);
+    }
+    out << std::endl;
+
+    if (csvPath.empty()) return;
+    std::ofstream csv(csvPath);
+    if (!csv.is_open()) {
+        std::cerr << "[ERROR] Could not write " << csvPath << std::endl;
+        return;
+    }
+    csv << "tx,rx,distance_m,full_sent,full_received,full_rtt_ms,table_sent,table_received,table_rtt_ms,"
+           "full_ms,table_ms\n";
+    for (const PhyValidationRow& row : rows) {
+        csv << row.link.txName << ',' << row.link.rxName << ',' << row.link.distance << ','
+            << row.full.packetsSent << ',' << row.full.packetsReceived << ',' << row.full.meanRttMs << ','
+            << row.table.packetsSent << ',' << row.table.packetsReceived << ',' << row.table.meanRttMs << ','
+            << row.fullMs << ',' << row.tableMs << '\n';
+    }
+    out << "[INFO] Validation rows written to " << csvPath << std::endl;
+}
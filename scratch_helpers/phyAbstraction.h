@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "LDT_shared.h"
+
+// Echo traffic of one lunar link run (lunarTransmissionSim.cc); the table
+// PHY replays the same schedule
+struct EchoTrafficProfile {
+    uint32_t packets{5};
+    double startS{2.0};
+    double intervalS{1.0};
+    double stopS{10.0};
+    uint32_t payloadBytes{512};
+};
+static const EchoTrafficProfile kEchoTraffic;
+
+// Radio settings shared by the detailed link and its abstraction
+static const double kLinkFixedRssDbm = -3.0;     // FixedRssLossModel at the end of the loss chain
+static const double kLinkNoiseFigureDb = 8.0;    // RxNoiseFigure
+static const double kLinkRxSensitivityDbm = -101.0; // YansWifiPhy default
+static const double kLinkChannelWidthHz = 20e6;
+
+// SNR -> packet error rate of the echo data frame for every 802.11a rate,
+// sampled from the error-rate model the Yans PHY applies to each frame
+// (PHY header and payload chunks), so a lookup replaces the per-frame
+// interference bookkeeping of the detailed model.
+struct PhyMcsTable {
+    std::string mode;            // ns-3 unique name, e.g. OfdmRate54Mbps
+    double dataRateBps{};
+    std::vector<float> per;      // one entry per SNR grid point
+};
+
+struct PhyTables {
+    std::string simulatorId;     // ns-3 build the tables were sampled from
+    uint32_t frameBytes{};       // PSDU size of an echo frame
+    float snrMinDb{-5.0f};
+    float snrStepDb{0.25f};
+    uint32_t points{181};        // -5 .. 40 dB
+    std::vector<PhyMcsTable> mcs; // by increasing data rate
+
+    // Linear interpolation on the SNR grid, clamped at both ends
+    double Per(size_t mcs, double snrDb) const;
+};
+
+// Sample the tables from the ns-3 error-rate model
+void BuildPhyTables(PhyTables& tables);
+
+// Binary form: "LDTPHY01", counts, grid, simulator id, then per MCS its
+// name, data rate and float PER array
+bool SavePhyTables(const std::string& path, const PhyTables& tables);
+bool LoadPhyTables(const std::string& path, PhyTables& tables);
+
+static const char* const kPhyTablesPath = "./scratch/output/phy_tables_80211a.bin";
+
+// Load path if it matches this ns-3 build and frame size, else build the
+// tables and (best effort) rewrite it
+void EnsurePhyTables(const std::string& path, PhyTables& tables);
+
+// Table-driven stand-in for simulateTransmission(): same loss chain, noise,
+// echo schedule and RTT bookkeeping; the rate is the one with the best
+// expected goodput (standing in for the ideal rate manager), and each
+// frame is delivered or retried by drawing against its table PER. Draws
+// use the current RNG seed and run.
+LinkResult SimulateTransmissionTable(const PhyTables& tables, double distance, double freqMHz,
+                                     double txPowerdBm, const std::string& rate);
+
+// One link compared between the full and the table PHY
+struct PhyValidationRow {
+    LinkJob link;
+    LinkResult full;
+    LinkResult table;
+    double fullMs{};
+    double tableMs{};
+};
+
+// Summary table plus mean absolute delivery/RTT errors and the speed-up;
+// rows are also written to csvPath if it is not empty
+void WritePhyValidationReport(const std::vector<PhyValidationRow>& rows, std::ostream& out,
+                              const std::string& csvPath);
@@ -0,0 +1,211 @@
+#include "profiler.h"
+#include "ns3/core-module.h"
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <sys/resource.h>
+
+bool g_profilingEnabled = false;
+
+static ns3::GlobalValue g_profile("LdtProfile",
+                                  "Record per-phase wall/CPU time, events and peak RSS (see profiler.h)",
+                                  ns3::BooleanValue(false),
+                                  ns3::MakeBooleanChecker());
+
+struct PhaseStats {
+    std::string name;
+    uint64_t calls{};
+    double wallMs{};
+    double maxWallMs{};
+    double cpuMs{};
+    uint64_t events{};
+    long peakRssKb{};
+};
+
+// Phases and counters in first-seen order
+static std::vector<PhaseStats> g_phases;
+static std::unordered_map<std::string, size_t> g_phaseIndex;
+static std::vector<std::pair<std::string, uint64_t>> g_counters;
+static std::unordered_map<std::string, size_t> g_counterIndex;
+static std::vector<std::string> g_openPhases;   // full names, innermost last
+
+void SetProfilingEnabled(bool on)
+{
+    g_profilingEnabled = on;
+}
+
+bool ProfilingFromEnvironment()
+{
+    ns3::BooleanValue value;
+    g_profile.GetValue(value);
+    if (value.Get()) g_profilingEnabled = true;
+    return g_profilingEnabled;
+}
+
+double ProcessCpuMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static long processPeakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static PhaseStats& phaseStats(const std::string& name)
+{
+    auto [it, added] = g_phaseIndex.emplace(name, g_phases.size());
+    if (added) {
+        g_phases.emplace_back();
+        g_phases.back().name = name;
+    }
+    return g_phases[it->second];
+}
+
+static std::string nested(std::string_view name)
+{
+    if (g_openPhases.empty()) return std::string(name);
+    std::string full = g_openPhases.back();
+    full += '/';
+    full += name;
+    return full;
+}
+
+static void addSample(const std::string& name, uint64_t calls, double wallMs, double maxWallMs, double cpuMs,
+                      uint64_t events, long rssKb)
+{
+    PhaseStats& p = phaseStats(name);
+    p.calls += calls;
+    p.wallMs += wallMs;
+    p.maxWallMs = std::max(p.maxWallMs, maxWallMs);
+    p.cpuMs += cpuMs;
+    p.events += events;
+    p.peakRssKb = std::max(p.peakRssKb, rssKb);
+}
+
+void RecordPhase(std::string_view name, double wallMs, double cpuMs, uint64_t events)
+{
+    if (!g_profilingEnabled) return;
+    addSample(nested(name), 1, wallMs, wallMs, cpuMs, events, processPeakRssKb());
+}
+
+void CountProfileEvent(std::string_view counter, uint64_t delta)
+{
+    if (!g_profilingEnabled) return;
+    std::string name(counter);
+    auto [it, added] = g_counterIndex.emplace(name, g_counters.size());
+    if (added) g_counters.emplace_back(name, 0);
+    g_counters[it->second].second += delta;
+}
+
+void ResetProfile()
+{
+    g_phases.clear();
+    g_phaseIndex.clear();
+    g_counters.clear();
+    g_counterIndex.clear();
+    g_openPhases.clear();
+}
+
+// ---------------------------------------------------------------------
+// ScopedPhase
+// ---------------------------------------------------------------------
+void ScopedPhase::start(std::string_view name, bool simulatorEvents)
+{
+    g_openPhases.push_back(nested(name));
+    depth_ = g_openPhases.size();
+    events_ = simulatorEvents;
+    if (events_) events0_ = ns3::Simulator::GetEventCount();
+    cpu0_ = ProcessCpuMs();
+    wall0_ = std::chrono::steady_clock::now();
+}
+
+void ScopedPhase::stop()
+{
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall0_).count();
+    double cpuMs = ProcessCpuMs() - cpu0_;
+    uint64_t events = events_ ? ns3::Simulator::GetEventCount() - events0_ : 0;
+    // ResetProfile() or a toggle may have happened while the phase was open
+    if (g_openPhases.size() != depth_) return;
+    std::string name = std::move(g_openPhases.back());
+    g_openPhases.pop_back();
+    if (g_profilingEnabled) addSample(name, 1, wallMs, wallMs, cpuMs, events, processPeakRssKb());
+}
+
+// ---------------------------------------------------------------------
+// Report and worker transport
+// ---------------------------------------------------------------------
+static std::string jsonEscaped(const std::string& s)
+{
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+bool WriteProfileReport(const std::string& path)
+{
+    std::filesystem::path p(path);
+    std::error_code ec;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << std::fixed << std::setprecision(3) << "{\n  \"phases\": [\n";
+    for (size_t i = 0; i < g_phases.size(); ++i) {
+        const PhaseStats& s = g_phases[i];
+        out << "    {\"name\": \"" << jsonEscaped(s.name) << "\", \"calls\": " << s.calls
+            << ", \"wall_ms\": " << s.wallMs << ", \"max_wall_ms\": " << s.maxWallMs
+            << ", \"cpu_ms\": " << s.cpuMs << ", \"events\": " << s.events
+            << ", \"peak_rss_kb\": " << s.peakRssKb << "}" << (i + 1 < g_phases.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"counters\": {";
+    for (size_t i = 0; i < g_counters.size(); ++i)
+        out << (i ? ", " : "") << "\"" << jsonEscaped(g_counters[i].first) << "\": " << g_counters[i].second;
+    out << "},\n  \"peak_rss_kb\": " << processPeakRssKb() << "\n}\n";
+    return static_cast<bool>(out);
+}
+
+// One tab-separated line per phase ("P") or counter ("C")
+std::string SerializeProfile()
+{
+    std::ostringstream out;
+    out << std::setprecision(17);
+    for (const PhaseStats& s : g_phases)
+        out << "P\t" << s.name << '\t' << s.calls << '\t' << s.wallMs << '\t' << s.maxWallMs << '\t'
+            << s.cpuMs << '\t' << s.events << '\t' << s.peakRssKb << '\n';
+    for (const auto& c : g_counters) out << "C\t" << c.first << '\t' << c.second << '\n';
+    return out.str();
+}
+
+void MergeProfile(std::string_view data)
+{
+    std::istringstream in{std::string(data)};
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind, name;
+        if (!std::getline(fields, kind, '\t') || !std::getline(fields, name, '\t')) continue;
+        if (kind == "P") {
+            uint64_t calls = 0, events = 0;
+            double wallMs = 0, maxWallMs = 0, cpuMs = 0;
+            long rssKb = 0;
+            if (fields >> calls >> wallMs >> maxWallMs >> cpuMs >> events >> rssKb)
+                addSample(nested(name), calls, wallMs, maxWallMs, cpuMs, events, rssKb);
+        } else if (kind == "C") {
+            uint64_t value = 0;
+            if (fields >> value) CountProfileEvent(name, value);
+        }
+    }
+}
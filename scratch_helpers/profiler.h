@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Phase profiler: wall time, CPU time, executed simulator events and peak
+// RSS per named phase, plus free-form counters, written as a JSON report.
+// Phases nest: a phase opened inside another is recorded as "outer/inner".
+// Disabled (the default) it costs one bool test per phase. Turn it on at
+// runtime with SetProfilingEnabled() or at start-up with
+// NS_GLOBAL_VALUE="LdtProfile=true".
+
+extern bool g_profilingEnabled;
+inline bool ProfilingEnabled() { return g_profilingEnabled; }
+void SetProfilingEnabled(bool on);
+// Apply the LdtProfile global value; returns whether profiling is on
+bool ProfilingFromEnvironment();
+
+// CPU time consumed by this process so far
+double ProcessCpuMs();
+
+// Add one sample to a phase (nested under the open phases) or a counter
+void RecordPhase(std::string_view name, double wallMs, double cpuMs, uint64_t events = 0);
+void CountProfileEvent(std::string_view counter, uint64_t delta = 1);
+
+void ResetProfile();
+bool WriteProfileReport(const std::string& path);
+
+// Transport of a worker process's samples to its parent (see RunWorkerPool);
+// merged phases nest under the phase open in the parent
+std::string SerializeProfile();
+void MergeProfile(std::string_view data);
+
+// Times the enclosing scope as one phase. An empty name (e.g. a label that
+// was only built when profiling is on) disables it. With simulatorEvents
+// the phase also counts the events the simulator executed inside it; use it
+// only while a simulator exists, since sampling creates one.
+class ScopedPhase {
+public:
+    explicit ScopedPhase(std::string_view name, bool simulatorEvents = false)
+        : active_(ProfilingEnabled() && !name.empty())
+    {
+        if (active_) start(name, simulatorEvents);
+    }
+    ~ScopedPhase()
+    {
+        if (active_) stop();
+    }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    void start(std::string_view name, bool simulatorEvents);
+    void stop();
+
+    bool active_;
+    bool events_{false};
+    size_t depth_{};
+    std::chrono::steady_clock::time_point wall0_;
+    double cpu0_{};
+    uint64_t events0_{};
+};
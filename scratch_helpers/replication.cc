@@ -0,0 +1,151 @@
+#include "replication.h"
+#include "workerPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+void RunningStat::add(double x)
+{
+    ++n_;
+    double delta = x - mean_;
+    mean_ += delta / n_;
+    m2_ += delta * (x - mean_);
+}
+
+double RunningStat::halfWidth(double confidence) const
+{
+    if (n_ < 2) return std::numeric_limits<double>::infinity();
+    double t = StudentTQuantile(0.5 + confidence / 2.0, n_ - 1);
+    return t * std::sqrt(variance() / n_);
+}
+
+// Standard normal quantile (Acklam's rational approximation, |error| < 1.2e-9)
+static double normalQuantile(double p)
+{
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    if (p <= 0.0) return -std::numeric_limits<double>::infinity();
+    if (p >= 1.0) return std::numeric_limits<double>::infinity();
+    if (p < 0.02425) {
+        double q = std::sqrt(-2.0 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if (p > 1.0 - 0.02425) return -normalQuantile(1.0 - p);
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+// Exact for 1 and 2 degrees of freedom, Cornish-Fisher expansion beyond
+double StudentTQuantile(double p, uint32_t dof)
+{
+    const double pi = 3.14159265358979323846;
+    if (dof == 0) return std::numeric_limits<double>::infinity();
+    if (dof == 1) return std::tan(pi * (p - 0.5));
+    if (dof == 2) return (2.0 * p - 1.0) / std::sqrt(2.0 * p * (1.0 - p));
+
+    double z = normalQuantile(p);
+    double z2 = z * z;
+    double v = dof;
+    double g1 = (z2 + 1.0) * z / 4.0;
+    double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+    double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+    double g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z / 92160.0;
+    return z + g1 / v + g2 / (v * v) + g3 / (v * v * v) + g4 / (v * v * v * v);
+}
+
+static bool precisionReached(const ReplicationSummary& summary, const ReplicationPolicy& policy)
+{
+    if (summary.runs < std::max<uint32_t>(policy.minRuns, 2)) return false;
+    for (const RunningStat& s : summary.stats) {
+        double target = std::max(policy.relPrecision * std::fabs(s.mean()), policy.absPrecision);
+        if (s.halfWidth(policy.confidence) > target) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// RunReplications()
+// ---------------------------------------------------------------------
+ReplicationSummary RunReplications(const std::vector<std::string>& kpiNames, const ReplicationPolicy& policy,
+                                   const std::function<std::vector<double>(uint64_t)>& replicate)
+{
+    ReplicationSummary summary;
+    summary.names = kpiNames;
+    summary.stats.resize(kpiNames.size());
+    const size_t kpis = kpiNames.size();
+    const unsigned workers = std::max(policy.workers, 1u);
+
+    auto job = [&](uint64_t run) -> std::string {
+        std::vector<double> values = replicate(run);
+        if (values.size() != kpis) return "";
+        return std::string(reinterpret_cast<const char*>(values.data()), kpis * sizeof(double));
+    };
+
+    uint32_t attempted = 0;
+    while (!summary.converged && attempted < policy.maxRuns) {
+        // The first batch covers the minimum run count in one go
+        uint32_t batch = std::max<uint32_t>(workers, attempted == 0 ? policy.minRuns : 0);
+        batch = std::min(batch, policy.maxRuns - attempted);
+        const uint64_t base = policy.firstRun + attempted;
+        attempted += batch;
+
+        RunWorkerPool(batch, workers,
+                      [&](size_t i) { return job(base + i); },
+                      [&](size_t i, const WorkerJobOutput& out) {
+            if (summary.converged) return;   // past the stopping point
+            if (!out.ok || out.payload.size() != kpis * sizeof(double)) {
+                std::cerr << "[ERROR] Replication run " << base + i << " failed.\n" << out.log;
+                ++summary.failed;
+                return;
+            }
+            std::vector<double> values(kpis);
+            std::memcpy(values.data(), out.payload.data(), out.payload.size());
+            for (size_t k = 0; k < kpis; ++k) summary.stats[k].add(values[k]);
+            ++summary.runs;
+            summary.converged = precisionReached(summary, policy);
+        });
+
+        std::cout << "[INFO] " << summary.runs << " replications";
+        if (summary.runs >= 2) {
+            double worst = 0.0;
+            for (const RunningStat& s : summary.stats)
+                if (s.mean() != 0.0) worst = std::max(worst, s.halfWidth(policy.confidence) / std::fabs(s.mean()));
+            const std::streamsize precision = std::cout.precision();
+            std::cout << ", widest relative CI half-width " << std::fixed << std::setprecision(2)
+                      << 100.0 * worst << "%" << std::defaultfloat << std::setprecision(precision);
+        }
+        std::cout << std::endl;
+    }
+    return summary;
+}
+
+void PrintReplicationSummary(const ReplicationSummary& summary, double confidence)
+{
+    const std::streamsize precision = std::cout.precision();
+    std::cout << "\n=== Replication Summary (" << summary.runs << " runs, "
+              << 100.0 * confidence << "% confidence) ===\n";
+    for (size_t k = 0; k < summary.names.size(); ++k) {
+        const RunningStat& s = summary.stats[k];
+        double hw = s.halfWidth(confidence);
+        std::cout << "  " << std::left << std::setw(18) << summary.names[k] << std::right << std::fixed
+                  << std::setprecision(4) << std::setw(14) << s.mean() << " ± " << hw;
+        if (s.mean() != 0.0 && std::isfinite(hw))
+            std::cout << " (" << std::setprecision(2) << 100.0 * hw / std::fabs(s.mean()) << "%)";
+        std::cout << std::defaultfloat << std::setprecision(precision) << '\n';
+    }
+    if (summary.failed > 0) std::cout << "  Failed runs: " << summary.failed << '\n';
+    std::cout << (summary.converged ? "[INFO] Target precision reached.\n"
+                                    : "[WARNING] Stopped at the replication limit before reaching the target precision.\n");
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Running mean and variance of one KPI (Welford's update)
+class RunningStat {
+public:
+    void add(double x);
+    uint32_t count() const { return n_; }
+    double mean() const { return mean_; }
+    double variance() const { return n_ > 1 ? m2_ / (n_ - 1) : 0.0; }
+    // Half-width of the two-sided Student-t confidence interval of the mean
+    double halfWidth(double confidence) const;
+
+private:
+    uint32_t n_{};
+    double mean_{};
+    double m2_{};
+};
+
+// Quantile of Student's t distribution with dof degrees of freedom
+double StudentTQuantile(double p, uint32_t dof);
+
+// When to stop replicating: after at least minRuns, once every KPI's
+// confidence half-width is within relPrecision of its mean (or within
+// absPrecision, which covers KPIs whose mean is near zero)
+struct ReplicationPolicy {
+    uint32_t minRuns{5};
+    uint32_t maxRuns{100};
+    double confidence{0.95};
+    double relPrecision{0.05};
+    double absPrecision{0.0};
+    unsigned workers{1};
+    uint64_t firstRun{1};   // RNG run number of the first replication
+};
+
+struct ReplicationSummary {
+    std::vector<std::string> names;
+    std::vector<RunningStat> stats;
+    uint32_t runs{};       // replications that count towards the statistics
+    uint32_t failed{};
+    bool converged{false};
+};
+
+// Run replicate(runNumber) -> KPI values, in batches of policy.workers
+// forked processes, until the precision target or maxRuns is reached.
+// Results are consumed in run order and the stop is decided per run, so the
+// outcome does not depend on the worker count; replications of the last
+// batch past the stopping point are discarded.
+ReplicationSummary RunReplications(const std::vector<std::string>& kpiNames, const ReplicationPolicy& policy,
+                                   const std::function<std::vector<double>(uint64_t)>& replicate);
+
+// "name  mean ± half-width (rel%)" table of a summary
+void PrintReplicationSummary(const ReplicationSummary& summary, double confidence);
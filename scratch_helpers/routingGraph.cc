@@ -0,0 +1,339 @@
+#include "routingGraph.h"
+#include <algorithm>
+#include <cmath>
+
+double EuclideanDistance(const NodePosition& a, const NodePosition& b)
+{
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// ---------------------------------------------------------------------
+// NameTable
+// ---------------------------------------------------------------------
+uint32_t NameTable::find(std::string_view name) const
+{
+    uint32_t lo = 0, hi = size();
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if ((*this)[mid] < name) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < size() && (*this)[lo] == name ? lo : kInvalidNode;
+}
+
+// ---------------------------------------------------------------------
+// BuildRoutingGraph()
+// ---------------------------------------------------------------------
+RoutingGraph BuildRoutingGraph(
+    const std::unordered_map<std::string, NodePosition>& nodes,
+    const std::unordered_map<std::string, std::vector<std::string>>& adjacency)
+{
+    RoutingGraph g;
+    std::vector<std::string> names;
+    names.reserve(nodes.size());
+    for (const auto& n : nodes) names.push_back(n.first);
+    std::sort(names.begin(), names.end());
+
+    uint32_t n = static_cast<uint32_t>(names.size());
+    std::unordered_map<std::string_view, uint32_t> ids;
+    ids.reserve(n);
+    g.positions.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        ids.emplace(names[i], i);
+        g.positions[i] = nodes.at(names[i]);
+    }
+
+    // Count out-degrees, then fill
+    g.offsets.assign(n + 1, 0);
+    for (uint32_t u = 0; u < n; ++u) {
+        auto it = adjacency.find(names[u]);
+        if (it == adjacency.end()) continue;
+        for (const std::string& v : it->second)
+            if (ids.count(v)) g.offsets[u + 1]++;
+    }
+    for (uint32_t u = 0; u < n; ++u) g.offsets[u + 1] += g.offsets[u];
+
+    g.targets.resize(g.offsets[n]);
+    g.weights.resize(g.offsets[n]);
+    for (uint32_t u = 0; u < n; ++u) {
+        auto it = adjacency.find(names[u]);
+        if (it == adjacency.end()) continue;
+        uint32_t k = g.offsets[u];
+        for (const std::string& name : it->second) {
+            auto v = ids.find(name);
+            if (v == ids.end()) continue;
+            g.targets[k] = v->second;
+            g.weights[k] = EuclideanDistance(g.positions[u], g.positions[v->second]);
+            ++k;
+        }
+    }
+    g.names = NameTable(std::move(names));
+    BuildReverseIndex(g);
+    return g;
+}
+
+void BuildReverseIndex(RoutingGraph& g)
+{
+    uint32_t n = g.nodeCount();
+    g.inOffsets.assign(n + 1, 0);
+    for (uint32_t v : g.targets) g.inOffsets[v + 1]++;
+    for (uint32_t v = 0; v < n; ++v) g.inOffsets[v + 1] += g.inOffsets[v];
+
+    g.sources.resize(g.targets.size());
+    g.inEdges.resize(g.targets.size());
+    std::vector<uint32_t> fill(g.inOffsets.begin(), g.inOffsets.end() - 1);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t k = g.offsets[u]; k < g.offsets[u + 1]; ++k) {
+            uint32_t slot = fill[g.targets[k]]++;
+            g.sources[slot] = u;
+            g.inEdges[slot] = k;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+// IndexedMinHeap
+// ---------------------------------------------------------------------
+void IndexedMinHeap::reset(uint32_t nodeCount)
+{
+    heap_.clear();
+    pos_.assign(nodeCount, kInvalidNode);
+}
+
+void IndexedMinHeap::clear()
+{
+    for (const Entry& e : heap_) pos_[e.node] = kInvalidNode;
+    heap_.clear();
+}
+
+void IndexedMinHeap::pushOrDecrease(uint32_t node, double key)
+{
+    uint32_t i = pos_[node];
+    if (i == kInvalidNode) {
+        i = static_cast<uint32_t>(heap_.size());
+        heap_.push_back({key, node});
+        pos_[node] = i;
+    } else {
+        if (key >= heap_[i].key) return;
+        heap_[i].key = key;
+    }
+    siftUp(i);
+}
+
+uint32_t IndexedMinHeap::pop()
+{
+    uint32_t node = heap_.front().node;
+    pos_[node] = kInvalidNode;
+    Entry last = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+        heap_[0] = last;
+        pos_[last.node] = 0;
+        siftDown(0);
+    }
+    return node;
+}
+
+void IndexedMinHeap::siftUp(uint32_t i)
+{
+    Entry e = heap_[i];
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (heap_[parent].key <= e.key) break;
+        heap_[i] = heap_[parent];
+        pos_[heap_[i].node] = i;
+        i = parent;
+    }
+    heap_[i] = e;
+    pos_[e.node] = i;
+}
+
+void IndexedMinHeap::siftDown(uint32_t i)
+{
+    Entry e = heap_[i];
+    uint32_t size = static_cast<uint32_t>(heap_.size());
+    while (true) {
+        uint32_t child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && heap_[child + 1].key < heap_[child].key) ++child;
+        if (e.key <= heap_[child].key) break;
+        heap_[i] = heap_[child];
+        pos_[heap_[i].node] = i;
+        i = child;
+    }
+    heap_[i] = e;
+    pos_[e.node] = i;
+}
+
+// ---------------------------------------------------------------------
+// SearchWorkspace
+// ---------------------------------------------------------------------
+void SearchWorkspace::prepare(uint32_t nodeCount)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    if (dist.size() != nodeCount) {
+        dist.assign(nodeCount, inf);
+        prev.assign(nodeCount, kInvalidNode);
+        distB.assign(nodeCount, inf);
+        nextB.assign(nodeCount, kInvalidNode);
+        heuristic.assign(nodeCount, -1.0);
+        touched.clear();
+        heap.reset(nodeCount);
+        heapB.reset(nodeCount);
+        return;
+    }
+    for (uint32_t v : touched) {
+        dist[v] = distB[v] = inf;
+        prev[v] = nextB[v] = kInvalidNode;
+        heuristic[v] = -1.0;
+    }
+    touched.clear();
+    heap.clear();
+    heapB.clear();
+}
+
+// ---------------------------------------------------------------------
+// ShortestPath() / FindRoute()
+// ---------------------------------------------------------------------
+bool ShortestPath(const RoutingGraph& graph, uint32_t start, uint32_t goal,
+                  SearchWorkspace& ws, PathResult& result)
+{
+    return FindRoute(graph, graph.weights, start, goal, SearchMode::Dijkstra, ws, result);
+}
+
+bool ShortestPath(const RoutingGraph& graph, const std::vector<double>& weights,
+                  uint32_t start, uint32_t goal, SearchWorkspace& ws, PathResult& result)
+{
+    return FindRoute(graph, weights, start, goal, SearchMode::Dijkstra, ws, result);
+}
+
+// Dijkstra, or A* when heuristicScale > 0
+static bool searchForward(const RoutingGraph& graph, const std::vector<double>& weights,
+                          uint32_t start, uint32_t goal, double heuristicScale,
+                          SearchWorkspace& ws, PathResult& result)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    const NodePosition& goalPos = graph.positions[goal];
+    auto h = [&](uint32_t v) {
+        if (heuristicScale <= 0.0) return 0.0;
+        if (ws.heuristic[v] < 0.0)
+            ws.heuristic[v] = heuristicScale * EuclideanDistance(graph.positions[v], goalPos);
+        return ws.heuristic[v];
+    };
+
+    ws.dist[start] = 0.0;
+    ws.touched.push_back(start);
+    ws.heap.pushOrDecrease(start, h(start));
+
+    while (!ws.heap.empty()) {
+        uint32_t u = ws.heap.pop();
+        ++result.expanded;
+        if (u == goal) break;
+
+        double du = ws.dist[u];
+        for (uint32_t k = graph.offsets[u]; k < graph.offsets[u + 1]; ++k) {
+            uint32_t v = graph.targets[k];
+            double alt = du + weights[k];
+            if (alt < ws.dist[v]) {
+                if (ws.dist[v] == inf) ws.touched.push_back(v);
+                ws.dist[v] = alt;
+                ws.prev[v] = u;
+                ws.heap.pushOrDecrease(v, alt + h(v));
+            }
+        }
+    }
+
+    if (ws.dist[goal] == inf) return false;
+
+    result.cost = ws.dist[goal];
+    for (uint32_t at = goal; at != kInvalidNode; at = ws.prev[at])
+        result.nodes.push_back(at);
+    std::reverse(result.nodes.begin(), result.nodes.end());
+    return true;
+}
+
+// Alternate forward and backward Dijkstra; stop once the two frontier
+// keys together cannot beat the best meeting point found so far
+static bool searchBidirectional(const RoutingGraph& graph, const std::vector<double>& weights,
+                                uint32_t start, uint32_t goal,
+                                SearchWorkspace& ws, PathResult& result)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    ws.dist[start] = 0.0;
+    ws.distB[goal] = 0.0;
+    ws.touched.push_back(start);
+    ws.touched.push_back(goal);
+    ws.heap.pushOrDecrease(start, 0.0);
+    ws.heapB.pushOrDecrease(goal, 0.0);
+
+    double best = start == goal ? 0.0 : inf;
+    uint32_t meet = start == goal ? start : kInvalidNode;
+
+    while (!ws.heap.empty() && !ws.heapB.empty()) {
+        if (ws.heap.topKey() + ws.heapB.topKey() >= best) break;
+
+        if (ws.heap.topKey() <= ws.heapB.topKey()) {
+            uint32_t u = ws.heap.pop();
+            ++result.expanded;
+            double du = ws.dist[u];
+            for (uint32_t k = graph.offsets[u]; k < graph.offsets[u + 1]; ++k) {
+                uint32_t v = graph.targets[k];
+                double alt = du + weights[k];
+                if (alt >= ws.dist[v]) continue;
+                if (ws.dist[v] == inf && ws.distB[v] == inf) ws.touched.push_back(v);
+                ws.dist[v] = alt;
+                ws.prev[v] = u;
+                ws.heap.pushOrDecrease(v, alt);
+                if (alt + ws.distB[v] < best) { best = alt + ws.distB[v]; meet = v; }
+            }
+        } else {
+            uint32_t u = ws.heapB.pop();
+            ++result.expanded;
+            double du = ws.distB[u];
+            for (uint32_t k = graph.inOffsets[u]; k < graph.inOffsets[u + 1]; ++k) {
+                uint32_t x = graph.sources[k];
+                double alt = du + weights[graph.inEdges[k]];
+                if (alt >= ws.distB[x]) continue;
+                if (ws.dist[x] == inf && ws.distB[x] == inf) ws.touched.push_back(x);
+                ws.distB[x] = alt;
+                ws.nextB[x] = u;
+                ws.heapB.pushOrDecrease(x, alt);
+                if (alt + ws.dist[x] < best) { best = alt + ws.dist[x]; meet = x; }
+            }
+        }
+    }
+
+    if (meet == kInvalidNode) return false;
+
+    result.cost = best;
+    for (uint32_t at = meet; at != kInvalidNode; at = ws.prev[at])
+        result.nodes.push_back(at);
+    std::reverse(result.nodes.begin(), result.nodes.end());
+    for (uint32_t at = ws.nextB[meet]; at != kInvalidNode; at = ws.nextB[at])
+        result.nodes.push_back(at);
+    return true;
+}
+
+bool FindRoute(const RoutingGraph& graph, const std::vector<double>& weights,
+               uint32_t start, uint32_t goal, SearchMode mode,
+               SearchWorkspace& ws, PathResult& result, double heuristicScale)
+{
+    result.nodes.clear();
+    result.cost = std::numeric_limits<double>::infinity();
+    result.expanded = 0;
+    if (start >= graph.nodeCount() || goal >= graph.nodeCount()) return false;
+
+    ws.prepare(graph.nodeCount());
+    switch (mode) {
+        case SearchMode::AStar:
+            return searchForward(graph, weights, start, goal, heuristicScale, ws, result);
+        case SearchMode::Bidirectional:
+            return searchBidirectional(graph, weights, start, goal, ws, result);
+        case SearchMode::Dijkstra:
+        default:
+            return searchForward(graph, weights, start, goal, 0.0, ws, result);
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Struct to hold node data
+struct NodePosition {
+    double x, y, z;
+};
+
+static const uint32_t kInvalidNode = std::numeric_limits<uint32_t>::max();
+
+// Node names by routing id, in sorted order so ids are stable across runs
+// and a name is found by binary search. The table owns its strings, or views
+// a string table stored elsewhere (a mapped compiled scenario, kept alive
+// through backing): name v is data[offsets[ids[v]] .. offsets[ids[v] + 1]).
+class NameTable {
+public:
+    NameTable() = default;
+    explicit NameTable(std::vector<std::string> sortedNames) : owned_(std::move(sortedNames)) {}
+    NameTable(std::shared_ptr<const void> backing, const uint64_t* offsets, const char* data,
+              const uint32_t* ids, uint32_t count)
+        : backing_(std::move(backing)), offsets_(offsets), data_(data), ids_(ids), count_(count)
+    {
+    }
+
+    uint32_t size() const { return ids_ ? count_ : static_cast<uint32_t>(owned_.size()); }
+    bool empty() const { return size() == 0; }
+    std::string_view operator[](uint32_t id) const
+    {
+        if (!ids_) return owned_[id];
+        uint32_t s = ids_[id];
+        return {data_ + offsets_[s], static_cast<size_t>(offsets_[s + 1] - offsets_[s])};
+    }
+    // Id of name, or kInvalidNode
+    uint32_t find(std::string_view name) const;
+
+private:
+    std::vector<std::string> owned_;
+    std::shared_ptr<const void> backing_;
+    const uint64_t* offsets_{};
+    const char* data_{};
+    const uint32_t* ids_{};
+    uint32_t count_{};
+};
+
+// Routing topology with node names interned to dense ids and the directed
+// links stored in compressed-sparse-row form. Out-edges of node u are
+// targets[offsets[u] .. offsets[u + 1]) with matching weights. The reverse
+// CSR lists in-edges of v as sources[inOffsets[v] .. inOffsets[v + 1]),
+// with inEdges giving the forward edge index (for its weight).
+struct RoutingGraph {
+    NameTable names;
+    std::vector<NodePosition> positions;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<double> weights;
+    std::vector<uint32_t> inOffsets;
+    std::vector<uint32_t> sources;
+    std::vector<uint32_t> inEdges;
+
+    uint32_t nodeCount() const { return names.size(); }
+    uint32_t edgeCount() const { return static_cast<uint32_t>(targets.size()); }
+
+    uint32_t idOf(std::string_view name) const { return names.find(name); }
+};
+
+// Build the CSR graph. Ids follow sorted name order so they are stable
+// across runs; links to unknown nodes are dropped and every edge weight is
+// the Euclidean distance between its endpoints.
+RoutingGraph BuildRoutingGraph(
+    const std::unordered_map<std::string, NodePosition>& nodes,
+    const std::unordered_map<std::string, std::vector<std::string>>& adjacency);
+
+double EuclideanDistance(const NodePosition& a, const NodePosition& b);
+
+// Fill the reverse CSR (inOffsets/sources/inEdges) from the forward one
+void BuildReverseIndex(RoutingGraph& graph);
+
+// Binary min-heap over node ids with decrease-key
+class IndexedMinHeap {
+public:
+    void reset(uint32_t nodeCount);
+    bool empty() const { return heap_.empty(); }
+    bool contains(uint32_t node) const { return node < pos_.size() && pos_[node] != kInvalidNode; }
+    uint32_t top() const { return heap_.front().node; }
+    double topKey() const { return heap_.front().key; }
+    void pushOrDecrease(uint32_t node, double key);
+    uint32_t pop();
+    void clear();
+
+private:
+    struct Entry { double key; uint32_t node; };
+    void siftUp(uint32_t i);
+    void siftDown(uint32_t i);
+
+    std::vector<Entry> heap_;
+    std::vector<uint32_t> pos_;
+};
+
+// Per-query scratch state, reused between queries so a search only pays
+// for the nodes it actually touches. The *B members and heuristic cache are
+// used by the bidirectional and A* searches.
+struct SearchWorkspace {
+    std::vector<double> dist;
+    std::vector<uint32_t> prev;
+    std::vector<double> distB;
+    std::vector<uint32_t> nextB;
+    std::vector<double> heuristic;
+    std::vector<uint32_t> touched;
+    IndexedMinHeap heap;
+    IndexedMinHeap heapB;
+
+    void prepare(uint32_t nodeCount);
+};
+
+struct PathResult {
+    std::vector<uint32_t> nodes;   // start .. goal, empty if unreachable
+    double cost{std::numeric_limits<double>::infinity()};
+    size_t expanded{};             // nodes settled by the search
+};
+
+enum class SearchMode {
+    Dijkstra,
+    AStar,          // straight-line distance to the goal as the heuristic
+    Bidirectional   // Dijkstra from both ends, meeting in the middle
+};
+
+// Dijkstra from start to goal over the CSR graph. The overload taking
+// weights uses them (aligned with graph.targets) instead of graph.weights;
+// infinite weights mark unusable links.
+bool ShortestPath(const RoutingGraph& graph, const std::vector<double>& weights,
+                  uint32_t start, uint32_t goal, SearchWorkspace& ws, PathResult& result);
+bool ShortestPath(const RoutingGraph& graph, uint32_t start, uint32_t goal,
+                  SearchWorkspace& ws, PathResult& result);
+
+// Point-to-point route with the chosen search. All modes return an optimal
+// path. For A*, heuristicScale converts straight-line metres into a lower
+// bound on the edge cost (1 for distance weights, 1/c for latencies).
+bool FindRoute(const RoutingGraph& graph, const std::vector<double>& weights,
+               uint32_t start, uint32_t goal, SearchMode mode,
+               SearchWorkspace& ws, PathResult& result, double heuristicScale = 1.0);
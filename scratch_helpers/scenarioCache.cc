@@ -0,0 +1,333 @@
+#include "scenarioCache.h"
+#include "profiler.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kLdtcMagic[8] = {'L', 'D', 'T', 'C', 'S', 'C', 'N', 2};
+
+static bool statSource(const std::string& path, uint64_t& size, int64_t& mtimeNs)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    size = static_cast<uint64_t>(st.st_size);
+    mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+// FNV-1a style mixing over 8-byte words, then the tail bytes
+uint64_t ScenarioContentHash(std::string_view data)
+{
+    uint64_t h = 1469598103934665603ull;
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data.data() + i, 8);
+        h = (h ^ w) * 1099511628211ull;
+        h ^= h >> 29;
+    }
+    for (; i < data.size(); ++i) h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    return h ^ data.size();
+}
+
+// ---------------------------------------------------------------------
+// CompiledScenario
+// ---------------------------------------------------------------------
+bool CompiledScenario::open(const std::string& path)
+{
+    header_ = nullptr;
+    file_ = std::make_shared<MappedFile>();
+    if (!file_->open(path) || file_->size() < sizeof(LdtcHeader)) return false;
+    const LdtcHeader* h = section<LdtcHeader>(0);
+    if (std::memcmp(h->magic, kLdtcMagic, sizeof(kLdtcMagic)) != 0) return false;
+
+    // Every section must lie inside the file
+    const uint64_t size = file_->size();
+    auto fits = [&](uint64_t at, uint64_t bytes) { return at % 8 == 0 && at <= size && bytes <= size - at; };
+    const uint64_t graphIds = h->graphNodeCount * sizeof(uint32_t);
+    const uint64_t graphEdges = h->graphEdgeCount * sizeof(uint32_t);
+    if (!fits(h->stringOffsetsAt, (h->stringCount + 1ull) * sizeof(uint64_t)) ||
+        !fits(h->stringDataAt, h->stringBytes) ||
+        !fits(h->nodesAt, h->nodeCount * sizeof(LdtcNode)) ||
+        !fits(h->linkOffsetsAt, (h->nodeCount + 1ull) * sizeof(uint32_t)) ||
+        !fits(h->linksAt, h->linkCount * sizeof(uint32_t)) ||
+        !fits(h->graphNodesAt, graphIds) ||
+        !fits(h->graphNamesAt, graphIds) ||
+        !fits(h->graphOffsetsAt, graphIds + sizeof(uint32_t)) ||
+        !fits(h->graphTargetsAt, graphEdges) ||
+        !fits(h->graphWeightsAt, h->graphEdgeCount * sizeof(double)) ||
+        !fits(h->graphInOffsetsAt, graphIds + sizeof(uint32_t)) ||
+        !fits(h->graphSourcesAt, graphEdges) ||
+        !fits(h->graphInEdgesAt, graphEdges))
+        return false;
+
+    header_ = h;
+    stringOffsets_ = section<uint64_t>(h->stringOffsetsAt);
+    stringData_ = section<char>(h->stringDataAt);
+    nodes_ = section<LdtcNode>(h->nodesAt);
+    linkOffsets_ = section<uint32_t>(h->linkOffsetsAt);
+    links_ = section<uint32_t>(h->linksAt);
+    graphNodes_ = section<uint32_t>(h->graphNodesAt);
+    graphNames_ = section<uint32_t>(h->graphNamesAt);
+    graphOffsets_ = section<uint32_t>(h->graphOffsetsAt);
+    graphTargets_ = section<uint32_t>(h->graphTargetsAt);
+    graphWeights_ = section<double>(h->graphWeightsAt);
+    graphInOffsets_ = section<uint32_t>(h->graphInOffsetsAt);
+    graphSources_ = section<uint32_t>(h->graphSourcesAt);
+    graphInEdges_ = section<uint32_t>(h->graphInEdgesAt);
+    if (!validate()) {
+        header_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Offsets start at 0, never decrease and end at total
+template <typename T>
+static bool monotonic(const T* offsets, uint32_t count, uint64_t total)
+{
+    if (offsets[0] != 0) return false;
+    for (uint32_t i = 0; i < count; ++i)
+        if (offsets[i + 1] < offsets[i]) return false;
+    return offsets[count] == total;
+}
+
+bool CompiledScenario::validate() const
+{
+    const LdtcHeader& h = *header_;
+    const uint32_t n = h.graphNodeCount;
+    const uint32_t m = h.graphEdgeCount;
+    if (!monotonic(stringOffsets_, h.stringCount, h.stringBytes) ||
+        !monotonic(linkOffsets_, h.nodeCount, h.linkCount) ||
+        !monotonic(graphOffsets_, n, m) || !monotonic(graphInOffsets_, n, m))
+        return false;
+
+    for (uint32_t i = 0; i < h.nodeCount; ++i) {
+        const LdtcNode& c = nodes_[i];
+        if (c.name >= h.stringCount || c.type >= h.stringCount || c.txRate >= h.stringCount ||
+            c.rxRate >= h.stringCount)
+            return false;
+    }
+    for (uint32_t k = 0; k < h.linkCount; ++k)
+        if (links_[k] >= h.stringCount) return false;
+
+    // Routing names must be those of their node entries and strictly sorted
+    // (NameTable::find is a binary search)
+    for (uint32_t v = 0; v < n; ++v) {
+        if (graphNodes_[v] >= h.nodeCount || graphNames_[v] != nodes_[graphNodes_[v]].name) return false;
+        if (v > 0 && !(string(graphNames_[v - 1]) < string(graphNames_[v]))) return false;
+    }
+    for (uint32_t k = 0; k < m; ++k)
+        if (graphTargets_[k] >= n || !(graphWeights_[k] >= 0.0)) return false;
+    // Each in-edge must name a forward edge from its source to its node
+    for (uint32_t v = 0; v < n; ++v) {
+        for (uint32_t k = graphInOffsets_[v]; k < graphInOffsets_[v + 1]; ++k) {
+            uint32_t u = graphSources_[k];
+            uint32_t e = graphInEdges_[k];
+            if (u >= n || e < graphOffsets_[u] || e >= graphOffsets_[u + 1] || graphTargets_[e] != v)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool CompiledScenario::matchesSource(const std::string& sourcePath, const std::string& cachePath) const
+{
+    uint64_t size;
+    int64_t mtimeNs;
+    if (!header_ || !statSource(sourcePath, size, mtimeNs) || size != header_->sourceSize) return false;
+    if (mtimeNs == header_->sourceMtimeNs) return true;
+
+    // Touched but possibly unchanged (copied, checked out again ...)
+    MappedFile source;
+    if (!source.open(sourcePath) || ScenarioContentHash(source.view()) != header_->contentHash) return false;
+    int fd = ::open(cachePath.c_str(), O_WRONLY);
+    if (fd >= 0) {
+        pwrite(fd, &mtimeNs, sizeof(mtimeNs), offsetof(LdtcHeader, sourceMtimeNs));
+        ::close(fd);
+    }
+    return true;
+}
+
+std::string_view CompiledScenario::string(uint32_t id) const
+{
+    return {stringData_ + stringOffsets_[id], stringOffsets_[id + 1] - stringOffsets_[id]};
+}
+
+void CompiledScenario::toScenario(const std::string& source, Scenario& scenario) const
+{
+    scenario.source = source;
+    scenario.nodes.clear();
+    scenario.nodes.resize(header_->nodeCount);
+    scenario.index.clear();
+    scenario.index.reserve(header_->nodeCount);
+    for (uint32_t i = 0; i < header_->nodeCount; ++i) {
+        const LdtcNode& n = nodes_[i];
+        NodeConfig& c = scenario.nodes[i];
+        c.name = string(n.name);
+        c.type = string(n.type);
+        c.txRate = string(n.txRate);
+        c.rxRate = string(n.rxRate);
+        c.x = n.x;
+        c.y = n.y;
+        c.z = n.z;
+        c.freqMHz = n.freqMHz;
+        c.txPowerBm = n.txPowerDbm;
+        c.links.reserve(linkOffsets_[i + 1] - linkOffsets_[i]);
+        for (uint32_t k = linkOffsets_[i]; k < linkOffsets_[i + 1]; ++k)
+            c.links.emplace_back(string(links_[k]));
+        scenario.index[c.name] = i;
+    }
+}
+
+RoutingGraph CompiledScenario::toRoutingGraph() const
+{
+    RoutingGraph g;
+    uint32_t n = header_->graphNodeCount;
+    uint32_t m = header_->graphEdgeCount;
+    g.names = NameTable(file_, stringOffsets_, stringData_, graphNames_, n);
+    g.positions.resize(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        const LdtcNode& node = nodes_[graphNodes_[v]];
+        g.positions[v] = {node.x, node.y, node.z};
+    }
+    g.offsets.assign(graphOffsets_, graphOffsets_ + n + 1);
+    g.targets.assign(graphTargets_, graphTargets_ + m);
+    g.weights.assign(graphWeights_, graphWeights_ + m);
+    g.inOffsets.assign(graphInOffsets_, graphInOffsets_ + n + 1);
+    g.sources.assign(graphSources_, graphSources_ + m);
+    g.inEdges.assign(graphInEdges_, graphInEdges_ + m);
+    return g;
+}
+
+// ---------------------------------------------------------------------
+// CompileScenario()
+// ---------------------------------------------------------------------
+template <typename T>
+static void writeSection(std::ofstream& out, uint64_t& at, const T* data, size_t count)
+{
+    static const char zeros[8] = {};
+    uint64_t pos = static_cast<uint64_t>(out.tellp());
+    if (pos % 8) out.write(zeros, 8 - pos % 8);
+    at = static_cast<uint64_t>(out.tellp());
+    out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+bool CompileScenario(const Scenario& scenario, const RoutingGraph& graph,
+                     const std::string& sourcePath, const std::string& cachePath)
+{
+    LdtcHeader h{};
+    std::memcpy(h.magic, kLdtcMagic, sizeof(kLdtcMagic));
+    {
+        MappedFile source;
+        if (!statSource(sourcePath, h.sourceSize, h.sourceMtimeNs) || !source.open(sourcePath)) return false;
+        h.contentHash = ScenarioContentHash(source.view());
+    }
+
+    // Intern strings
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<uint64_t> stringOffsets{0};
+    std::string stringData;
+    auto intern = [&](const std::string& s) {
+        auto [it, added] = ids.emplace(s, static_cast<uint32_t>(ids.size()));
+        if (added) {
+            stringData += s;
+            stringOffsets.push_back(stringData.size());
+        }
+        return it->second;
+    };
+
+    std::vector<LdtcNode> nodes(scenario.nodes.size());
+    std::vector<uint32_t> linkOffsets(scenario.nodes.size() + 1, 0);
+    std::vector<uint32_t> links;
+    for (size_t i = 0; i < scenario.nodes.size(); ++i) {
+        const NodeConfig& c = scenario.nodes[i];
+        nodes[i] = {intern(c.name), intern(c.type), intern(c.txRate), intern(c.rxRate),
+                    c.x, c.y, c.z, c.freqMHz, c.txPowerBm};
+        for (const std::string& link : c.links) links.push_back(intern(link));
+        linkOffsets[i + 1] = static_cast<uint32_t>(links.size());
+    }
+
+    std::vector<uint32_t> graphNodes(graph.nodeCount());
+    std::vector<uint32_t> graphNames(graph.nodeCount());
+    for (uint32_t v = 0; v < graph.nodeCount(); ++v) {
+        std::string name(graph.names[v]);
+        graphNodes[v] = scenario.index.at(name);
+        graphNames[v] = ids.at(name);
+    }
+
+    h.nodeCount = static_cast<uint32_t>(nodes.size());
+    h.stringCount = static_cast<uint32_t>(ids.size());
+    h.linkCount = static_cast<uint32_t>(links.size());
+    h.graphNodeCount = graph.nodeCount();
+    h.graphEdgeCount = graph.edgeCount();
+    h.stringBytes = stringData.size();
+
+    std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        writeSection(out, h.stringOffsetsAt, stringOffsets.data(), stringOffsets.size());
+        writeSection(out, h.stringDataAt, stringData.data(), stringData.size());
+        writeSection(out, h.nodesAt, nodes.data(), nodes.size());
+        writeSection(out, h.linkOffsetsAt, linkOffsets.data(), linkOffsets.size());
+        writeSection(out, h.linksAt, links.data(), links.size());
+        writeSection(out, h.graphNodesAt, graphNodes.data(), graphNodes.size());
+        writeSection(out, h.graphNamesAt, graphNames.data(), graphNames.size());
+        writeSection(out, h.graphOffsetsAt, graph.offsets.data(), graph.offsets.size());
+        writeSection(out, h.graphTargetsAt, graph.targets.data(), graph.targets.size());
+        writeSection(out, h.graphWeightsAt, graph.weights.data(), graph.weights.size());
+        writeSection(out, h.graphInOffsetsAt, graph.inOffsets.data(), graph.inOffsets.size());
+        writeSection(out, h.graphSourcesAt, graph.sources.data(), graph.sources.size());
+        writeSection(out, h.graphInEdgesAt, graph.inEdges.data(), graph.inEdges.size());
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        if (!out) return false;
+    }
+    return std::rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+}
+
+// ---------------------------------------------------------------------
+// LoadScenarioCached()
+// ---------------------------------------------------------------------
+bool LoadScenarioCached(const std::string& path, Scenario& scenario, RoutingGraph* graph, bool* rebuilt)
+{
+    ScopedPhase phase("load_scenario");
+    const std::string cachePath = path + ".ldtc";
+    {
+        ScopedPhase load("cache_load");
+        CompiledScenario compiled;
+        if (compiled.open(cachePath) && compiled.matchesSource(path, cachePath)) {
+            compiled.toScenario(path, scenario);
+            if (graph) *graph = compiled.toRoutingGraph();
+            if (rebuilt) *rebuilt = false;
+            CountProfileEvent("scenario_cache_hits");
+            return true;
+        }
+    }
+
+    CountProfileEvent("scenario_cache_misses");
+    {
+        ScopedPhase parse("parse");
+        if (!LoadScenario(path, scenario)) return false;
+    }
+    RoutingGraph built;
+    {
+        ScopedPhase build("graph_build");
+        built = BuildScenarioGraph(scenario);
+    }
+    {
+        ScopedPhase compile("cache_build");
+        if (!CompileScenario(scenario, built, path, cachePath))
+            std::cerr << "[WARNING] Could not write compiled scenario " << cachePath << '\n';
+    }
+    if (graph) *graph = std::move(built);
+    if (rebuilt) *rebuilt = true;
+    return true;
+}
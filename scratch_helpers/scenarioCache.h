@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "LDT_shared.h"
+#include "routingGraph.h"
+#include "scenarioParser.h"
+
+// On-disk layout of a compiled scenario (<config>.ldtc). All sections are
+// 8-byte aligned arrays located by the offsets in the header; strings
+// (names, types, rates, link targets) are interned once and referenced by id.
+// The routing graph is stored complete (names, forward and reverse CSR) so
+// that a load maps it instead of rebuilding it.
+struct LdtcHeader {
+    char magic[8];
+    uint64_t sourceSize;
+    int64_t sourceMtimeNs;
+    uint64_t contentHash;
+    uint32_t nodeCount;        // scenario entries, file order
+    uint32_t stringCount;
+    uint32_t linkCount;        // total "Linked Nodes" entries
+    uint32_t graphNodeCount;   // distinct node names (routing ids)
+    uint32_t graphEdgeCount;
+    uint32_t reserved;
+    uint64_t stringBytes;
+    uint64_t stringOffsetsAt;  // uint64_t[stringCount + 1]
+    uint64_t stringDataAt;     // char[stringBytes]
+    uint64_t nodesAt;          // LdtcNode[nodeCount]
+    uint64_t linkOffsetsAt;    // uint32_t[nodeCount + 1]
+    uint64_t linksAt;          // uint32_t[linkCount] string ids
+    uint64_t graphNodesAt;     // uint32_t[graphNodeCount] node entry per routing id
+    uint64_t graphNamesAt;     // uint32_t[graphNodeCount] name string id, names sorted
+    uint64_t graphOffsetsAt;   // uint32_t[graphNodeCount + 1]
+    uint64_t graphTargetsAt;   // uint32_t[graphEdgeCount]
+    uint64_t graphWeightsAt;   // double[graphEdgeCount]
+    uint64_t graphInOffsetsAt; // uint32_t[graphNodeCount + 1]
+    uint64_t graphSourcesAt;   // uint32_t[graphEdgeCount]
+    uint64_t graphInEdgesAt;   // uint32_t[graphEdgeCount]
+};
+
+struct LdtcNode {
+    uint32_t name, type, txRate, rxRate;   // string ids
+    double x, y, z;
+    double freqMHz;
+    double txPowerDbm;
+};
+
+// Read-only view of a memory-mapped .ldtc file
+class CompiledScenario {
+public:
+    // Map and validate path: every section in bounds, offset arrays
+    // monotonic and every string, node and edge index in range. A file
+    // failing any check is treated as a cache miss.
+    bool open(const std::string& path);
+    // True if the cache was built from sourcePath as it is now: size and
+    // mtime match, or the content hash does (then the stored mtime is refreshed)
+    bool matchesSource(const std::string& sourcePath, const std::string& cachePath) const;
+
+    uint32_t nodeCount() const { return header_->nodeCount; }
+    std::string_view string(uint32_t id) const;
+    const LdtcNode& node(uint32_t i) const { return nodes_[i]; }
+
+    // Materialize as the shared structures used by the menu actions. The
+    // routing graph's names view the mapping (which it keeps alive); the
+    // CSR arrays are bulk copies.
+    void toScenario(const std::string& source, Scenario& scenario) const;
+    RoutingGraph toRoutingGraph() const;
+
+private:
+    bool validate() const;
+    template <typename T>
+    const T* section(uint64_t offset) const
+    {
+        return reinterpret_cast<const T*>(file_->view().data() + offset);
+    }
+
+    std::shared_ptr<MappedFile> file_;
+    const LdtcHeader* header_{};
+    const uint64_t* stringOffsets_{};
+    const char* stringData_{};
+    const LdtcNode* nodes_{};
+    const uint32_t* linkOffsets_{};
+    const uint32_t* links_{};
+    const uint32_t* graphNodes_{};
+    const uint32_t* graphNames_{};
+    const uint32_t* graphOffsets_{};
+    const uint32_t* graphTargets_{};
+    const double* graphWeights_{};
+    const uint32_t* graphInOffsets_{};
+    const uint32_t* graphSources_{};
+    const uint32_t* graphInEdges_{};
+};
+
+// Hash of a file's bytes used to validate compiled scenarios
+uint64_t ScenarioContentHash(std::string_view data);
+
+// Write scenario (and its routing graph) to cachePath, stamped with the
+// size, mtime and content hash of sourcePath
+bool CompileScenario(const Scenario& scenario, const RoutingGraph& graph,
+                     const std::string& sourcePath, const std::string& cachePath);
+
+// Load a scenario through its compiled cache <path>.ldtc: a current cache is
+// memory-mapped and used directly, otherwise the text is parsed and the
+// cache rewritten. graph, if given, receives the routing graph.
+bool LoadScenarioCached(const std::string& path, Scenario& scenario,
+                        RoutingGraph* graph = nullptr, bool* rebuilt = nullptr);
@@ -0,0 +1,96 @@
+#include "scenarioGenerator.h"
+#include "kdTree.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string_view>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// WriteSyntheticScenario()
+// ---------------------------------------------------------------------
+bool WriteSyntheticScenario(const std::string& path, const SyntheticScenarioParams& params)
+{
+    const uint32_t n = params.nodes;
+    const double side = std::sqrt(n / std::max(params.density, 1e-9)) * 1000.0;   // m
+
+    std::mt19937_64 rng(params.seed);
+    auto uniform = [&]() { return static_cast<double>(rng() >> 11) * 0x1.0p-53; };
+    std::vector<double> xs(n), ys(n), zs(n, 0.0);
+    for (uint32_t i = 0; i < n; ++i) {
+        xs[i] = uniform() * side;
+        ys[i] = uniform() * side;
+    }
+
+    // Node 0 is the gateway, every stride-th node a base station
+    const uint32_t stride = params.enbFraction > 0.0
+                                ? std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(1.0 / params.enbFraction)))
+                                : 0;
+    enum Kind { Gateway, Enb, Ue };
+    auto kindOf = [&](uint32_t i) { return i == 0 ? Gateway : (stride && i % stride == 0 ? Enb : Ue); };
+    auto nameOf = [&](uint32_t i, std::string& out) {
+        char buf[16];
+        auto r = std::to_chars(buf, buf + sizeof(buf), i);
+        out = kindOf(i) == Gateway ? "GW" : kindOf(i) == Enb ? "ENB" : "UE";
+        out.append(buf, r.ptr - buf);
+    };
+
+    KdTree tree;
+    tree.build(xs, ys, zs);
+
+    std::filesystem::path p(path);
+    std::error_code ec;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    std::string buffer;
+    buffer.reserve((1 << 20) + 4096);
+    bool ok = true;
+    auto flush = [&]() {
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) ok = false;
+        buffer.clear();
+    };
+    auto number = [&](double v) {
+        char buf[32];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, 2);
+        buffer.append(buf, r.ptr - buf);
+    };
+
+    std::vector<KdNeighbor> nearest;
+    std::string name;
+    for (uint32_t i = 0; i < n; ++i) {
+        Kind kind = kindOf(i);
+        buffer += "NODECONFIGHEADER\nNode Name: \"";
+        nameOf(i, name);
+        buffer += name;
+        buffer += kind == Gateway ? "\"\nNode Type: \"Gateway\"\n"
+                  : kind == Enb   ? "\"\nNode Type: \"gNB Base Station\"\n"
+                                  : "\"\nNode Type: \"User Equipment\"\n";
+        buffer += "Location: ";
+        number(xs[i]);
+        buffer += ", ";
+        number(ys[i]);
+        buffer += ", 0\n";
+        buffer += kind == Ue ? "Transmission Frequency: 2400\nTransmission Power: 20\n"
+                             : "Transmission Frequency: 2400\nTransmission Power: 30\n";
+        buffer += "Transmission Data Rate: 10Mbps\nReceiver Data Rate: 10Mbps\nLinked Nodes: ";
+
+        tree.nearest(xs[i], ys[i], zs[i], params.degree + 1, nearest);
+        uint32_t linked = 0;
+        for (const KdNeighbor& nb : nearest) {
+            if (nb.index == i || linked == params.degree) continue;
+            if (linked++) buffer += ", ";
+            nameOf(nb.index, name);
+            buffer += name;
+        }
+        buffer += "\n\n";
+        if (buffer.size() >= (1 << 20)) flush();
+    }
+    flush();
+    if (std::fclose(file) != 0) ok = false;
+    return ok;
+}
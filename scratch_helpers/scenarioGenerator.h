@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Procedural lunar surface scenario: one gateway, a share of base stations
+// and user equipment dropped uniformly over a square sized for the requested
+// density, every node linked to its nearest neighbours
+struct SyntheticScenarioParams {
+    uint32_t nodes{1000};
+    double density{100.0};      // nodes per km²
+    uint32_t degree{4};         // "Linked Nodes" per node (nearest neighbours)
+    double enbFraction{0.05};   // share of base stations; the rest are UEs
+    uint64_t seed{1};
+};
+
+// Write the scenario as a NODECONFIGHEADER file readable by LoadScenario().
+// Output is deterministic for given parameters.
+bool WriteSyntheticScenario(const std::string& path, const SyntheticScenarioParams& params);
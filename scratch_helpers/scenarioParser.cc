@@ -0,0 +1,245 @@
+#include "scenarioParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------
+// MappedFile
+// ---------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// ---------------------------------------------------------------------
+// Tokenizing helpers
+// ---------------------------------------------------------------------
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '"';
+}
+
+static std::string_view trimView(std::string_view s)
+{
+    while (!s.empty() && isBlank(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isBlank(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+static bool endsWith(std::string_view s, std::string_view suffix)
+{
+    return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+}
+
+// Parse a leading number; trailing text (e.g. a unit) is ignored like stod()
+static bool parseNumber(std::string_view s, double& out)
+{
+    s = trimView(s);
+    if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr != s.data();
+}
+
+// Split on commas and blanks, calling fn for each non-empty token
+template <typename Fn>
+static void forEachToken(std::string_view s, Fn fn)
+{
+    size_t i = 0;
+    while (i < s.size()) {
+        while (i < s.size() && (s[i] == ',' || isBlank(s[i]))) ++i;
+        size_t begin = i;
+        while (i < s.size() && s[i] != ',' && !isBlank(s[i])) ++i;
+        if (i > begin) fn(s.substr(begin, i - begin));
+    }
+}
+
+// ---------------------------------------------------------------------
+// ParseScenarioText()
+// ---------------------------------------------------------------------
+bool ParseScenarioText(std::string_view text, const std::string& sourceName, Scenario& scenario)
+{
+    scenario.source = sourceName;
+    scenario.nodes.clear();
+    scenario.index.clear();
+
+    size_t errors = 0;
+    const size_t maxReported = 20;
+    size_t lineNo = 0;
+    auto error = [&](const std::string& message) {
+        if (errors++ < maxReported)
+            std::cerr << "[ERROR] " << sourceName << ":" << lineNo << ": " << message << "\n";
+    };
+
+    NodeConfig current;
+    size_t blockLine = 1;
+    auto flush = [&]() {
+        if (!current.name.empty()) {
+            scenario.nodes.push_back(std::move(current));
+        } else if (current.freqMHz != 0.0 || !current.links.empty() || !current.type.empty()) {
+            std::cerr << "[WARNING] " << sourceName << ":" << blockLine
+                      << ": node without a Name skipped.\n";
+        }
+        current = NodeConfig();
+    };
+
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* lineEnd = nl ? nl : end;
+        std::string_view line(p, lineEnd - p);
+        p = nl ? nl + 1 : end;
+        ++lineNo;
+
+        if (line.find("NODECONFIGHEADER") != std::string_view::npos) {
+            flush();
+            blockLine = lineNo;
+            continue;
+        }
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view key = trimView(line.substr(0, colon));
+        std::string_view value = trimView(line.substr(colon + 1));
+
+        if (endsWith(key, "Name")) {
+            current.name.assign(value);
+        } else if (endsWith(key, "Type")) {
+            current.type.assign(value);
+        } else if (endsWith(key, "Location")) {
+            double xyz[3];
+            int count = 0;
+            bool ok = true;
+            forEachToken(value, [&](std::string_view tok) {
+                if (count < 3 && !parseNumber(tok, xyz[count])) ok = false;
+                ++count;
+            });
+            if (!ok || count != 3) {
+                error("Location must be three numbers 'x, y, z', got '" + std::string(value) + "'");
+                continue;
+            }
+            current.x = xyz[0];
+            current.y = xyz[1];
+            current.z = xyz[2];
+        } else if (endsWith(key, "Transmission Frequency")) {
+            if (!parseNumber(value, current.freqMHz))
+                error("invalid Transmission Frequency '" + std::string(value) + "'");
+        } else if (endsWith(key, "Transmission Power")) {
+            if (!parseNumber(value, current.txPowerBm))
+                error("invalid Transmission Power '" + std::string(value) + "'");
+        } else if (endsWith(key, "Transmission Data Rate")) {
+            current.txRate.assign(value);
+        } else if (endsWith(key, "Receiver Data Rate")) {
+            current.rxRate.assign(value);
+        } else if (endsWith(key, "Linked Nodes")) {
+            current.links.reserve(current.links.size() + std::count(value.begin(), value.end(), ',') + 1);
+            forEachToken(value, [&](std::string_view tok) { current.links.emplace_back(tok); });
+        }
+    }
+    flush();
+
+    if (errors > maxReported)
+        std::cerr << "[ERROR] " << sourceName << ": " << errors - maxReported << " more errors not shown.\n";
+
+    scenario.index.reserve(scenario.nodes.size());
+    for (uint32_t i = 0; i < scenario.nodes.size(); ++i)
+        scenario.index[scenario.nodes[i].name] = i;   // later definitions win
+    return errors == 0;
+}
+
+bool LoadScenario(const std::string& path, Scenario& scenario)
+{
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "[ERROR] Could not open " << path << std::endl;
+        return false;
+    }
+    return ParseScenarioText(file.view(), path, scenario);
+}
+
+// ---------------------------------------------------------------------
+// BuildScenarioGraph()
+// ---------------------------------------------------------------------
+RoutingGraph BuildScenarioGraph(const Scenario& scenario)
+{
+    RoutingGraph g;
+    std::vector<std::string> names;
+    names.reserve(scenario.index.size());
+    for (const auto& entry : scenario.index) names.push_back(entry.first);
+    std::sort(names.begin(), names.end());
+
+    uint32_t n = static_cast<uint32_t>(names.size());
+    std::unordered_map<std::string_view, uint32_t> ids;
+    ids.reserve(n);
+    g.positions.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        ids.emplace(names[i], i);
+        const NodeConfig& c = scenario.nodes[scenario.index.at(names[i])];
+        g.positions[i] = {c.x, c.y, c.z};
+    }
+
+    // Links of every definition of a node count, as with the name maps
+    std::vector<uint32_t> owner(scenario.nodes.size());
+    g.offsets.assign(n + 1, 0);
+    for (size_t i = 0; i < scenario.nodes.size(); ++i) {
+        owner[i] = ids.at(scenario.nodes[i].name);
+        for (const std::string& link : scenario.nodes[i].links)
+            if (ids.count(link)) g.offsets[owner[i] + 1]++;
+    }
+    for (uint32_t u = 0; u < n; ++u) g.offsets[u + 1] += g.offsets[u];
+
+    g.targets.resize(g.offsets[n]);
+    g.weights.resize(g.offsets[n]);
+    std::vector<uint32_t> fill(g.offsets.begin(), g.offsets.end() - 1);
+    for (size_t i = 0; i < scenario.nodes.size(); ++i) {
+        uint32_t u = owner[i];
+        for (const std::string& link : scenario.nodes[i].links) {
+            auto v = ids.find(link);
+            if (v == ids.end()) continue;
+            uint32_t k = fill[u]++;
+            g.targets[k] = v->second;
+            g.weights[k] = EuclideanDistance(g.positions[u], g.positions[v->second]);
+        }
+    }
+    g.names = NameTable(std::move(names));
+    BuildReverseIndex(g);
+    return g;
+}
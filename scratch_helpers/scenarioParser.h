@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "LDT_shared.h"
+#include "routingGraph.h"
+
+// Read-only memory mapping of a whole file (empty files map to an empty view)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    std::string_view view() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_{};
+    size_t size_{};
+};
+
+// Parse a NODECONFIGHEADER scenario file into scenario. The file is
+// memory-mapped and tokenized in one pass; problems are reported on stderr
+// as "file:line: message". Returns false if the file could not be read or
+// contained errors.
+bool LoadScenario(const std::string& path, Scenario& scenario);
+bool ParseScenarioText(std::string_view text, const std::string& sourceName, Scenario& scenario);
+
+// Routing graph of the scenario's nodes and links (same ids and weights as
+// BuildRoutingGraph over the equivalent name maps)
+RoutingGraph BuildScenarioGraph(const Scenario& scenario);
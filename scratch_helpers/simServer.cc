@@ -0,0 +1,969 @@
+#include "simServer.h"
+#include "LDT_shared.h"
+#include "contractionHierarchy.h"
+#include "linkResultCache.h"
+#include "binaryTrace.h"
+#include "scenarioCache.h"
+#include "workerPool.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern LinkResult simulateTransmission(double distance, double freqMHz, double txPowerdBm, std::string rate);
+extern uint32_t traceLinkStart(const LinkJob& link);
+extern std::vector<LinkResult> simulateScenario(const std::vector<NodeConfig>& configs,
+                                                const std::vector<LinkJob>& links);
+extern int runLunarDtCI(int argc, char* argv[], CiResult* result);
+
+// Whitespace-separated tokens; double quotes group whitespace and, inside
+// them, a backslash takes the next character literally. False on an
+// unterminated quote.
+static bool splitJobLine(const std::string& line, std::vector<std::string>& tokens)
+{
+    tokens.clear();
+    size_t i = 0;
+    while (true) {
+        while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+        if (i == line.size()) return true;
+        std::string token;
+        bool quoted = false;
+        for (; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"') quoted = false;
+                else if (c == '\\' && i + 1 < line.size()) token += line[++i];
+                else token += c;
+            } else if (c == '"') {
+                quoted = true;
+            } else if (std::isspace(static_cast<unsigned char>(c))) {
+                break;
+            } else {
+                token += c;
+            }
+        }
+        if (quoted) return false;
+        tokens.push_back(std::move(token));
+    }
+}
+
+bool ParseServerJob(const std::string& line, ServerJob& job)
+{
+    job = ServerJob();
+    std::vector<std::string> tokens;
+    bool complete = splitJobLine(line, tokens);
+    if (!tokens.empty()) job.id = tokens[0];
+    if (!complete || tokens.size() < 2) return false;
+    job.kind = tokens[1];
+    for (size_t i = 2; i < tokens.size(); ++i) {
+        size_t eq = tokens[i].find('=');
+        if (eq == std::string::npos || eq == 0) return false;
+        job.args[tokens[i].substr(0, eq)] = tokens[i].substr(eq + 1);
+    }
+    return true;
+}
+
+std::string QuoteJobValue(const std::string& value)
+{
+    if (!value.empty() && value.find_first_of(" \t\"\\") == std::string::npos) return value;
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+static std::string formatValue(double v)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", v);
+    return buf;
+}
+
+// ---------------------------------------------------------------------
+// Warm scenarios
+// ---------------------------------------------------------------------
+struct WarmScenario {
+    Scenario scenario;
+    RoutingGraph graph;
+    std::unique_ptr<ContractionHierarchy> ch;   // built by the first route job
+    uint64_t size{};
+    int64_t mtimeNs{};
+};
+
+static bool fileStamp(const std::string& path, uint64_t& size, int64_t& mtimeNs)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    size = static_cast<uint64_t>(st.st_size);
+    mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+static std::map<std::string, std::unique_ptr<WarmScenario>> g_warmScenarios;
+
+// Scenario for path, (re)loaded in the server process when the file changed
+static WarmScenario* warmScenario(const std::string& path, bool withRoutingIndex, std::string& error)
+{
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    if (!fileStamp(path, size, mtimeNs)) {
+        error = "cannot read " + path;
+        return nullptr;
+    }
+    auto& slot = g_warmScenarios[path];
+    if (!slot || slot->size != size || slot->mtimeNs != mtimeNs) {
+        auto warm = std::make_unique<WarmScenario>();
+        auto t0 = std::chrono::steady_clock::now();
+        if (!LoadScenarioCached(path, warm->scenario, &warm->graph)) {
+            g_warmScenarios.erase(path);
+            error = "cannot parse " + path;
+            return nullptr;
+        }
+        warm->size = size;
+        warm->mtimeNs = mtimeNs;
+        slot = std::move(warm);
+        std::cout << "[INFO] Loaded " << path << " (" << slot->scenario.nodes.size() << " nodes) in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count()
+                  << " ms" << std::endl;
+    }
+    if (withRoutingIndex && !slot->ch) {
+        bool rebuilt = false;
+        slot->ch = std::make_unique<ContractionHierarchy>(
+            LoadOrBuildContractionHierarchy(slot->graph, path + ".ch", &rebuilt));
+        std::cout << "[INFO] Routing index for " << path << (rebuilt ? " built" : " loaded") << std::endl;
+    }
+    return slot.get();
+}
+
+static std::string argOf(const ServerJob& job, const std::string& key)
+{
+    auto it = job.args.find(key);
+    return it == job.args.end() ? std::string() : it->second;
+}
+
+// ---------------------------------------------------------------------
+// Job execution (worker process)
+// ---------------------------------------------------------------------
+static std::string runRouteJob(const ServerJob& job)
+{
+    std::string error;
+    WarmScenario* warm = warmScenario(argOf(job, "scenario"), true, error);
+    if (!warm) return "error " + error;
+    uint32_t s = warm->graph.idOf(argOf(job, "from"));
+    uint32_t t = warm->graph.idOf(argOf(job, "to"));
+    if (s == kInvalidNode || t == kInvalidNode) return "error unknown node";
+
+    ChQueryWorkspace ws;
+    RouteAnswer answer;
+    if (!QueryContractionHierarchy(*warm->ch, s, t, ws, answer)) return "error no path";
+    std::string path;
+    for (uint32_t id : answer.path) {
+        if (!path.empty()) path += ',';
+        path += warm->graph.names[id];
+    }
+    return "ok cost=" + formatValue(answer.cost) + " hops=" + std::to_string(answer.path.size() - 1) +
+           " path=" + QuoteJobValue(path);
+}
+
+// Distance, radio and rate of tx -> rx as startSimulation() sets them up
+static bool makeLinkJob(const Scenario& scenario, const NodeConfig& tx, const std::string& rxName, LinkJob& link)
+{
+    const NodeConfig* rx = scenario.find(rxName);
+    if (!rx) return false;
+    double dx = tx.x - rx->x, dy = tx.y - rx->y, dz = tx.z - rx->z;
+    link.txName = tx.name;
+    link.rxName = rx->name;
+    link.distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    link.freqMHz = tx.freqMHz;
+    link.txPowerdBm = tx.txPowerBm;
+    link.rate = tx.txRate < rx->rxRate ? tx.txRate : rx->rxRate;
+    return true;
+}
+
+static std::string runLinkJob(const ServerJob& job)
+{
+    std::string error;
+    WarmScenario* warm = warmScenario(argOf(job, "scenario"), false, error);
+    if (!warm) return "error " + error;
+    const NodeConfig* tx = warm->scenario.find(argOf(job, "tx"));
+    LinkJob link;
+    if (!tx || !makeLinkJob(warm->scenario, *tx, argOf(job, "rx"), link)) return "error unknown node";
+
+    std::string run = argOf(job, "run");
+    if (!run.empty()) RngSeedManager::SetRun(std::stoull(run));
+    uint32_t traceId = traceLinkStart(link);
+    LinkResult r;
+    bool cached = false;
+    if (LinkResultCachingEnabled()) {
+        LinkResultCache cache;
+        cached = cache.Lookup(link, r);
+        if (!cached) {
+            r = simulateTransmission(link.distance, link.freqMHz, link.txPowerdBm, link.rate);
+            cache.Store(link, r);
+        } else {
+            TraceLinkResult(traceId, true, r.packetsSent, r.packetsReceived, r.meanRttMs);
+        }
+    } else {
+        r = simulateTransmission(link.distance, link.freqMHz, link.txPowerdBm, link.rate);
+    }
+    return "ok sent=" + std::to_string(r.packetsSent) + " received=" + std::to_string(r.packetsReceived) +
+           " rttMs=" + formatValue(r.meanRttMs) + " cached=" + (cached ? "1" : "0");
+}
+
+static std::string runScenarioJob(const ServerJob& job)
+{
+    std::string error;
+    WarmScenario* warm = warmScenario(argOf(job, "scenario"), false, error);
+    if (!warm) return "error " + error;
+    std::vector<LinkJob> links;
+    for (const NodeConfig& tx : warm->scenario.nodes) {
+        for (const std::string& rxName : tx.links) {
+            LinkJob link;
+            if (makeLinkJob(warm->scenario, tx, rxName, link)) links.push_back(link);
+        }
+    }
+    if (links.empty()) return "error no links";
+
+    std::string run = argOf(job, "run");
+    if (!run.empty()) RngSeedManager::SetRun(std::stoull(run));
+    std::vector<LinkResult> results = simulateScenario(warm->scenario.nodes, links);
+    uint64_t sent = 0, received = 0;
+    double rttSum = 0.0;
+    for (const LinkResult& r : results) {
+        sent += r.packetsSent;
+        received += r.packetsReceived;
+        rttSum += r.meanRttMs * r.packetsReceived;
+    }
+    return "ok links=" + std::to_string(links.size()) + " sent=" + std::to_string(sent) +
+           " received=" + std::to_string(received) +
+           " rttMs=" + formatValue(received > 0 ? rttSum / received : 0.0);
+}
+
+static std::string runCiJob(const ServerJob& job)
+{
+    // Job arguments become runLunarDtCI() options; no animation unless asked
+    std::vector<std::string> args{"lunar_dt_CI", "--animFile=none"};
+    for (const auto& kv : job.args) args.push_back("--" + kv.first + "=" + kv.second);
+    std::vector<char*> argv;
+    for (std::string& a : args) argv.push_back(a.data());
+
+    CiResult r;
+    if (runLunarDtCI(static_cast<int>(argv.size()), argv.data(), &r) != 0) return "error CI run failed";
+    return "ok numEnb=" + std::to_string(r.numEnb) + " numUe=" + std::to_string(r.numUe) +
+           " ueReports=" + std::to_string(r.ueReports) + " meanRsrpDbm=" + formatValue(r.meanRsrpDbm) +
+           " meanSinrDb=" + formatValue(r.meanSinrDb) + " p5SinrDb=" + formatValue(r.p5SinrDb) +
+           " minSinrDb=" + formatValue(r.minSinrDb);
+}
+
+// Parse and index a scenario for the server: the worker leaves the compiled
+// cache (<file>.ldtc) and, with index=1, the routing index (<file>.ch)
+// behind, which the server then only has to map
+static std::string runPrepareJob(const ServerJob& job)
+{
+    std::string error;
+    if (!warmScenario(argOf(job, "scenario"), argOf(job, "index") == "1", error)) return "error " + error;
+    return "ok";
+}
+
+static std::string runJob(const ServerJob& job)
+{
+    try {
+        if (job.kind == "prepare") return runPrepareJob(job);
+        if (job.kind == "route") return runRouteJob(job);
+        if (job.kind == "link") return runLinkJob(job);
+        if (job.kind == "scenario") return runScenarioJob(job);
+        if (job.kind == "ci") return runCiJob(job);
+        return "error unknown job kind " + job.kind;
+    } catch (const std::exception& e) {
+        return std::string("error ") + e.what();
+    }
+}
+
+// ---------------------------------------------------------------------
+// RunSimServer()
+// ---------------------------------------------------------------------
+static volatile sig_atomic_t g_serverStop = 0;
+
+static void onStopSignal(int)
+{
+    g_serverStop = 1;
+}
+
+static bool writeAllFd(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool isKnownJobKind(const std::string& kind)
+{
+    return kind == "route" || kind == "link" || kind == "scenario" || kind == "ci";
+}
+
+namespace {
+
+struct Connection {
+    int fd{-1};
+    std::string in, out;
+    size_t pending{};
+    bool inputClosed{false};
+};
+
+struct SpoolBatch {
+    std::string base;      // spool file path without ".job"
+    std::string replies;
+    size_t pending{};
+    bool sealed{false};    // all lines of the file have been queued
+};
+
+struct JobOrigin {
+    uint64_t connection{};   // 0 = spool
+    uint64_t batch{};
+    std::chrono::steady_clock::time_point accepted;
+};
+
+struct QueuedJob {
+    ServerJob job;
+    JobOrigin origin;
+    double timeoutS{};   // 0 = no limit
+};
+
+struct RunningJob {
+    pid_t pid;
+    int fd;
+    std::string reply;
+    QueuedJob queued;
+    std::chrono::steady_clock::time_point deadline;
+    bool timedOut{false};
+};
+
+// A scenario being parsed (and indexed) by a worker, and the jobs waiting
+// for it
+struct Preparation {
+    bool withIndex{};
+    std::vector<QueuedJob> waiting;
+};
+
+class SimServer {
+public:
+    explicit SimServer(const ServerOptions& options) : options_(options) {}
+    int run();
+
+private:
+    bool listen();
+    void acceptConnections();
+    void readConnection(uint64_t id, Connection& c);
+    void handleLine(const std::string& line, const JobOrigin& origin);
+    void dispatch(QueuedJob queued);
+    void prepareScenario(const std::string& path, bool withIndex);
+    void finishPreparation(const std::string& path, const std::string& error);
+    void reply(const JobOrigin& origin, const std::string& line);
+    void startJob(QueuedJob queued);
+    void finishJob(RunningJob& job);
+    void killOverdueJobs();
+    int msToNextDeadline() const;
+    void scanSpool();
+    void completeBatch(uint64_t id);
+
+    ServerOptions options_;
+    unsigned workers_{1};
+    int listenFd_{-1};
+    int logFd_{-1};
+    bool stopping_{false};
+    uint64_t nextId_{1};
+    uint64_t jobsDone_{};
+    std::chrono::steady_clock::time_point started_{std::chrono::steady_clock::now()};
+    std::map<uint64_t, Connection> connections_;
+    std::map<uint64_t, SpoolBatch> batches_;
+    std::deque<QueuedJob> queue_;
+    std::vector<RunningJob> running_;
+    std::map<std::string, Preparation> preparing_;
+};
+
+bool SimServer::listen()
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (options_.socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[ERROR] Socket path too long: " << options_.socketPath << '\n';
+        return false;
+    }
+    std::strcpy(addr.sun_path, options_.socketPath.c_str());
+
+    std::filesystem::path p(options_.socketPath);
+    std::error_code ec;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+
+    // A socket file nobody answers on is left over from an earlier server
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        close(probe);
+        std::cerr << "[ERROR] A server is already listening on " << options_.socketPath << '\n';
+        return false;
+    }
+    if (probe >= 0) close(probe);
+    unlink(options_.socketPath.c_str());
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0 || bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd_, 64) != 0) {
+        std::cerr << "[ERROR] Could not listen on " << options_.socketPath << ": " << std::strerror(errno) << '\n';
+        return false;
+    }
+    fcntl(listenFd_, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+void SimServer::acceptConnections()
+{
+    while (true) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        connections_[nextId_++].fd = fd;
+    }
+}
+
+void SimServer::readConnection(uint64_t id, Connection& c)
+{
+    char buf[65536];
+    while (true) {
+        ssize_t n = read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            c.in.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) c.inputClosed = true;
+        break;
+    }
+    size_t start = 0, end;
+    while ((end = c.in.find('\n', start)) != std::string::npos) {
+        std::string line = c.in.substr(start, end - start);
+        start = end + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        ++c.pending;
+        handleLine(line, {id, 0, std::chrono::steady_clock::now()});
+    }
+    c.in.erase(0, start);
+}
+
+void SimServer::handleLine(const std::string& line, const JobOrigin& origin)
+{
+    QueuedJob queued{ServerJob(), origin};
+    ServerJob& job = queued.job;
+    if (!ParseServerJob(line, job)) {
+        reply(origin, (job.id.empty() ? std::string("-") : job.id) + " error malformed request");
+        return;
+    }
+    if (job.kind == "ping") {
+        reply(origin, job.id + " ok");
+        return;
+    }
+    if (job.kind == "stats") {
+        double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+        size_t waiting = 0;
+        for (const auto& p : preparing_) waiting += p.second.waiting.size();
+        reply(origin, job.id + " ok done=" + std::to_string(jobsDone_) + " running=" +
+                          std::to_string(running_.size()) + " queued=" + std::to_string(queue_.size()) +
+                          " waiting=" + std::to_string(waiting) +
+                          " scenarios=" + std::to_string(g_warmScenarios.size()) +
+                          " uptimeS=" + formatValue(uptime));
+        return;
+    }
+    if (job.kind == "shutdown") {
+        stopping_ = true;
+        reply(origin, job.id + " ok");
+        return;
+    }
+    if (!isKnownJobKind(job.kind)) {
+        reply(origin, job.id + " error unknown job kind " + job.kind);
+        return;
+    }
+    if (stopping_) {
+        reply(origin, job.id + " error server is shutting down");
+        return;
+    }
+
+    if (job.kind != "ci" && argOf(job, "scenario").empty()) {
+        reply(origin, job.id + " error missing scenario=");
+        return;
+    }
+
+    queued.timeoutS = options_.jobTimeoutS;
+    auto timeout = job.args.find("timeout");
+    if (timeout != job.args.end()) {
+        try {
+            size_t used = 0;
+            double seconds = std::stod(timeout->second, &used);
+            if (used != timeout->second.size() || !(seconds >= 0.0)) throw std::invalid_argument("timeout");
+            queued.timeoutS = seconds;
+        } catch (const std::exception&) {
+            reply(origin, job.id + " error invalid timeout=" + QuoteJobValue(timeout->second));
+            return;
+        }
+        job.args.erase(timeout);
+    }
+    dispatch(std::move(queued));
+}
+
+// Scenario for path is in memory, current, and indexed if withIndex
+static bool scenarioWarm(const std::string& path, bool withIndex)
+{
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    auto it = g_warmScenarios.find(path);
+    return it != g_warmScenarios.end() && fileStamp(path, size, mtimeNs) && it->second->size == size &&
+           it->second->mtimeNs == mtimeNs && (!withIndex || it->second->ch);
+}
+
+// Queue a job whose scenario is in memory, so that its worker is forked
+// with it. Otherwise the job waits while a worker parses and indexes the
+// scenario; the server never does that work itself, so other clients are
+// not held up.
+void SimServer::dispatch(QueuedJob queued)
+{
+    if (queued.job.kind != "ci") {
+        std::string path = argOf(queued.job, "scenario");
+        bool withIndex = queued.job.kind == "route";
+        if (!scenarioWarm(path, withIndex)) {
+            prepareScenario(path, withIndex);
+            preparing_[path].waiting.push_back(std::move(queued));
+            return;
+        }
+    }
+    queue_.push_back(std::move(queued));
+}
+
+// Start a preparation job ahead of the queue, unless one for path is
+// already on its way; its waiters are dispatched again when it is done
+void SimServer::prepareScenario(const std::string& path, bool withIndex)
+{
+    auto [it, added] = preparing_.try_emplace(path);
+    if (!added) return;
+    it->second.withIndex = withIndex;
+    QueuedJob prepare{ServerJob(), JobOrigin{0, 0, std::chrono::steady_clock::now()}, options_.jobTimeoutS};
+    prepare.job.id = "-";
+    prepare.job.kind = "prepare";
+    prepare.job.args["scenario"] = path;
+    prepare.job.args["index"] = withIndex ? "1" : "0";
+    queue_.push_front(std::move(prepare));
+}
+
+void SimServer::finishPreparation(const std::string& path, const std::string& error)
+{
+    auto it = preparing_.find(path);
+    if (it == preparing_.end()) return;
+    Preparation done = std::move(it->second);
+    preparing_.erase(it);
+
+    // Maps the caches the worker wrote; a stale or unwritable cache makes
+    // this parse, as before
+    std::string loadError = error;
+    if (loadError.empty()) warmScenario(path, done.withIndex, loadError);
+    if (!loadError.empty()) {
+        std::cerr << "[WARNING] Could not prepare " << path << ": " << loadError << '\n';
+        for (QueuedJob& q : done.waiting) reply(q.origin, q.job.id + " error " + loadError);
+        return;
+    }
+    for (QueuedJob& q : done.waiting) dispatch(std::move(q));
+}
+
+void SimServer::reply(const JobOrigin& origin, const std::string& line)
+{
+    if (origin.connection) {
+        auto it = connections_.find(origin.connection);
+        if (it == connections_.end()) return;   // client went away
+        it->second.out += line;
+        it->second.out += '\n';
+        if (it->second.pending > 0) --it->second.pending;
+        return;
+    }
+    auto it = batches_.find(origin.batch);
+    if (it == batches_.end()) return;
+    it->second.replies += line;
+    it->second.replies += '\n';
+    if (--it->second.pending == 0 && it->second.sealed) completeBatch(origin.batch);
+}
+
+void SimServer::startJob(QueuedJob queued)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        reply(queued.origin, queued.job.id + " error could not create worker pipe");
+        return;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        reply(queued.origin, queued.job.id + " error could not fork worker");
+        return;
+    }
+    if (pid == 0) {
+        // Worker: console output goes to the server log, the reply down the pipe
+        close(fds[0]);
+        if (listenFd_ >= 0) close(listenFd_);
+        for (auto& c : connections_) close(c.second.fd);
+        for (RunningJob& r : running_) close(r.fd);
+        if (logFd_ >= 0) {
+            dup2(logFd_, STDOUT_FILENO);
+            dup2(logFd_, STDERR_FILENO);
+        }
+        TraceForkChild();
+        std::string result = runJob(queued.job);
+        StopTrace();
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        int status = writeAllFd(fds[1], result.data(), result.size()) ? 0 : 1;
+        close(fds[1]);
+        _exit(status);
+    }
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (queued.timeoutS > 0.0)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(queued.timeoutS));
+    running_.push_back({pid, fds[0], std::string(), std::move(queued), deadline});
+}
+
+// A killed worker's pipe closes, and finishJob() reports the timeout
+void SimServer::killOverdueJobs()
+{
+    auto now = std::chrono::steady_clock::now();
+    for (RunningJob& r : running_) {
+        if (r.timedOut || now < r.deadline) continue;
+        kill(r.pid, SIGKILL);
+        r.timedOut = true;
+    }
+}
+
+// poll() timeout until the next running job is due, -1 if none is
+int SimServer::msToNextDeadline() const
+{
+    auto next = std::chrono::steady_clock::time_point::max();
+    for (const RunningJob& r : running_)
+        if (!r.timedOut && r.deadline < next) next = r.deadline;
+    if (next == std::chrono::steady_clock::time_point::max()) return -1;
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(next - std::chrono::steady_clock::now()).count();
+    return static_cast<int>(std::clamp<long long>(ms, 0, 60000));
+}
+
+void SimServer::finishJob(RunningJob& job)
+{
+    int status = 0;
+    while (waitpid(job.pid, &status, 0) < 0 && errno == EINTR) {}
+    bool failed = !WIFEXITED(status) || WEXITSTATUS(status) != 0 || job.reply.empty();
+    std::string error = job.timedOut ? "timed out after " + formatValue(job.queued.timeoutS) + " s"
+                                     : "worker terminated abnormally";
+    if (job.queued.job.kind == "prepare") {
+        if (!failed && job.reply.compare(0, 6, "error ") == 0) error = job.reply.substr(6);
+        else if (!failed) error.clear();
+        finishPreparation(argOf(job.queued.job, "scenario"), error);
+        return;
+    }
+
+    ++jobsDone_;
+    std::string line = job.queued.job.id + " ";
+    if (failed) {
+        line += "error " + error;
+    } else {
+        line += job.reply;
+        if (job.reply.compare(0, 2, "ok") == 0) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                  job.queued.origin.accepted).count();
+            line += " ms=" + formatValue(ms);
+        }
+    }
+    reply(job.queued.origin, line);
+}
+
+void SimServer::scanSpool()
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(options_.spoolDir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".job") continue;
+        std::string path = entry.path().string();
+        std::string taken = path + ".taken";
+        if (rename(path.c_str(), taken.c_str()) != 0) continue;   // claimed by someone else
+
+        uint64_t id = nextId_++;
+        SpoolBatch& batch = batches_[id];
+        batch.base = path.substr(0, path.size() - 4);
+        std::ifstream in(taken);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            ++batches_[id].pending;
+            handleLine(line, {0, id, std::chrono::steady_clock::now()});
+        }
+        SpoolBatch& b = batches_[id];
+        b.sealed = true;
+        if (b.pending == 0) completeBatch(id);
+    }
+}
+
+void SimServer::completeBatch(uint64_t id)
+{
+    SpoolBatch& batch = batches_[id];
+    std::string part = batch.base + ".results.part";
+    {
+        std::ofstream out(part, std::ios::binary);
+        out << batch.replies;
+    }
+    rename(part.c_str(), (batch.base + ".results").c_str());
+    unlink((batch.base + ".job.taken").c_str());
+    batches_.erase(id);
+}
+
+int SimServer::run()
+{
+    workers_ = options_.workers ? options_.workers : DefaultWorkerCount();
+
+    std::filesystem::path logPath(options_.logPath);
+    std::error_code ec;
+    if (logPath.has_parent_path()) std::filesystem::create_directories(logPath.parent_path(), ec);
+    logFd_ = open(options_.logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (logFd_ < 0) std::cerr << "[WARNING] Could not open " << options_.logPath << "; worker output discarded.\n";
+
+    if (!listen()) return 1;
+    if (!options_.spoolDir.empty()) std::filesystem::create_directories(options_.spoolDir, ec);
+
+    for (const std::string& path : options_.preload) prepareScenario(path, true);
+
+    struct sigaction sa{};
+    sa.sa_handler = onStopSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "[INFO] Listening on " << options_.socketPath;
+    if (!options_.spoolDir.empty()) std::cout << ", spool " << options_.spoolDir;
+    std::cout << " (" << workers_ << " workers)" << std::endl;
+
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> owners;   // connection id, or 0 for the listener / job pipes
+    auto lastScan = std::chrono::steady_clock::time_point();
+    char buf[65536];
+
+    while (true) {
+        if (g_serverStop && !stopping_) {
+            size_t jobs = running_.size() + queue_.size();
+            for (const auto& p : preparing_) jobs += p.second.waiting.size();
+            std::cout << "[INFO] Stop requested; finishing " << jobs << " job(s)." << std::endl;
+            stopping_ = true;
+        }
+        if (stopping_ && listenFd_ >= 0) {
+            close(listenFd_);
+            listenFd_ = -1;
+            unlink(options_.socketPath.c_str());
+        }
+
+        while (running_.size() < workers_ && !queue_.empty()) {
+            QueuedJob next = std::move(queue_.front());
+            queue_.pop_front();
+            startJob(std::move(next));
+        }
+
+        // Drop clients that are done and drained
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            Connection& c = it->second;
+            if ((c.inputClosed || stopping_) && c.pending == 0 && c.out.empty()) {
+                close(c.fd);
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (stopping_ && running_.empty() && queue_.empty() && connections_.empty()) break;
+
+        if (!options_.spoolDir.empty() && !stopping_ &&
+            std::chrono::steady_clock::now() - lastScan > std::chrono::milliseconds(250)) {
+            scanSpool();
+            lastScan = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        fds.clear();
+        owners.clear();
+        if (listenFd_ >= 0) {
+            fds.push_back({listenFd_, POLLIN, 0});
+            owners.push_back(0);
+        }
+        for (auto& [id, c] : connections_) {
+            short events = c.inputClosed ? 0 : POLLIN;
+            if (!c.out.empty()) events |= POLLOUT;
+            fds.push_back({c.fd, events, 0});
+            owners.push_back(id);
+        }
+        size_t firstJob = fds.size();
+        for (RunningJob& r : running_) {
+            fds.push_back({r.fd, POLLIN, 0});
+            owners.push_back(0);
+        }
+
+        int timeoutMs = options_.spoolDir.empty() || stopping_ ? -1 : 250;
+        int deadlineMs = msToNextDeadline();
+        if (deadlineMs >= 0 && (timeoutMs < 0 || deadlineMs < timeoutMs)) timeoutMs = deadlineMs;
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] poll() failed: " << std::strerror(errno) << '\n';
+            break;
+        }
+        killOverdueJobs();
+
+        // Worker replies first; finishJob() may queue output for clients
+        std::vector<size_t> finished;
+        for (size_t k = firstJob; k < fds.size(); ++k) {
+            if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            RunningJob& r = running_[k - firstJob];
+            ssize_t n;
+            while ((n = read(r.fd, buf, sizeof(buf))) > 0) r.reply.append(buf, static_cast<size_t>(n));
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                finished.push_back(k - firstJob);
+        }
+        for (size_t i = finished.size(); i-- > 0;) {
+            RunningJob job = std::move(running_[finished[i]]);
+            running_.erase(running_.begin() + static_cast<std::ptrdiff_t>(finished[i]));
+            close(job.fd);
+            finishJob(job);
+        }
+
+        for (size_t k = 0; k < firstJob; ++k) {
+            if (!fds[k].revents) continue;
+            if (fds[k].fd == listenFd_ && owners[k] == 0) {
+                acceptConnections();
+                continue;
+            }
+            auto it = connections_.find(owners[k]);
+            if (it == connections_.end()) continue;
+            Connection& c = it->second;
+            if (fds[k].revents & (POLLIN | POLLHUP | POLLERR)) readConnection(it->first, c);
+            if (!c.out.empty()) {
+                ssize_t n = write(c.fd, c.out.data(), c.out.size());
+                if (n > 0) c.out.erase(0, static_cast<size_t>(n));
+                else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    // Client is gone; its remaining replies are dropped
+                    c.out.clear();
+                    c.pending = 0;
+                    c.inputClosed = true;
+                }
+            }
+        }
+    }
+
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(options_.socketPath.c_str());
+    }
+    if (logFd_ >= 0) close(logFd_);
+    std::cout << "[INFO] Server stopped after " << jobsDone_ << " job(s).\n";
+    return 0;
+}
+
+} // namespace
+
+int RunSimServer(const ServerOptions& options)
+{
+    // Warm the ns-3 side once (type lookups, attribute defaults, log
+    // components) so forked workers do not each pay for it
+    if (options.warmup) {
+        auto t0 = std::chrono::steady_clock::now();
+        simulateTransmission(10.0, 2400.0, 20.0, "1Mbps");
+        std::cout << "[INFO] Warm-up link run took "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count()
+                  << " ms" << std::endl;
+    }
+    SimServer server(options);
+    return server.run();
+}
+
+// ---------------------------------------------------------------------
+// RunSimClient()
+// ---------------------------------------------------------------------
+int RunSimClient(const std::string& socketPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[ERROR] Socket path too long: " << socketPath << '\n';
+        return 1;
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "[ERROR] No server on " << socketPath << '\n';
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Forward stdin until it ends, print replies until the server hangs up
+    bool inputOpen = true;
+    char buf[65536];
+    while (true) {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {STDIN_FILENO, static_cast<short>(inputOpen ? POLLIN : 0), 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) {
+            ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n > 0) {
+                if (!writeAllFd(fd, buf, static_cast<size_t>(n))) break;
+            } else if (n == 0 || errno != EINTR) {
+                inputOpen = false;
+                shutdown(fd, SHUT_WR);
+            }
+        }
+        if (fds[0].revents) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n > 0) {
+                std::cout.write(buf, n);
+                std::cout.flush();
+            } else if (n == 0 || errno != EINTR) {
+                break;
+            }
+        }
+    }
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Long-lived job server (scratch/LDT_server.cc). Parsed scenarios, their
+// routing graphs and contraction hierarchies stay in memory between jobs;
+// each job runs in a process forked from that warm state, so it starts
+// without re-reading or rebuilding anything. A scenario that is not in
+// memory yet (or changed on disk) is parsed and indexed by a worker first;
+// its jobs wait for it while the server keeps serving everyone else.
+//
+// Jobs are text lines, "<id> <kind> key=value ...", submitted on a Unix
+// socket or as *.job files in a spool directory:
+//
+//   <id> route    scenario=<file> from=<node> to=<node>
+//   <id> link     scenario=<file> tx=<node> rx=<node> [run=<rng run>]
+//   <id> scenario scenario=<file>
+//   <id> ci       [conf=<file>] [any runLunarDtCI option=value ...]
+//   <id> stats | ping | shutdown
+//
+// A value with blanks is written in double quotes, from="Shackleton rim";
+// inside them a backslash escapes the next character (\" or \\). Any job
+// takes timeout=<s> (0 = no limit) in place of the server's default; an
+// overdue worker is killed and the job fails.
+//
+// Every job gets exactly one reply line as soon as it finishes, in completion
+// order: "<id> ok key=value ... ms=<total>" or "<id> error <message>".
+// Reply values are quoted the same way.
+// Spooled x.job files are claimed by renaming them to x.job.taken; their
+// replies are collected in x.results once the last job is done.
+struct ServerOptions {
+    std::string socketPath{"./scratch/output/ldt_server.sock"};
+    std::string spoolDir;                                      // empty = no spool
+    std::string logPath{"./scratch/output/ldt_server.log"};    // worker console output
+    unsigned workers{0};                                       // 0 = all cores
+    bool warmup{true};                                         // one throw-away link run at start-up
+    double jobTimeoutS{600.0};                                 // per job, 0 = no limit
+    std::vector<std::string> preload;                          // scenarios loaded and indexed up front
+};
+
+struct ServerJob {
+    std::string id;
+    std::string kind;
+    std::unordered_map<std::string, std::string> args;
+};
+
+// Split a request line; false if it has no id and kind or a quote is open
+bool ParseServerJob(const std::string& line, ServerJob& job);
+
+// value as written in a job or reply line: quoted if it needs to be
+std::string QuoteJobValue(const std::string& value);
+
+// Serve until a shutdown job, SIGINT or SIGTERM; returns the exit code
+int RunSimServer(const ServerOptions& options);
+
+// Send the job lines read from stdin and print the replies as they arrive
+int RunSimClient(const std::string& socketPath);
@@ -0,0 +1,431 @@
+#include "terrain.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Below this Fresnel parameter the first Fresnel zone is clear enough that
+// knife-edge loss is zero
+static const double kNoLossV = -0.78;
+
+TerrainMap::~TerrainMap()
+{
+    for (Tile& tile : tiles_)
+        if (tile.data) munmap(const_cast<void*>(tile.data), tile.mappedBytes);
+}
+
+float TerrainMap::Tile::Sample(uint32_t col, uint32_t row) const
+{
+    size_t i = static_cast<size_t>(row) * width + col;
+    double raw;
+    if (int16) {
+        int16_t v;
+        std::memcpy(&v, static_cast<const char*>(data) + i * 2, 2);
+        raw = v;
+    } else {
+        float v;
+        std::memcpy(&v, static_cast<const char*>(data) + i * 4, 4);
+        raw = v;
+    }
+    if (hasNodata && raw == nodata) return -FLT_MAX;
+    return static_cast<float>(raw * scale + offset);
+}
+
+float TerrainMap::Tile::MaxAt(size_t level, uint32_t col, uint32_t row) const
+{
+    if (level == 0) return Sample(col, row);
+    const Level& l = levels[level - 1];
+    return l.maxHeight[static_cast<size_t>(row) * l.width + col];
+}
+
+bool TerrainMap::mapTile(Tile& tile)
+{
+    size_t bytes = static_cast<size_t>(tile.width) * tile.height * (tile.int16 ? 2 : 4);
+    int fd = open(tile.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[ERROR] Could not open DEM tile " << tile.path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < bytes) {
+        std::cerr << "[ERROR] DEM tile " << tile.path << " is smaller than " << tile.width << "x"
+                  << tile.height << (tile.int16 ? " int16" : " float32") << " pixels." << std::endl;
+        close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "[ERROR] Could not map DEM tile " << tile.path << std::endl;
+        return false;
+    }
+    tile.data = p;
+    tile.mappedBytes = bytes;
+    return true;
+}
+
+// Level 1 reads the raster in one sequential pass; every further level
+// halves the one below. Odd edges reuse the last row/column.
+void TerrainMap::buildPyramid(Tile& tile)
+{
+    madvise(const_cast<void*>(tile.data), tile.mappedBytes, MADV_SEQUENTIAL);
+    uint32_t w = tile.width, h = tile.height;
+    size_t level = 0;
+    while (w > 1 || h > 1) {
+        uint32_t pw = (w + 1) / 2, ph = (h + 1) / 2;
+        Tile::Level next{pw, ph, std::vector<float>(static_cast<size_t>(pw) * ph)};
+        for (uint32_t r = 0; r < ph; ++r) {
+            uint32_t r0 = 2 * r, r1 = std::min(2 * r + 1, h - 1);
+            for (uint32_t c = 0; c < pw; ++c) {
+                uint32_t c0 = 2 * c, c1 = std::min(2 * c + 1, w - 1);
+                next.maxHeight[static_cast<size_t>(r) * pw + c] =
+                    std::max(std::max(tile.MaxAt(level, c0, r0), tile.MaxAt(level, c1, r0)),
+                             std::max(tile.MaxAt(level, c0, r1), tile.MaxAt(level, c1, r1)));
+            }
+        }
+        tile.levels.push_back(std::move(next));
+        w = pw;
+        h = ph;
+        ++level;
+    }
+    madvise(const_cast<void*>(tile.data), tile.mappedBytes, MADV_RANDOM);
+}
+
+bool TerrainMap::Load(const std::string& descriptorPath)
+{
+    ScopedPhase phase("terrain_load");
+    std::ifstream in(descriptorPath);
+    if (!in.is_open()) {
+        std::cerr << "[ERROR] Could not open terrain descriptor " << descriptorPath << std::endl;
+        return false;
+    }
+    std::filesystem::path base = std::filesystem::path(descriptorPath).parent_path();
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword)) continue;
+
+        if (keyword == "HEIGHTS") {
+            std::string mode;
+            tokens >> mode;
+            if (mode != "above_ground" && mode != "absolute") {
+                std::cerr << "[ERROR] " << descriptorPath << ":" << lineNo
+                          << ": HEIGHTS must be above_ground or absolute." << std::endl;
+                return false;
+            }
+            aboveGround_ = mode == "above_ground";
+            continue;
+        }
+        if (keyword != "TILE") {
+            std::cerr << "[ERROR] " << descriptorPath << ":" << lineNo << ": unknown entry '" << keyword
+                      << "'." << std::endl;
+            return false;
+        }
+
+        std::unordered_map<std::string, std::string> kv;
+        std::string item;
+        while (tokens >> item) {
+            size_t eq = item.find('=');
+            if (eq != std::string::npos) kv[item.substr(0, eq)] = item.substr(eq + 1);
+        }
+        for (const char* required : {"file", "width", "height", "x0", "y0", "cell"}) {
+            if (!kv.count(required)) {
+                std::cerr << "[ERROR] " << descriptorPath << ":" << lineNo << ": TILE needs " << required
+                          << "=." << std::endl;
+                return false;
+            }
+        }
+
+        Tile tile;
+        try {
+            tile.path = (base / kv["file"]).string();
+            tile.width = static_cast<uint32_t>(std::stoul(kv["width"]));
+            tile.height = static_cast<uint32_t>(std::stoul(kv["height"]));
+            tile.x0 = std::stod(kv["x0"]);
+            tile.y0 = std::stod(kv["y0"]);
+            tile.cell = std::stod(kv["cell"]);
+            if (kv.count("scale")) tile.scale = std::stod(kv["scale"]);
+            if (kv.count("offset")) tile.offset = std::stod(kv["offset"]);
+            if (kv.count("nodata")) {
+                tile.hasNodata = true;
+                tile.nodata = std::stod(kv["nodata"]);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "[ERROR] " << descriptorPath << ":" << lineNo << ": invalid TILE value." << std::endl;
+            return false;
+        }
+        std::string type = kv.count("type") ? kv["type"] : "int16";
+        if ((type != "int16" && type != "float32") || tile.width == 0 || tile.height == 0 ||
+            !(tile.cell > 0.0)) {
+            std::cerr << "[ERROR] " << descriptorPath << ":" << lineNo
+                      << ": TILE needs type int16|float32, a non-empty size and cell > 0." << std::endl;
+            return false;
+        }
+        tile.int16 = type == "int16";
+
+        if (!mapTile(tile)) return false;
+        tiles_.push_back(std::move(tile));
+        buildPyramid(tiles_.back());
+    }
+
+    if (tiles_.empty()) {
+        std::cerr << "[ERROR] Terrain descriptor " << descriptorPath << " lists no tiles." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+double TerrainMap::HeightAt(double x, double y) const
+{
+    for (const Tile& tile : tiles_) {
+        double u = (x - tile.x0) / tile.cell;
+        double v = (tile.y0 - y) / tile.cell;
+        if (u < 0.0 || v < 0.0 || u >= tile.width || v >= tile.height) continue;
+        float h = tile.Sample(static_cast<uint32_t>(u), static_cast<uint32_t>(v));
+        return h == -FLT_MAX ? 0.0 : h;
+    }
+    return 0.0;
+}
+
+TerrainPoint TerrainMap::Resolve(const TerrainPoint& p) const
+{
+    return aboveGround_ ? TerrainPoint{p.x, p.y, p.z + HeightAt(p.x, p.y)} : p;
+}
+
+namespace {
+
+// Segment a -> b in the pixel grid of one tile, t in [0, 1]
+struct GridRay {
+    double u0, v0, du, dv;
+    double z0, dz;
+
+    double z(double t) const { return z0 + t * dz; }
+};
+
+// Visit, coarse to fine, the pyramid cells the ray crosses for t in
+// [t0, t1]. visit(level, maxHeight, tEnter, tExit) returns Descend to look
+// at the four children, Skip to move on, or Stop to end the walk. Returns
+// false if the walk was stopped.
+enum class Walk { Skip, Descend, Stop };
+
+template <class Tile, class Visit>
+bool walkLevel(const Tile& tile, const GridRay& ray, size_t level, uint32_t colLo, uint32_t colHi,
+               uint32_t rowLo, uint32_t rowHi, double t0, double t1, Visit& visit)
+{
+    const double s = std::ldexp(1.0, static_cast<int>(level));
+    // Start cell from a point just inside the span, clamped to the parent
+    double tStart = t0 + (t1 - t0) * 1e-9;
+    auto clampCell = [](double c, uint32_t lo, uint32_t hi) {
+        return c < lo ? lo : c > hi ? hi : static_cast<uint32_t>(c);
+    };
+    int64_t col = clampCell(std::floor((ray.u0 + tStart * ray.du) / s), colLo, colHi);
+    int64_t row = clampCell(std::floor((ray.v0 + tStart * ray.dv) / s), rowLo, rowHi);
+
+    const double inf = std::numeric_limits<double>::infinity();
+    int stepC = ray.du > 0 ? 1 : -1, stepR = ray.dv > 0 ? 1 : -1;
+    double tDeltaC = ray.du != 0.0 ? s / std::fabs(ray.du) : inf;
+    double tDeltaR = ray.dv != 0.0 ? s / std::fabs(ray.dv) : inf;
+    double tMaxC = ray.du != 0.0 ? ((col + (stepC > 0)) * s - ray.u0) / ray.du : inf;
+    double tMaxR = ray.dv != 0.0 ? ((row + (stepR > 0)) * s - ray.v0) / ray.dv : inf;
+
+    double tEnter = t0;
+    while (true) {
+        double tExit = std::min({tMaxC, tMaxR, t1});
+        if (tExit > tEnter) {
+            Walk w = visit(level, tile.MaxAt(level, static_cast<uint32_t>(col), static_cast<uint32_t>(row)),
+                           tEnter, tExit);
+            if (w == Walk::Stop) return false;
+            if (w == Walk::Descend && level > 0) {
+                uint32_t c0 = static_cast<uint32_t>(col) * 2, r0 = static_cast<uint32_t>(row) * 2;
+                const uint32_t childW = level > 1 ? tile.levels[level - 2].width : tile.width;
+                const uint32_t childH = level > 1 ? tile.levels[level - 2].height : tile.height;
+                if (!walkLevel(tile, ray, level - 1, c0, std::min(c0 + 1, childW - 1), r0,
+                               std::min(r0 + 1, childH - 1), tEnter, tExit, visit))
+                    return false;
+            }
+        }
+        if (tExit >= t1) return true;
+        if (tMaxC < tMaxR) {
+            col += stepC;
+            tEnter = tMaxC;
+            tMaxC += tDeltaC;
+            if (col < colLo || col > colHi) return true;
+        } else {
+            row += stepR;
+            tEnter = tMaxR;
+            tMaxR += tDeltaR;
+            if (row < rowLo || row > rowHi) return true;
+        }
+    }
+}
+
+} // namespace
+
+// Clip a -> b to each tile's extent (minus the half cell around either
+// endpoint) and walk its pyramid from the top
+template <class Tiles, class Visit>
+static bool walkTerrain(const Tiles& tiles, const TerrainPoint& a, const TerrainPoint& b, Visit& visit)
+{
+    double horizontal = std::hypot(b.x - a.x, b.y - a.y);
+    if (horizontal <= 0.0) return true;
+
+    for (const auto& tile : tiles) {
+        GridRay ray{(a.x - tile.x0) / tile.cell, (tile.y0 - a.y) / tile.cell, 0.0, 0.0, a.z, b.z - a.z};
+        ray.du = (b.x - tile.x0) / tile.cell - ray.u0;
+        ray.dv = (tile.y0 - b.y) / tile.cell - ray.v0;
+
+        double margin = std::min(0.5, 0.5 * tile.cell / horizontal);
+        double t0 = margin, t1 = 1.0 - margin;
+        auto clip = [&](double p0, double dp, double extent) {
+            if (dp == 0.0) {
+                if (p0 < 0.0 || p0 >= extent) t1 = -1.0;
+                return;
+            }
+            double ta = (0.0 - p0) / dp, tb = (extent - p0) / dp;
+            if (ta > tb) std::swap(ta, tb);
+            t0 = std::max(t0, ta);
+            t1 = std::min(t1, tb);
+        };
+        clip(ray.u0, ray.du, tile.width);
+        clip(ray.v0, ray.dv, tile.height);
+        if (!(t1 > t0)) continue;
+
+        size_t top = tile.levels.size();
+        if (!walkLevel(tile, ray, top, 0, 0, 0, 0, t0, t1, visit)) return false;
+    }
+    return true;
+}
+
+bool TerrainMap::LineOfSight(const TerrainPoint& a, const TerrainPoint& b) const
+{
+    auto visit = [&](size_t level, float maxHeight, double tEnter, double tExit) {
+        double rayLow = std::min(a.z + tEnter * (b.z - a.z), a.z + tExit * (b.z - a.z));
+        if (maxHeight <= rayLow) return Walk::Skip;
+        return level == 0 ? Walk::Stop : Walk::Descend;
+    };
+    return walkTerrain(tiles_, a, b, visit);
+}
+
+// Branch and bound on v = h sqrt(2 / (lambda D t (1 - t))): a block is only
+// opened if the highest v any pixel in it could reach beats the best edge
+// found so far, so the first Fresnel zone of a clear path prunes the walk
+// at the coarse levels.
+TerrainProfile TerrainMap::Profile(const TerrainPoint& a, const TerrainPoint& b, double wavelengthM) const
+{
+    TerrainProfile profile;
+    double dx = b.x - a.x, dy = b.y - a.y, dz = b.z - a.z;
+    double distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (distance <= 0.0 || !(wavelengthM > 0.0)) return profile;
+
+    const double k = std::sqrt(2.0 / (wavelengthM * distance));
+    double bestV = kNoLossV, bestT = 0.0;
+    auto vAt = [&](float maxHeight, double t) {
+        return (maxHeight - (a.z + t * dz)) * k / std::sqrt(t * (1.0 - t));
+    };
+    auto visit = [&](size_t level, float maxHeight, double tEnter, double tExit) {
+        if (level == 0) {
+            for (double t : {tEnter, 0.5 * (tEnter + tExit), tExit}) {
+                double v = vAt(maxHeight, t);
+                if (v > bestV) {
+                    bestV = v;
+                    bestT = t;
+                }
+            }
+            return Walk::Skip;
+        }
+        double h = std::max(maxHeight - (a.z + tEnter * dz), maxHeight - (a.z + tExit * dz));
+        double q;
+        if (h > 0.0) {
+            q = std::min(tEnter * (1.0 - tEnter), tExit * (1.0 - tExit));
+        } else {
+            double mid = std::clamp(0.5, tEnter, tExit);
+            q = mid * (1.0 - mid);
+        }
+        return h * k / std::sqrt(q) > bestV ? Walk::Descend : Walk::Skip;
+    };
+    walkTerrain(tiles_, a, b, visit);
+
+    profile.fresnelV = bestV;
+    profile.lineOfSight = bestV <= 0.0;
+    profile.obstacleDistanceM = bestT * distance;
+    profile.diffractionLossDb = KnifeEdgeLossDb(bestV);
+    return profile;
+}
+
+double KnifeEdgeLossDb(double v)
+{
+    if (v <= kNoLossV) return 0.0;
+    return 6.9 + 20.0 * std::log10(std::sqrt((v - 0.1) * (v - 0.1) + 1.0) + v - 0.1);
+}
+
+// Queries are handed out to threads in blocks of this many
+static const size_t kQueryBlock = 64;
+
+void TerrainProfileBatch(const TerrainMap& terrain, const std::vector<TerrainQuery>& queries,
+                         std::vector<TerrainProfile>& out, unsigned threads)
+{
+    ScopedPhase phase("terrain_batch");
+    out.assign(queries.size(), TerrainProfile());
+    size_t blocks = (queries.size() + kQueryBlock - 1) / kQueryBlock;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads > blocks) threads = static_cast<unsigned>(std::max<size_t>(blocks, 1));
+
+    std::atomic<size_t> nextBlock{0};
+    auto worker = [&]() {
+        for (size_t blk = nextBlock++; blk < blocks; blk = nextBlock++) {
+            size_t end = std::min(queries.size(), (blk + 1) * kQueryBlock);
+            for (size_t i = blk * kQueryBlock; i < end; ++i) {
+                const TerrainQuery& q = queries[i];
+                out[i] = terrain.Profile(terrain.Resolve(q.a), terrain.Resolve(q.b), q.wavelengthM);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    CountProfileEvent("terrain_queries", queries.size());
+}
+
+std::shared_ptr<const TerrainMap> LoadSharedTerrain(const std::string& descriptorPath)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const TerrainMap>> loaded;
+
+    std::error_code ec;
+    std::string key = std::filesystem::weakly_canonical(descriptorPath, ec).string();
+    if (ec) key = descriptorPath;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = loaded.find(key);
+    if (it != loaded.end()) return it->second;
+
+    auto terrain = std::make_shared<TerrainMap>();
+    if (!terrain->Load(descriptorPath)) return nullptr;
+    std::cout << "[INFO] Terrain " << descriptorPath << ": " << terrain->TileCount() << " tile(s) mapped"
+              << std::endl;
+    loaded.emplace(key, terrain);
+    return terrain;
+}
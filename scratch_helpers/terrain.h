@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Terrain occlusion from lunar DEM rasters. Each tile gets a max-height
+// pyramid (level k cell = max of a 2^k x 2^k block); rays are marched
+// top-down through it and only descend into blocks whose maximum reaches
+// the ray, so clear links touch a handful of cells.
+//
+// Load() reads every raster once, sequentially, to build the pyramids, which
+// stay in RAM: about a third of the pixel count in floats (2/3 of an int16
+// raster's size, 1/3 of a float32 one). The rasters themselves are
+// memory-mapped; after loading their clean pages can be evicted and are
+// only read back where rays descend to level 0.
+//
+// A terrain is described by a text file (*.dem):
+//
+//   # LOLA south-pole mosaic, 20 m posting
+//   HEIGHTS above_ground                      (or: absolute)
+//   TILE file=sp_0.img width=4096 height=4096 x0=-40960 y0=40960 cell=20 type=int16 scale=1 offset=0 nodata=-32768
+//
+// Tile files are raw little-endian rasters (int16 or float32), row 0 at the
+// top (largest y); x0/y0 is the top-left corner of the first pixel in the
+// scenario frame (metres), file paths are relative to the descriptor.
+// With HEIGHTS above_ground (the default) a node's z is its antenna height
+// over the terrain below it; with absolute, z is in the DEM's datum.
+// Pixels are flat-topped columns; nodata pixels never block.
+
+struct TerrainPoint {
+    double x, y, z;
+};
+
+// Dominant-obstacle summary of a path. Only terrain reaching into the
+// diffraction zone (v > -0.78) is considered; without any, v stays at -0.78.
+struct TerrainProfile {
+    bool lineOfSight{true};
+    double fresnelV{-0.78};     // Fresnel-Kirchhoff v of the dominant edge
+    double obstacleDistanceM{}; // from endpoint a to the dominant edge
+    double diffractionLossDb{}; // single knife-edge loss J(v)
+};
+
+struct TerrainQuery {
+    TerrainPoint a;             // endpoint heights as given (see HEIGHTS)
+    TerrainPoint b;
+    double wavelengthM{0.125};
+};
+
+class TerrainMap {
+public:
+    TerrainMap() = default;
+    ~TerrainMap();
+    TerrainMap(const TerrainMap&) = delete;
+    TerrainMap& operator=(const TerrainMap&) = delete;
+
+    // Map the tiles of a descriptor and build their pyramids
+    bool Load(const std::string& descriptorPath);
+
+    bool Empty() const { return tiles_.empty(); }
+    size_t TileCount() const { return tiles_.size(); }
+    bool HeightsAboveGround() const { return aboveGround_; }
+
+    // Terrain height under (x, y); 0 outside every tile or on nodata
+    double HeightAt(double x, double y) const;
+
+    // Absolute endpoint: applies the HEIGHTS convention to a node position
+    TerrainPoint Resolve(const TerrainPoint& p) const;
+
+    // Endpoints must already be resolved. The half cell around each
+    // endpoint is ignored so a node is never shadowed by its own pixel.
+    bool LineOfSight(const TerrainPoint& a, const TerrainPoint& b) const;
+    TerrainProfile Profile(const TerrainPoint& a, const TerrainPoint& b, double wavelengthM) const;
+
+private:
+    struct Tile {
+        std::string path;
+        uint32_t width{}, height{};
+        double x0{}, y0{}, cell{};
+        bool int16{true};
+        double scale{1.0}, offset{0.0};
+        bool hasNodata{};
+        double nodata{};
+        const void* data{};
+        size_t mappedBytes{};
+        // levels[k - 1] holds level k; level 0 is the mapped raster
+        struct Level {
+            uint32_t width, height;
+            std::vector<float> maxHeight;
+        };
+        std::vector<Level> levels;
+
+        float Sample(uint32_t col, uint32_t row) const;
+        float MaxAt(size_t level, uint32_t col, uint32_t row) const;
+    };
+
+    bool mapTile(Tile& tile);
+    static void buildPyramid(Tile& tile);
+
+    std::vector<Tile> tiles_;
+    bool aboveGround_{true};
+};
+
+// Knife-edge diffraction loss (ITU-R P.526 single edge), dB
+double KnifeEdgeLossDb(double v);
+
+// Resolve and profile every query, spread over threads (0 = all cores)
+void TerrainProfileBatch(const TerrainMap& terrain, const std::vector<TerrainQuery>& queries,
+                         std::vector<TerrainProfile>& out, unsigned threads = 0);
+
+// Descriptor loaded once per process and shared by every model using it;
+// nullptr if the file cannot be loaded
+std::shared_ptr<const TerrainMap> LoadSharedTerrain(const std::string& descriptorPath);
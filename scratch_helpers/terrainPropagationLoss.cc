@@ -0,0 +1,112 @@
+#include "terrainPropagationLoss.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(TerrainPropagationLossModel);
+
+TypeId TerrainPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::TerrainPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<TerrainPropagationLossModel>()
+            .AddAttribute("Inner",
+                          "The wrapped propagation loss model.",
+                          PointerValue(),
+                          MakePointerAccessor(&TerrainPropagationLossModel::m_inner),
+                          MakePointerChecker<PropagationLossModel>())
+            .AddAttribute("InnerType",
+                          "Type of the wrapped model when Inner is not set; its attributes "
+                          "come from the usual Config::SetDefault values.",
+                          TypeIdValue(FriisPropagationLossModel::GetTypeId()),
+                          MakeTypeIdAccessor(&TerrainPropagationLossModel::m_innerType),
+                          MakeTypeIdChecker())
+            .AddAttribute("TerrainFile",
+                          "Terrain descriptor (*.dem) loaded on first use.",
+                          StringValue(""),
+                          MakeStringAccessor(&TerrainPropagationLossModel::m_terrainFile),
+                          MakeStringChecker())
+            .AddAttribute("Frequency",
+                          "Carrier frequency (Hz) for the Fresnel-zone geometry.",
+                          DoubleValue(2.4e9),
+                          MakeDoubleAccessor(&TerrainPropagationLossModel::m_frequencyHz),
+                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+TerrainPropagationLossModel::TerrainPropagationLossModel()
+{
+}
+
+void TerrainPropagationLossModel::SetInner(Ptr<PropagationLossModel> inner)
+{
+    m_inner = inner;
+}
+
+void TerrainPropagationLossModel::SetTerrain(std::shared_ptr<const TerrainMap> terrain)
+{
+    terrain_ = std::move(terrain);
+    terrainLoaded_ = true;
+}
+
+void TerrainPropagationLossModel::DoDispose()
+{
+    m_inner = nullptr;
+    terrain_.reset();
+    PropagationLossModel::DoDispose();
+}
+
+double TerrainPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                                  Ptr<MobilityModel> a,
+                                                  Ptr<MobilityModel> b) const
+{
+    if (!m_inner) {
+        ObjectFactory factory;
+        factory.SetTypeId(m_innerType);
+        const_cast<TerrainPropagationLossModel*>(this)->m_inner = factory.Create<PropagationLossModel>();
+    }
+    if (!terrainLoaded_) {
+        if (!m_terrainFile.empty()) terrain_ = LoadSharedTerrain(m_terrainFile);
+        terrainLoaded_ = true;
+    }
+
+    double rx = m_inner->CalcRxPower(txPowerDbm, a, b);
+    if (!terrain_) return rx;
+
+    Vector pa = a->GetPosition();
+    Vector pb = b->GetPosition();
+    TerrainProfile profile = terrain_->Profile(terrain_->Resolve({pa.x, pa.y, pa.z}),
+                                               terrain_->Resolve({pb.x, pb.y, pb.z}),
+                                               299792458.0 / m_frequencyHz);
+    return rx - profile.diffractionLossDb;
+}
+
+int64_t TerrainPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return m_inner ? m_inner->AssignStreams(stream) : 0;
+}
+
+} // namespace ns3
+
+ns3::Ptr<ns3::PropagationLossModel> MakeTerrainLossModel(ns3::Ptr<ns3::PropagationLossModel> model,
+                                                         const std::string& terrainFile, double frequencyHz)
+{
+    ns3::Ptr<ns3::TerrainPropagationLossModel> terrain = ns3::CreateObject<ns3::TerrainPropagationLossModel>();
+    terrain->SetInner(model);
+    terrain->SetAttribute("TerrainFile", ns3::StringValue(terrainFile));
+    terrain->SetAttribute("Frequency", ns3::DoubleValue(frequencyHz));
+    return terrain;
+}
+
+static ns3::GlobalValue g_terrainFile("LdtTerrain",
+                                      "Terrain descriptor (*.dem) applied to the lunar link simulations",
+                                      ns3::StringValue(""),
+                                      ns3::MakeStringChecker());
+
+std::string TerrainFileSetting()
+{
+    ns3::StringValue value;
+    g_terrainFile.GetValue(value);
+    return value.Get();
+}
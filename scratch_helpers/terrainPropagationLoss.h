@@ -0,0 +1,49 @@
+#pragma once
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include <memory>
+#include <string>
+#include "terrain.h"
+
+namespace ns3 {
+
+// Propagation loss model that adds the knife-edge diffraction loss of the
+// dominant terrain obstacle (terrain.h) to another model's result. Node
+// positions are taken in the frame of the terrain descriptor. The terrain
+// is shared between all models loading the same file.
+class TerrainPropagationLossModel : public PropagationLossModel {
+public:
+    static TypeId GetTypeId();
+
+    TerrainPropagationLossModel();
+
+    // Wrapped model; if unset, one of type InnerType is created on first use
+    void SetInner(Ptr<PropagationLossModel> inner);
+    void SetTerrain(std::shared_ptr<const TerrainMap> terrain);
+
+protected:
+    void DoDispose() override;
+
+private:
+    double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    Ptr<PropagationLossModel> m_inner;
+    TypeId m_innerType;
+    std::string m_terrainFile;
+    double m_frequencyHz;
+    mutable std::shared_ptr<const TerrainMap> terrain_;
+    mutable bool terrainLoaded_{false};
+};
+
+} // namespace ns3
+
+// Wrap model so that it also pays the terrain's diffraction loss
+ns3::Ptr<ns3::PropagationLossModel> MakeTerrainLossModel(ns3::Ptr<ns3::PropagationLossModel> model,
+                                                         const std::string& terrainFile, double frequencyHz);
+
+// Terrain descriptor used by the ns-3 link simulations, settable with
+// NS_GLOBAL_VALUE="LdtTerrain=scratch/config/terrain/south_pole.dem";
+// empty when terrain is off
+std::string TerrainFileSetting();
@@ -0,0 +1,240 @@
+#include "workerPool.h"
+#include "profiler.h"
+#include "binaryTrace.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+unsigned DefaultWorkerCount()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+static void flushAllStreams()
+{
+    std::cout.flush();
+    std::cerr.flush();
+    std::clog.flush();
+    fflush(nullptr);
+}
+
+static bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Strip the worker's profile trailer off a result and merge it
+static bool splitProfile(std::string& payload)
+{
+    uint64_t payloadSize = 0;
+    if (payload.size() < sizeof(payloadSize)) return false;
+    std::memcpy(&payloadSize, payload.data() + payload.size() - sizeof(payloadSize), sizeof(payloadSize));
+    size_t profileEnd = payload.size() - sizeof(payloadSize);
+    if (payloadSize > profileEnd) return false;
+    MergeProfile(std::string_view(payload).substr(payloadSize, profileEnd - payloadSize));
+    payload.resize(payloadSize);
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// RunWorkerPool()
+// ---------------------------------------------------------------------
+void RunWorkerPool(size_t count, unsigned maxWorkers,
+                   const std::function<std::string(size_t)>& job,
+                   const std::function<void(size_t, const WorkerJobOutput&)>& onComplete)
+{
+    std::vector<WorkerJobOutput> outputs(count);
+    std::vector<bool> done(count, false);
+    size_t nextToEmit = 0;
+
+    // Hand finished jobs to the caller strictly in index order
+    auto emitReady = [&]() {
+        while (nextToEmit < count && done[nextToEmit]) {
+            onComplete(nextToEmit, outputs[nextToEmit]);
+            outputs[nextToEmit] = WorkerJobOutput();
+            ++nextToEmit;
+        }
+    };
+
+    // Sequential mode: run in-process, output goes straight to the console.
+    // A job that throws fails like a worker would.
+    if (maxWorkers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            try {
+                outputs[i].payload = job(i);
+                outputs[i].ok = true;
+            } catch (const std::exception& e) {
+                outputs[i].payload.clear();
+                outputs[i].log = "[ERROR] Worker job " + std::to_string(i) + " failed: " + e.what() + '\n';
+            }
+            done[i] = true;
+            emitReady();
+        }
+        return;
+    }
+
+    struct Worker {
+        pid_t pid;
+        size_t index;
+        int logFd;
+        int resultFd;
+    };
+    std::vector<Worker> active;
+    size_t nextJob = 0;
+
+    auto spawn = [&](size_t index) {
+        int logPipe[2], resultPipe[2];
+        if (pipe(logPipe) != 0) {
+            outputs[index].log = "[ERROR] Could not create worker pipe.\n";
+            done[index] = true;
+            return;
+        }
+        if (pipe(resultPipe) != 0) {
+            close(logPipe[0]); close(logPipe[1]);
+            outputs[index].log = "[ERROR] Could not create worker pipe.\n";
+            done[index] = true;
+            return;
+        }
+
+        flushAllStreams();
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(logPipe[0]); close(logPipe[1]);
+            close(resultPipe[0]); close(resultPipe[1]);
+            outputs[index].log = "[ERROR] Could not fork worker process.\n";
+            done[index] = true;
+            return;
+        }
+
+        if (pid == 0) {
+            // Worker: capture console output, run the job, ship the payload back
+            for (const Worker& w : active) {
+                if (w.logFd >= 0) close(w.logFd);
+                if (w.resultFd >= 0) close(w.resultFd);
+            }
+            close(logPipe[0]);
+            close(resultPipe[0]);
+            dup2(logPipe[1], STDOUT_FILENO);
+            dup2(logPipe[1], STDERR_FILENO);
+            close(logPipe[1]);
+
+            // Phase samples taken in the worker travel after the payload,
+            // followed by the payload length
+            ResetProfile();
+            // Trace records of the worker go to its own <file>.<pid>
+            TraceForkChild();
+            int status = 0;
+            try {
+                std::string payload = job(index);
+                uint64_t payloadSize = payload.size();
+                payload += SerializeProfile();
+                payload.append(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+                flushAllStreams();
+                if (!writeAll(resultPipe[1], payload.data(), payload.size())) status = 1;
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Worker job " << index << " failed: " << e.what() << '\n';
+                status = 1;
+            }
+            flushAllStreams();
+            close(resultPipe[1]);
+            StopTrace();
+            _exit(status);
+        }
+
+        close(logPipe[1]);
+        close(resultPipe[1]);
+        active.push_back({pid, index, logPipe[0], resultPipe[0]});
+    };
+
+    std::vector<pollfd> fds;
+    std::vector<int*> fdOwners;
+    char buf[65536];
+
+    while (nextToEmit < count) {
+        while (active.size() < maxWorkers && nextJob < count)
+            spawn(nextJob++);
+        emitReady();
+        if (active.empty()) continue;
+
+        fds.clear();
+        fdOwners.clear();
+        for (Worker& w : active) {
+            if (w.logFd >= 0) { fds.push_back({w.logFd, POLLIN, 0}); fdOwners.push_back(&w.logFd); }
+            if (w.resultFd >= 0) { fds.push_back({w.resultFd, POLLIN, 0}); fdOwners.push_back(&w.resultFd); }
+        }
+
+        if (!fds.empty() && poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] poll() failed while waiting for workers.\n";
+            // Stop the running workers and report every unfinished job as
+            // failed, so the caller still sees each index exactly once
+            for (Worker& w : active) {
+                kill(w.pid, SIGKILL);
+                if (w.logFd >= 0) close(w.logFd);
+                if (w.resultFd >= 0) close(w.resultFd);
+                while (waitpid(w.pid, nullptr, 0) < 0 && errno == EINTR) {}
+            }
+            active.clear();
+            for (size_t i = nextToEmit; i < count; ++i) {
+                if (done[i]) continue;
+                outputs[i].ok = false;
+                outputs[i].payload.clear();
+                outputs[i].log += "[ERROR] Job " + std::to_string(i) + " abandoned after poll() failed.\n";
+                done[i] = true;
+            }
+            emitReady();
+            return;
+        }
+
+        for (size_t k = 0; k < fds.size(); ++k) {
+            if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            int* fd = fdOwners[k];
+            ssize_t n = read(*fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n > 0) {
+                for (Worker& w : active) {
+                    if (&w.logFd == fd) outputs[w.index].log.append(buf, static_cast<size_t>(n));
+                    else if (&w.resultFd == fd) outputs[w.index].payload.append(buf, static_cast<size_t>(n));
+                }
+                continue;
+            }
+            close(*fd);
+            *fd = -1;
+        }
+
+        // Reap workers whose pipes are both closed
+        for (size_t k = 0; k < active.size();) {
+            Worker& w = active[k];
+            if (w.logFd >= 0 || w.resultFd >= 0) { ++k; continue; }
+            int status = 0;
+            while (waitpid(w.pid, &status, 0) < 0 && errno == EINTR) {}
+            bool exitedCleanly = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if (exitedCleanly && !splitProfile(outputs[w.index].payload)) exitedCleanly = false;
+            outputs[w.index].ok = exitedCleanly;
+            if (!exitedCleanly)
+                outputs[w.index].log += "[ERROR] Worker for job " + std::to_string(w.index) +
+                                        " terminated abnormally.\n";
+            done[w.index] = true;
+            active.erase(active.begin() + static_cast<std::ptrdiff_t>(k));
+        }
+        emitReady();
+    }
+}
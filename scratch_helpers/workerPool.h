@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+// Output of one job executed by RunWorkerPool()
+struct WorkerJobOutput {
+    bool ok{false};        // job finished and delivered its payload
+    std::string payload;   // bytes returned by the job
+    std::string log;       // stdout/stderr captured from the worker process
+};
+
+// Runs job(i) for every i in [0, count). With maxWorkers > 1 each job runs in
+// its own forked process (the ns-3 simulator is a per-process singleton), at
+// most maxWorkers at a time. onComplete(i, output) is always called in index
+// order, so console output is identical for any worker count.
+void RunWorkerPool(size_t count, unsigned maxWorkers,
+                   const std::function<std::string(size_t)>& job,
+                   const std::function<void(size_t, const WorkerJobOutput&)>& onComplete);
+
+// Number of hardware threads, at least 1
+unsigned DefaultWorkerCount();
+
+// Helpers to move plain-data results through the pool
+template <typename T>
+std::string PackWorkerResult(const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "worker results must be plain data");
+    return std::string(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool UnpackWorkerResult(const std::string& payload, T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "worker results must be plain data");
+    if (payload.size() != sizeof(T)) return false;
+    std::memcpy(&value, payload.data(), sizeof(T));
+    return true;
+}